@@ -18,6 +18,9 @@ void usage() {
   std::cerr << "  --out, -o DIR          Specify root output directory.\n";
   std::cerr << "  --modulepath, -m PATH  Add path to module search path.\n";
   std::cerr << "  --sourceroot, -s PATH  Root directory for input sources.\n";
+  std::cerr << "  --jobs, -j N           Parse sources on N threads (0 = one per CPU).\n";
+  std::cerr << "  --stats-ast            Print AST node counts and sizes by kind.\n";
+  std::cerr << "  --stats-memory         Print arena memory use by arena kind and by module.\n";
   exit(-1);
 }
 
@@ -37,7 +40,7 @@ public:
       } else if (arg.startsWith("--")) {
         StringRef opt = arg.substr(2);
         if (opt == "version") {
-          std::cerr << "cspark version 0.1.\n";
+          std::cerr << "cspark version " << Compiler::version() << ".\n";
           exit(0);
         } else if (opt == "out") {
           setOutputDir(nextArg(i));
@@ -45,6 +48,12 @@ public:
           _compiler.addModulePath(nextArg(i));
         } else if (opt == "sourceroot") {
           setSourceRoot(nextArg(i));
+        } else if (opt == "jobs") {
+          setJobs(nextArg(i));
+        } else if (opt == "stats-ast") {
+          _compiler.setAstStats(true);
+        } else if (opt == "stats-memory") {
+          _compiler.setMemoryStats(true);
         } else {
           std::cerr << "Unknown option: " << arg << "\n";
           usage();
@@ -52,7 +61,7 @@ public:
       } else if (arg.startsWith("-")) {
         StringRef opt = arg.substr(1);
         if (opt == "v") {
-          std::cerr << "cspark version 0.1.\n";
+          std::cerr << "cspark version " << Compiler::version() << ".\n";
           exit(0);
         } else if (opt == "m") {
           _compiler.addModulePath(nextArg(i));
@@ -60,6 +69,8 @@ public:
           setSourceRoot(nextArg(i));
         } else if (opt == "o") {
           setOutputDir(nextArg(i));
+        } else if (opt == "j") {
+          setJobs(nextArg(i));
         } else {
           std::cerr << "Unknown option: " << arg << "\n";
           usage();
@@ -109,6 +120,22 @@ private:
     _compiler.setSourceRoot(dir);
   }
 
+  void setJobs(StringRef value) {
+    unsigned jobs = 0;
+    if (value.empty()) {
+      std::cerr << "Invalid job count ''.\n";
+      usage();
+    }
+    for (char ch : value) {
+      if (ch < '0' || ch > '9' || jobs > 9999) {
+        std::cerr << "Invalid job count '" << value << "'.\n";
+        usage();
+      }
+      jobs = jobs * 10 + (ch - '0');
+    }
+    _compiler.setJobs(jobs);
+  }
+
   StringRef nextArg(int& i) {
     ++i;
     if (i < _argCount) {
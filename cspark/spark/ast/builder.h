@@ -21,6 +21,10 @@
   #include "spark/support/arena.h"
 #endif
 
+#ifndef SPARK_SUPPORT_SCRATCHSTACK_H
+  #include "spark/support/scratchstack.h"
+#endif
+
 #if SPARK_HAVE_CASSERT
   #include <cassert>
 #endif
@@ -30,44 +34,63 @@ namespace ast {
 using spark::source::Location;
 using spark::collections::ArrayRef;
 
-/** Helper for building node lists in an arena. */
+/** Helper for building node lists in an arena. Nodes are accumulated on the thread's scratch
+    stack, and copied into the arena by build(). */
 class NodeListBuilder {
 public:
-  NodeListBuilder(support::Arena& arena) : _arena(arena) {}
+  NodeListBuilder(support::Arena& arena) : _arena(arena), _size(0) {}
+  NodeListBuilder(const NodeListBuilder&) = delete;
+
+  NodeListBuilder& operator=(const NodeListBuilder&) = delete;
+
   NodeListBuilder& append(Node* n) {
-    _nodes.push_back(n);
+    if ((_size + 1) * sizeof(Node*) > _buffer.capacity()) {
+      _buffer.reserve(_size * sizeof(Node*), (_size + 1) * sizeof(Node*));
+    }
+    nodes()[_size++] = n;
     return *this;
   }
 
   size_t size() const {
-    return _nodes.size();
+    return _size;
   }
 
   /** Return a location which spans all of the nodes. */
   Location location() const {
     Location loc;
-    for (Node* n : _nodes) {
-      loc |= n->location();
+    for (size_t i = 0; i < _size; ++i) {
+      loc |= nodes()[i]->location();
     }
     return loc;
   }
 
   Node* operator[](int index) const {
-    return _nodes[index];
+    return nodes()[index];
+  }
+
+  /** The nodes appended so far. This refers to the builder's own storage, so it is only valid
+      until the next call to append(). */
+  ArrayRef<const Node*> contents() const {
+    return ArrayRef<const Node*>(nodes(), _size);
   }
 
   ArrayRef<const Node*> build() const {
-    if (_nodes.empty()) {
+    if (_size == 0) {
       return ArrayRef<const Node*>();
     }
-    Node** data = reinterpret_cast<Node**>(_arena.allocate(sizeof(Node*) * _nodes.size()));
-    ArrayRef<const Node*> result(data, _nodes.size());
-    std::copy(_nodes.begin(), _nodes.end(), data);
-    return result;
+    if (NodeStats::isEnabled()) {
+      NodeStats::addList(sizeof(Node*) * _size);
+    }
+    Node** data = reinterpret_cast<Node**>(_arena.allocate(sizeof(Node*) * _size));
+    std::copy(nodes(), nodes() + _size, data);
+    return ArrayRef<const Node*>(data, _size);
   }
 private:
   support::Arena& _arena;
-  std::vector<Node*> _nodes;
+  support::ScratchBuffer _buffer;
+  size_t _size;
+
+  Node** nodes() const { return reinterpret_cast<Node**>(_buffer.data()); }
 };
 
 }}
@@ -9,21 +9,27 @@
   #include "spark/ast/node.h"
 #endif
 
-#ifndef SPARK_COLLECTIONS_STRINGREF_H
-  #include "spark/collections/stringref.h"
+#ifndef SPARK_COLLECTIONS_ATOM_H
+  #include "spark/collections/atom.h"
 #endif
 
 namespace spark {
 namespace common {
 class DocComment;
 }
+namespace source {
+class ProgramSource;
+}
+namespace support {
+class Arena;
+}
 namespace ast {
-using spark::collections::StringRef;
+using spark::collections::Atom;
 
 /** Base for all definitions. */
 class Defn : public Node {
 public:
-  Defn(Kind kind, const Location& location, const StringRef& name)
+  Defn(Kind kind, const Location& location, Atom name)
     : Node(kind, location)
     , _name(name)
     , _docComment(nullptr)
@@ -37,7 +43,7 @@ public:
   {}
 
   /** The name of this definition. */
-  StringRef name() const { return _name; }
+  Atom name() const { return _name; }
 
   /** The list of members of this definition. */
   const NodeList& members() const { return _members; }
@@ -88,25 +94,25 @@ public:
   void setAbstract(bool value) { _abstract = value; }
 
 private:
-  StringRef _name;
+  Atom _name;
   NodeList _members;
   NodeList _attributes;
   NodeList _typeParams;
   NodeList _requires;
   common::DocComment* _docComment;
 
-  bool _private;
-  bool _protected;
-  bool _static;
-  bool _override;
-  bool _undef;
-  bool _final;
-  bool _abstract;
+  bool _private : 1;
+  bool _protected : 1;
+  bool _static : 1;
+  bool _override : 1;
+  bool _undef : 1;
+  bool _final : 1;
+  bool _abstract : 1;
 };
 
 class TypeDefn : public Defn {
 public:
-  TypeDefn(Kind kind, const Location& location, const StringRef& name)
+  TypeDefn(Kind kind, const Location& location, Atom name)
     : Defn(kind, location, name)
   {}
 
@@ -125,7 +131,7 @@ private:
 /** Base for all vars, lets, enum values and parameters. */
 class ValueDefn : public Defn {
 public:
-  ValueDefn(Kind kind, const Location& location, const StringRef& name)
+  ValueDefn(Kind kind, const Location& location, Atom name)
     : Defn(kind, location, name)
     , _type(nullptr)
     , _init(nullptr)
@@ -146,8 +152,9 @@ private:
 
 class EnumValue : public ValueDefn {
 public:
-  EnumValue(const Location& location, const StringRef& name)
+  EnumValue(const Location& location, Atom name)
     : ValueDefn(Kind::ENUM_VALUE, location, name)
+    , _ordinal(0)
   {}
 
   int32_t ordinal() const { return _ordinal; }
@@ -158,8 +165,13 @@ private:
 
 class Parameter : public ValueDefn {
 public:
-  Parameter(const Location& location, const StringRef& name)
+  Parameter(const Location& location, Atom name)
     : ValueDefn(Kind::PARAMETER, location, name)
+    , _keywordOnly(false)
+    , _selfParam(false)
+    , _classParam(false)
+    , _variadic(false)
+    , _expansion(false)
   {}
 
   /** Indicates a keyword-only parameter. */
@@ -182,12 +194,12 @@ public:
   bool isClassParam() const { return _classParam; }
   void setClassParam(bool classParam) { _classParam = classParam; }
 private:
-  bool _keywordOnly;
-  bool _selfParam;
-  bool _classParam;
-//   bool _mutable;
-  bool _variadic;
-  bool _expansion;
+  bool _keywordOnly : 1;
+  bool _selfParam : 1;
+  bool _classParam : 1;
+//   bool _mutable : 1;
+  bool _variadic : 1;
+  bool _expansion : 1;
 };
 
 // class Parameter(ValueDefn):
@@ -196,7 +208,7 @@ private:
 
 class TypeParameter : public Defn {
 public:
-  TypeParameter(const Location& location, const StringRef& name)
+  TypeParameter(const Location& location, Atom name)
     : Defn(Kind::TYPE_PARAMETER, location, name)
     , _type(nullptr)
     , _init(nullptr)
@@ -224,16 +236,50 @@ private:
   NodeList _subtypeConstraints;
 };
 
+/** A function body that was skipped over by the parser. The location spans the body from the
+    opening brace to the closing brace; the body is parsed from the source the first time that
+    it is needed (see Parser::parseDeferredBody()), and the result is saved here. */
+class DeferredBody : public Node {
+public:
+  DeferredBody(const Location& location, source::ProgramSource* source, support::Arena& arena)
+    : Node(Kind::DEFERRED_BODY, location)
+    , _source(source)
+    , _arena(arena)
+    , _body(nullptr)
+    , _parsed(false)
+  {}
+
+  /** Source file containing the body. */
+  source::ProgramSource* source() const { return _source; }
+
+  /** Arena in which the body's nodes are to be allocated. */
+  support::Arena& arena() const { return _arena; }
+
+  /** The parsed body, once parsing has been done. Null if the body had errors. */
+  const Node* body() const { return _body; }
+  bool isParsed() const { return _parsed; }
+  void setBody(const Node* body) const {
+    _body = body;
+    _parsed = true;
+  }
+
+private:
+  source::ProgramSource* _source;
+  support::Arena& _arena;
+  mutable const Node* _body;
+  mutable bool _parsed;
+};
+
 class Function : public Defn {
 public:
-  Function(const Location& location, const StringRef& name)
+  Function(const Location& location, Atom name)
     : Defn(Kind::FUNCTION, location, name)
     , _returnType(nullptr)
     , _body(nullptr)
+    , _selfType(nullptr)
     , _constructor(false)
     , _requirement(false)
     , _native(false)
-    , _selfType(nullptr)
   {}
 
   /** Type of this defn. */
@@ -267,15 +313,15 @@ private:
   const Node* _returnType;
   NodeList _params;
   const Node* _body;
-  bool _constructor;
-  bool _requirement;
-  bool _native;
   const Node* _selfType;
+  bool _constructor : 1;
+  bool _requirement : 1;
+  bool _native : 1;
 };
 
 class Property : public Defn {
 public:
-  Property(const Location& location, const StringRef& name)
+  Property(const Location& location, Atom name)
     : Defn(Kind::PROPERTY, location, name)
     , _type(nullptr)
     , _getter(nullptr)
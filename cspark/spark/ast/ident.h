@@ -9,29 +9,29 @@
   #include "spark/ast/node.h"
 #endif
 
-#ifndef SPARK_COLLECTIONS_STRINGREF_H
-  #include "spark/collections/stringref.h"
+#ifndef SPARK_COLLECTIONS_ATOM_H
+  #include "spark/collections/atom.h"
 #endif
 
 namespace spark {
 namespace ast {
-using spark::collections::StringRef;
+using spark::collections::Atom;
 
 /** Node type representing an identifier. */
 class Ident : public Node {
 public:
 
   /** Construct an Ident node. */
-  Ident(const Location& location, StringRef name)
+  Ident(const Location& location, Atom name)
     : Node(Kind::IDENT, location)
     , _name(name)
   {}
 
   /** The text of this identifier. */
-  const StringRef& name() const { return _name; }
+  Atom name() const { return _name; }
 
 private:
-  const StringRef _name;
+  const Atom _name;
 };
 
 /** Node type representing a member reference. */
@@ -39,20 +39,20 @@ class MemberRef : public Node {
 public:
 
   /** Construct a Member node. */
-  MemberRef(const Location& location, StringRef name, Node* base)
+  MemberRef(const Location& location, Atom name, Node* base)
     : Node(Kind::MEMBER, location)
     , _name(name)
     , _base(base)
   {}
 
   /** The text of this identifier. */
-  const StringRef& name() const { return _name; }
+  Atom name() const { return _name; }
 
   /** The container of the member. */
   const Node* base() const { return _base; }
 
 private:
-  const StringRef _name;
+  const Atom _name;
   const Node* _base;
 };
 
@@ -61,19 +61,20 @@ class KeywordArg : public Node {
 public:
 
   /** Construct a Member node. */
-  KeywordArg(Location& location, StringRef name, Node* arg)
+  KeywordArg(Location& location, Atom name, Node* arg)
     : Node(Kind::KEYWORD_ARG, location)
+    , _name(name)
     , _arg(arg)
   {}
 
   /** The text of this identifier. */
-  const StringRef name() const { return _name; }
+  Atom name() const { return _name; }
 
   /** The container of the member. */
   const Node* arg() const { return _arg; }
 
 private:
-  const StringRef _name;
+  const Atom _name;
   const Node* _arg;
 };
 
@@ -9,13 +9,19 @@
   #include "spark/ast/node.h"
 #endif
 
-#ifndef SPARK_COLLECTIONS_STRINGREF_H
-  #include "spark/collections/stringref.h"
+#ifndef SPARK_COLLECTIONS_ATOM_H
+  #include "spark/collections/atom.h"
 #endif
 
 namespace spark {
 namespace ast {
-using spark::collections::StringRef;
+using spark::collections::Atom;
+
+/** A range of byte offsets within a source file, from 'begin' up to but not including 'end'. */
+struct Span {
+  uint32_t begin;
+  uint32_t end;
+};
 
 /** AST node for a module. */
 class Module : public Node {
@@ -32,9 +38,17 @@ public:
   NodeList imports() const { return _imports; }
   void setImports(const NodeList& imports) { _imports = imports; }
 
+  /** For each member, the part of the source file containing its declaration, including any
+      attributes and modifiers. Members declared together in a visibility block share the span
+      of the whole block. Used to find the declarations affected by an edit (see
+      Parser::reparse()); empty if not known. */
+  collections::ArrayRef<Span> spans() const { return _spans; }
+  void setSpans(const collections::ArrayRef<Span>& spans) { _spans = spans; }
+
 private:
   NodeList _members;
   NodeList _imports;
+  collections::ArrayRef<Span> _spans;
 };
 
 /** Node type representing an import. */
@@ -42,7 +56,7 @@ class Import : public Node {
 public:
 
   /** Construct an Ident node. */
-  Import(const Location& location, const Node* path, StringRef alias)
+  Import(const Location& location, const Node* path, Atom alias)
     : Node(Kind::IMPORT, location)
     , _path(path)
     , _alias(alias)
@@ -52,11 +66,11 @@ public:
   const Node* path() const { return _path; }
 
   /** Short aliased name for the import. */
-  const StringRef alias() const { return _alias; }
+  Atom alias() const { return _alias; }
 
 private:
   const Node* _path;
-  const StringRef _alias;
+  const Atom _alias;
 };
 
 }}
@@ -3,10 +3,101 @@
 // ============================================================================
 
 #include "spark/ast/node.h"
+#include "spark/support/arena.h"
+
+#if SPARK_HAVE_ATOMIC
+  #include <atomic>
+#endif
+
+#if SPARK_HAVE_STDIO_H
+  #include <stdio.h>
+#endif
 
 namespace spark {
 namespace ast {
 
+static_assert(NUM_KINDS <= 256, "Node kinds must fit in a byte.");
+static_assert(sizeof(Node) == 8, "Node header should be 8 bytes.");
+
+namespace {
+  struct KindCounts {
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> bytes;
+  };
+
+  KindCounts kindCounts[NUM_KINDS];
+  KindCounts listCounts;
+
+  /** The most recent node allocation on this thread, so that the node's constructor can find
+      out how large the node is. */
+  struct PendingNode {
+    void* mem;
+    std::size_t size;
+  };
+
+  thread_local PendingNode pendingNode;
+}
+
+bool NodeStats::_enabled = false;
+
+void NodeStats::addNode(Kind kind, std::size_t size) {
+  KindCounts& counts = kindCounts[std::size_t(kind)];
+  counts.count.fetch_add(1, std::memory_order_relaxed);
+  counts.bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void NodeStats::addList(std::size_t size) {
+  listCounts.count.fetch_add(1, std::memory_order_relaxed);
+  listCounts.bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void NodeStats::print(std::ostream& out) {
+  char line[80];
+  uint64_t totalCount = 0;
+  uint64_t totalBytes = 0;
+  out << "AST nodes:\n";
+  snprintf(line, sizeof line, "  %-24s %10s %12s %8s\n", "kind", "count", "bytes", "avg");
+  out << line;
+  for (std::size_t i = 0; i < NUM_KINDS; ++i) {
+    uint64_t count = kindCounts[i].count.load();
+    uint64_t bytes = kindCounts[i].bytes.load();
+    if (count > 0) {
+      snprintf(line, sizeof line, "  %-24s %10llu %12llu %8.1f\n", Node::KindName(Kind(i)),
+          (unsigned long long) count, (unsigned long long) bytes, double(bytes) / count);
+      out << line;
+      totalCount += count;
+      totalBytes += bytes;
+    }
+  }
+  uint64_t listCount = listCounts.count.load();
+  uint64_t listBytes = listCounts.bytes.load();
+  snprintf(line, sizeof line, "  %-24s %10llu %12llu\n", "(node lists)",
+      (unsigned long long) listCount, (unsigned long long) listBytes);
+  out << line;
+  snprintf(line, sizeof line, "  %-24s %10llu %12llu\n", "total",
+      (unsigned long long) totalCount, (unsigned long long) (totalBytes + listBytes));
+  out << line;
+}
+
+const uint32_t Node::MAX_LENGTH;
+
+void* Node::operator new(std::size_t size, support::Arena& arena) {
+  void* mem = arena.allocate(size);
+  if (NodeStats::isEnabled()) {
+    pendingNode.mem = mem;
+    pendingNode.size = size;
+  }
+  return mem;
+}
+
+void Node::countNode() {
+  // Nodes that weren't allocated in an arena (such as the sentinels) aren't counted.
+  if (pendingNode.mem == this) {
+    NodeStats::addNode(kind(), pendingNode.size);
+    pendingNode.mem = nullptr;
+  }
+}
+
 /** Singleton error node. */
 Node Node::ERROR(Kind::ERROR, source::Location());
 
@@ -98,6 +189,7 @@ const char* Node::KindName(Kind kind) {
   case Kind::CALL_REQUIRED_STATIC: return "CALL_REQUIRED_STATIC";
   case Kind::LIST: return "LIST";
   case Kind::BLOCK: return "BLOCK";
+  case Kind::DEFERRED_BODY: return "DEFERRED_BODY";
   case Kind::VAR_DEFN: return "VAR_DEFN";
   case Kind::ELSE: return "ELSE";
   case Kind::FINALLY: return "FINALLY";
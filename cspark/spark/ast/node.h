@@ -17,6 +17,10 @@
   #include <ostream>
 #endif
 
+#if SPARK_HAVE_STDINT_H
+  #include <stdint.h>
+#endif
+
 namespace spark {
 namespace support {
 class Arena;
@@ -123,6 +127,7 @@ enum class Kind {
 
   /* Misc statements */
   BLOCK,      // A statement block
+  DEFERRED_BODY, // A function body that has not been parsed yet
   VAR_DEFN,   // A single variable definition (ident, type, init)
   ELSE,       // default for match or switch
   FINALLY,    // finally block for try
@@ -173,16 +178,55 @@ enum class Kind {
   IMPORT,
 };
 
+/** Number of node kinds. */
+const std::size_t NUM_KINDS = std::size_t(Kind::IMPORT) + 1;
+
+/** Counts of the AST nodes that have been allocated, by kind, for reporting memory use.
+    Counting is off unless enabled, and may be done from several threads at once. */
+class NodeStats {
+public:
+  /** Start counting node allocations. */
+  static void enable() { _enabled = true; }
+  static bool isEnabled() { return _enabled; }
+
+  /** Record that 'size' bytes were allocated for 'node'. */
+  static void addNode(Kind kind, std::size_t size);
+
+  /** Record that 'size' bytes were allocated for a list of nodes. */
+  static void addList(std::size_t size);
+
+  /** Print a table of the counts to 'out'. */
+  static void print(std::ostream& out);
+
+private:
+  static bool _enabled;
+};
+
+/** Base class of AST nodes. Nodes are allocated in an arena, and are never destroyed. To keep
+    them small the node header is packed into 8 bytes: the start offset of the node's location,
+    an 8-bit kind and a 24-bit length. Nodes longer than 16MB have their length truncated. */
 class Node {
 public:
   /** Construct an AST node. */
-  Node(Kind kind, const Location& location) : _kind(kind), _location(location) {}
+  Node(Kind kind, const Location& location)
+    : _begin(location.begin)
+    , _kind(uint8_t(kind))
+    , _length(compactLength(location))
+  {
+    if (NodeStats::isEnabled()) {
+      countNode();
+    }
+  }
 
   /** What kind of node this is. */
-  Kind kind() const { return _kind; }
+  Kind kind() const { return Kind(_kind); }
 
   /** The source location where this node was parsed. */
-  const source::Location& location() const { return _location; }
+  source::Location location() const { return source::Location(_begin, _begin + _length); }
+
+  /** Allocate a node in an arena. */
+  static void* operator new(std::size_t size, support::Arena& arena);
+  static void operator delete(void* mem, support::Arena& arena) {}
 
   static inline bool isError(const Node* node) {
     return node == nullptr || node->kind() == Kind::ERROR;
@@ -198,8 +242,20 @@ public:
   // Return the name of the specified kind.
   static const char* KindName(Kind kind);
 private:
-  const Kind _kind;
-  const source::Location _location;
+  static const uint32_t MAX_LENGTH = (1 << 24) - 1;
+
+  uint32_t _begin;
+  uint32_t _kind : 8;
+  uint32_t _length : 24;
+
+  static uint32_t compactLength(const Location& location) {
+    if (location.begin == 0 || location.end <= location.begin) {
+      return 0;
+    }
+    return std::min(location.end - location.begin, MAX_LENGTH);
+  }
+
+  void countNode();
 };
 
 /** Typedef for a list of nodes. */
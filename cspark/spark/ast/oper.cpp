@@ -0,0 +1,24 @@
+// ============================================================================
+// oper.cpp: AST representing operators
+// ============================================================================
+
+#include "spark/ast/oper.h"
+#include "spark/support/arena.h"
+
+#if SPARK_HAVE_ALGORITHM
+  #include <algorithm>
+#endif
+
+namespace spark {
+namespace ast {
+
+static_assert(sizeof(Oper) % sizeof(Node*) == 0, "Oper operands would be misaligned.");
+
+Oper* Oper::create(support::Arena& arena, Kind kind, const Location& location, NodeList operands) {
+  void* mem = Node::operator new(sizeof(Oper) + operands.size() * sizeof(Node*), arena);
+  Oper* result = ::new (mem) Oper(kind, location, uint32_t(operands.size()));
+  std::copy(operands.begin(), operands.end(), reinterpret_cast<const Node**>(result + 1));
+  return result;
+}
+
+}}
@@ -35,26 +35,32 @@ private:
   const Node* _arg;
 };
 
-/** N-ary operator. */
+/** N-ary operator. The operands are stored inline, immediately after the node, so operators
+    must be created with create() rather than new. */
 class Oper : public Node {
 public:
-  Oper(Kind kind, const Location& location, NodeList operands)
-    : Node(kind, location)
-    , _op(nullptr)
-    , _operands(operands)
-  {}
+  /** Create an operator node in 'arena', with a copy of 'operands'. */
+  static Oper* create(
+      support::Arena& arena, Kind kind, const Location& location, NodeList operands);
 
   /** The operator. May be NULL if implied by the node type. */
   const Node* op() const { return _op; }
   void setOp(Node* n) { _op = n; }
 
   /** List of operands. */
-  NodeList operands() const { return _operands; }
-  void setOperands(const NodeList& operands) { _operands = operands; }
+  NodeList operands() const {
+    return NodeList(reinterpret_cast<const Node* const*>(this + 1), _size);
+  }
 
 private:
   Node* _op;
-  NodeList _operands;
+  uint32_t _size;
+
+  Oper(Kind kind, const Location& location, uint32_t size)
+    : Node(kind, location)
+    , _op(nullptr)
+    , _size(size)
+  {}
 };
 
 /** An operator that has a test expression and multiple branches. */
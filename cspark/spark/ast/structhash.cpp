@@ -0,0 +1,116 @@
+// ============================================================================
+// structhash.cpp
+// ============================================================================
+
+#include "spark/ast/structhash.h"
+#include "spark/ast/ident.h"
+#include "spark/ast/oper.h"
+#include "spark/collections/hashing.h"
+
+namespace spark {
+namespace ast {
+
+bool structuralHash(const Node* node, std::size_t& hash) {
+  if (node == nullptr) {
+    std::hash_combine(hash, 0);
+    return true;
+  }
+  std::hash_combine(hash, std::size_t(node->kind()) + 1);
+  switch (node->kind()) {
+    case Kind::ABSENT:
+      return true;
+
+    case Kind::IDENT:
+      std::hash_combine(hash, static_cast<const Ident*>(node)->name().hash());
+      return true;
+
+    case Kind::MEMBER: {
+      auto member = static_cast<const MemberRef*>(node);
+      std::hash_combine(hash, member->name().hash());
+      return structuralHash(member->base(), hash);
+    }
+
+    case Kind::BUILTIN_TYPE:
+      std::hash_combine(hash, std::size_t(static_cast<const BuiltInType*>(node)->type()));
+      return true;
+
+    case Kind::CONST:
+    case Kind::PROVISIONAL_CONST:
+    case Kind::OPTIONAL:
+      return structuralHash(static_cast<const UnaryOp*>(node)->arg(), hash);
+
+    case Kind::SPECIALIZE:
+    case Kind::FUNCTION_TYPE:
+    case Kind::UNION:
+    case Kind::TUPLE: {
+      auto oper = static_cast<const Oper*>(node);
+      if (!structuralHash(oper->op(), hash)) {
+        return false;
+      }
+      std::hash_combine(hash, oper->operands().size());
+      for (const Node* operand : oper->operands()) {
+        if (!structuralHash(operand, hash)) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    default:
+      return false;
+  }
+}
+
+bool structurallyEqual(const Node* a, const Node* b) {
+  if (a == b) {
+    return true;
+  } else if (a == nullptr || b == nullptr || a->kind() != b->kind()) {
+    return false;
+  }
+  switch (a->kind()) {
+    case Kind::ABSENT:
+      return true;
+
+    case Kind::IDENT:
+      return static_cast<const Ident*>(a)->name() == static_cast<const Ident*>(b)->name();
+
+    case Kind::MEMBER: {
+      auto ma = static_cast<const MemberRef*>(a);
+      auto mb = static_cast<const MemberRef*>(b);
+      return ma->name() == mb->name() && structurallyEqual(ma->base(), mb->base());
+    }
+
+    case Kind::BUILTIN_TYPE:
+      return static_cast<const BuiltInType*>(a)->type() ==
+          static_cast<const BuiltInType*>(b)->type();
+
+    case Kind::CONST:
+    case Kind::PROVISIONAL_CONST:
+    case Kind::OPTIONAL:
+      return structurallyEqual(
+          static_cast<const UnaryOp*>(a)->arg(), static_cast<const UnaryOp*>(b)->arg());
+
+    case Kind::SPECIALIZE:
+    case Kind::FUNCTION_TYPE:
+    case Kind::UNION:
+    case Kind::TUPLE: {
+      auto oa = static_cast<const Oper*>(a);
+      auto ob = static_cast<const Oper*>(b);
+      if (!structurallyEqual(oa->op(), ob->op()) ||
+          oa->operands().size() != ob->operands().size()) {
+        return false;
+      }
+      for (std::size_t i = 0; i < oa->operands().size(); ++i) {
+        if (!structurallyEqual(oa->operands()[i], ob->operands()[i])) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    default:
+      return false;
+  }
+}
+
+}}
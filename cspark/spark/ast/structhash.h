@@ -0,0 +1,26 @@
+// ============================================================================
+// structhash.h: Structural hashing and comparison of type expressions.
+// ============================================================================
+
+#ifndef SPARK_AST_STRUCTHASH_H
+#define SPARK_AST_STRUCTHASH_H 1
+
+#ifndef SPARK_AST_NODE_H
+  #include "spark/ast/node.h"
+#endif
+
+namespace spark {
+namespace ast {
+
+/** Compute a hash of the structure of the type expression 'node', ignoring source locations,
+    so that two spellings of the same type expression hash alike. Returns false if 'node'
+    contains anything other than names, built-in types and type operators, in which case
+    'hash' is not meaningful. The hash is combined into the existing value of 'hash'. */
+bool structuralHash(const Node* node, std::size_t& hash);
+
+/** Returns true if 'a' and 'b' are the same type expression, apart from source locations. */
+bool structurallyEqual(const Node* a, const Node* b);
+
+}}
+
+#endif
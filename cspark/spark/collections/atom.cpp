@@ -0,0 +1,154 @@
+// ============================================================================
+// atom.cpp: Interned strings.
+// ============================================================================
+
+#include "spark/collections/atom.h"
+#include "spark/collections/hashing.h"
+
+#if SPARK_HAVE_ALGORITHM
+  #include <algorithm>
+#endif
+
+#if SPARK_HAVE_STDDEF_H
+  #include <stddef.h>
+#endif
+
+#if SPARK_HAVE_CSTRING
+  #include <cstring>
+#endif
+
+#if SPARK_HAVE_MUTEX
+  #include <mutex>
+#endif
+
+#if SPARK_HAVE_VECTOR
+  #include <vector>
+#endif
+
+namespace spark {
+namespace collections {
+
+namespace {
+  /** The table is split into shards, each with its own lock, so that threads interning
+      different names rarely contend. */
+  static const unsigned SHARD_BITS = 4;
+  static const unsigned NUM_SHARDS = 1u << SHARD_BITS;
+
+  /** Entries are carved out of chunks of this size. Chunks are never freed. */
+  static const size_t CHUNK_SIZE = 0x10000;
+
+  size_t hashText(const StringRef& text) {
+    return size_t(hashBytes(text.begin(), text.size()));
+  }
+
+  class Shard {
+  public:
+    Shard() : _count(0), _pos(nullptr), _end(nullptr) {
+      _slots.resize(256, nullptr);
+    }
+
+    const Atom::Entry* find(const StringRef& text, size_t hash) {
+      #if SPARK_HAVE_MUTEX
+        std::lock_guard<std::mutex> lock(_mutex);
+      #endif
+      return _slots[probe(text, hash)];
+    }
+
+    const Atom::Entry* intern(const StringRef& text, size_t hash) {
+      #if SPARK_HAVE_MUTEX
+        std::lock_guard<std::mutex> lock(_mutex);
+      #endif
+      size_t index = probe(text, hash);
+      if (_slots[index] != nullptr) {
+        return _slots[index];
+      }
+      const Atom::Entry* entry = create(text, hash);
+      _slots[index] = entry;
+      if (++_count * 4 > _slots.size() * 3) {
+        grow();
+      }
+      return entry;
+    }
+
+  private:
+    #if SPARK_HAVE_MUTEX
+      std::mutex _mutex;
+    #endif
+    std::vector<const Atom::Entry*> _slots;
+    size_t _count;
+    char* _pos;
+    char* _end;
+
+    /** Return the slot holding 'text', or the empty slot where it should go. The low bits of the
+        hash select the shard, so the slot index is taken from the bits above them. */
+    size_t probe(const StringRef& text, size_t hash) const {
+      size_t mask = _slots.size() - 1;
+      size_t index = (hash >> SHARD_BITS) & mask;
+      for (;;) {
+        const Atom::Entry* entry = _slots[index];
+        if (entry == nullptr || (entry->hash == hash && entry->size == text.size() &&
+            std::memcmp(entry->text, text.begin(), text.size()) == 0)) {
+          return index;
+        }
+        index = (index + 1) & mask;
+      }
+    }
+
+    void grow() {
+      std::vector<const Atom::Entry*> old;
+      old.swap(_slots);
+      _slots.resize(old.size() * 2, nullptr);
+      size_t mask = _slots.size() - 1;
+      for (const Atom::Entry* entry : old) {
+        if (entry != nullptr) {
+          size_t index = (entry->hash >> SHARD_BITS) & mask;
+          while (_slots[index] != nullptr) {
+            index = (index + 1) & mask;
+          }
+          _slots[index] = entry;
+        }
+      }
+    }
+
+    const Atom::Entry* create(const StringRef& text, size_t hash) {
+      size_t size = (offsetof(Atom::Entry, text) + text.size() + 1 + 7) & ~size_t(7);
+      if (size_t(_end - _pos) < size) {
+        size_t chunkSize = std::max(size, CHUNK_SIZE);
+        _pos = new char[chunkSize];
+        _end = _pos + chunkSize;
+      }
+      Atom::Entry* entry = reinterpret_cast<Atom::Entry*>(_pos);
+      _pos += size;
+      entry->hash = hash;
+      entry->size = uint32_t(text.size());
+      std::memcpy(entry->text, text.begin(), text.size());
+      entry->text[text.size()] = '\0';
+      return entry;
+    }
+  };
+
+  /** The shards are allocated on first use and never destroyed, so that atoms remain valid
+      during static destruction. */
+  Shard* shards() {
+    static Shard* table = new Shard[NUM_SHARDS];
+    return table;
+  }
+}
+
+Atom Atom::intern(const StringRef& text) {
+  if (text.empty()) {
+    return Atom();
+  }
+  size_t hash = hashText(text);
+  return Atom(shards()[hash & (NUM_SHARDS - 1)].intern(text, hash));
+}
+
+Atom Atom::find(const StringRef& text) {
+  if (text.empty()) {
+    return Atom();
+  }
+  size_t hash = hashText(text);
+  return Atom(shards()[hash & (NUM_SHARDS - 1)].find(text, hash));
+}
+
+}}
@@ -0,0 +1,98 @@
+// ============================================================================
+// atom.h: Interned strings.
+// ============================================================================
+
+#ifndef SPARK_COLLECTIONS_ATOM_H
+#define SPARK_COLLECTIONS_ATOM_H 1
+
+#ifndef SPARK_COLLECTIONS_STRINGREF_H
+  #include "spark/collections/stringref.h"
+#endif
+
+#if SPARK_HAVE_FUNCTIONAL
+  #include <functional>
+#endif
+
+#if SPARK_HAVE_OSTREAM
+  #include <ostream>
+#endif
+
+namespace spark {
+namespace collections {
+
+/** An interned string. All atoms with the same text share a single entry in a process-wide
+    table, so atoms are compared by address, and their hash is computed once when the text is
+    first interned. Atoms are never freed. */
+class Atom {
+public:
+  typedef const char* iterator;
+  typedef const char* const_iterator;
+
+  /** Construct a null atom, which compares equal to the empty string. */
+  Atom() : _entry(nullptr) {}
+
+  /** Return the atom for 'text', adding it to the table if needed. This is thread-safe. */
+  static Atom intern(const StringRef& text);
+
+  /** Return the atom for 'text' if it has been interned, otherwise a null atom. Since names are
+      interned when they are defined, a name that was never interned can't match anything. */
+  static Atom find(const StringRef& text);
+
+  /** The text of this atom. */
+  StringRef str() const {
+    return _entry ? StringRef(_entry->text, _entry->size) : StringRef();
+  }
+  operator StringRef() const { return str(); }
+
+  /** The text of this atom, as a null-terminated string. */
+  const char* c_str() const { return _entry ? _entry->text : ""; }
+
+  /** The hash value of the text, computed when the atom was interned. */
+  size_t hash() const { return _entry ? _entry->hash : 0; }
+
+  size_t size() const { return _entry ? _entry->size : 0; }
+  bool empty() const { return size() == 0; }
+  bool isNull() const { return _entry == nullptr; }
+  iterator begin() const { return c_str(); }
+  iterator end() const { return c_str() + size(); }
+
+  friend bool operator==(Atom lhs, Atom rhs) { return lhs._entry == rhs._entry; }
+  friend bool operator!=(Atom lhs, Atom rhs) { return lhs._entry != rhs._entry; }
+  friend bool operator==(Atom lhs, const StringRef& rhs) { return lhs.str() == rhs; }
+  friend bool operator!=(Atom lhs, const StringRef& rhs) { return lhs.str() != rhs; }
+  friend bool operator==(const StringRef& lhs, Atom rhs) { return lhs == rhs.str(); }
+  friend bool operator!=(const StringRef& lhs, Atom rhs) { return lhs != rhs.str(); }
+
+  /** Storage for an interned string. The text follows the header, and is null-terminated. */
+  struct Entry {
+    size_t hash;
+    uint32_t size;
+    char text[1];
+  };
+
+private:
+  explicit Atom(const Entry* entry) : _entry(entry) {}
+
+  const Entry* _entry;
+};
+
+inline ::std::ostream& operator<<(::std::ostream& os, Atom atom) {
+  os.write(atom.begin(), atom.size());
+  return os;
+}
+
+}}
+
+namespace std {
+
+/** Atoms hash to the precomputed hash of their text. */
+template<>
+struct hash<spark::collections::Atom> {
+  inline std::size_t operator()(spark::collections::Atom value) const {
+    return value.hash();
+  }
+};
+
+}
+
+#endif
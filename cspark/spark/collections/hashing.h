@@ -21,10 +21,113 @@
   #include <stdint.h>
 #endif
 
+#if SPARK_HAVE_CSTRING
+  #include <cstring>
+#endif
+
 #ifndef SPARK_COLLECTIONS_STRINGREF_H
   #include "spark/collections/stringref.h"
 #endif
 
+namespace spark {
+namespace collections {
+
+namespace detail {
+  /** Constants for hashBytes(): odd 64-bit values with evenly mixed bits. */
+  static const uint64_t HASH_SECRET[4] = {
+    0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull,
+  };
+
+  /** Multiply two 64-bit values, returning the low and high halves of the product in 'a' and
+      'b'. */
+  inline void hashMultiply(uint64_t& a, uint64_t& b) {
+  #if defined(__SIZEOF_INT128__)
+    __uint128_t r = a;
+    r *= b;
+    a = uint64_t(r);
+    b = uint64_t(r >> 64);
+  #else
+    uint64_t ha = a >> 32, hb = b >> 32, la = uint32_t(a), lb = uint32_t(b);
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t carry = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    carry += lo < t;
+    a = lo;
+    b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+  #endif
+  }
+
+  /** Multiply two 64-bit values and fold the 128-bit product down to 64 bits. */
+  inline uint64_t hashMix(uint64_t a, uint64_t b) {
+    hashMultiply(a, b);
+    return a ^ b;
+  }
+
+  inline uint64_t read64(const uint8_t* p) {
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+  }
+
+  inline uint64_t read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+  }
+}
+
+/** Compute a 64-bit hash of 'size' bytes at 'data'. This is a wyhash-style hash: input is read
+    eight bytes at a time and mixed with 64x64->128-bit multiplies, and inputs of 16 bytes or
+    less - which covers most identifiers - take a single multiply plus finalization. Different
+    seeds give independent hash functions. Results depend on the byte order of the host, so
+    they must not be persisted. */
+inline uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0) {
+  using namespace detail;
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  seed ^= hashMix(seed ^ HASH_SECRET[0], HASH_SECRET[1]);
+  uint64_t a, b;
+  if (size <= 16) {
+    if (size >= 4) {
+      // Two possibly-overlapping pairs of 32-bit reads cover every byte.
+      size_t mid = (size >> 3) << 2;
+      a = (read32(p) << 32) | read32(p + mid);
+      b = (read32(p + size - 4) << 32) | read32(p + size - 4 - mid);
+    } else if (size > 0) {
+      a = (uint64_t(p[0]) << 16) | (uint64_t(p[size >> 1]) << 8) | p[size - 1];
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    size_t i = size;
+    if (i > 48) {
+      uint64_t seed1 = seed, seed2 = seed;
+      do {
+        seed = hashMix(read64(p) ^ HASH_SECRET[1], read64(p + 8) ^ seed);
+        seed1 = hashMix(read64(p + 16) ^ HASH_SECRET[2], read64(p + 24) ^ seed1);
+        seed2 = hashMix(read64(p + 32) ^ HASH_SECRET[3], read64(p + 40) ^ seed2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= seed1 ^ seed2;
+    }
+    while (i > 16) {
+      seed = hashMix(read64(p) ^ HASH_SECRET[1], read64(p + 8) ^ seed);
+      p += 16;
+      i -= 16;
+    }
+    a = read64(p + i - 16);
+    b = read64(p + i - 8);
+  }
+  a ^= HASH_SECRET[1];
+  b ^= seed;
+  hashMultiply(a, b);
+  return hashMix(a ^ HASH_SECRET[0] ^ size, b ^ HASH_SECRET[1]);
+}
+
+}}
+
 namespace std {
 
 /** Combine two hash vaues. */
@@ -36,11 +139,7 @@ inline void hash_combine(std::size_t& lhs, std::size_t rhs) {
 template<>
 struct hash<spark::collections::StringRef> {
   inline std::size_t operator()(const spark::collections::StringRef& value) const {
-    std::size_t seed = 0;
-    for (char c : value) {
-      hash_combine(seed, std::hash<char>()(c));
-    }
-    return seed;
+    return std::size_t(spark::collections::hashBytes(value.begin(), value.size()));
   }
 };
 
@@ -41,28 +41,32 @@ public:
   typedef const char* iterator;
   typedef const char* const_iterator;
 
+  /** Upper bound on string length, used to catch corrupt sizes. This is large enough to hold
+      the complete text of a source file. */
+  static const size_t MAX_SIZE = 0x10000000;
+
   /// Construct an empty StringRef.
   StringRef() : _data(nullptr), _size(0) {}
 
   /** Construct a StringRef from a C string. */
   template <size_t Size>
   StringRef(const char (&array)[Size]) : _data(array), _size(Size - 1) {
-    assert(_size < 0x100000);
+    assert(_size < MAX_SIZE);
   }
 
   /** Construct a StringRef from a null-terminated C string. */
   StringRef(const char* str) : _data(str), _size(std::strlen(str)) {
-    assert(_size < 0x100000);
+    assert(_size < MAX_SIZE);
   }
 
   /** Construct a StringRef from an STL string. */
   StringRef(const std::string& str) : _data(str.data()), _size(str.size()) {
-    assert(_size < 0x100000);
+    assert(_size < MAX_SIZE);
   }
 
   /** Construct a StringRef from a character array with explicit size. */
   StringRef(const char* str, size_t size) : _data(str), _size(size) {
-    assert(_size < 0x100000);
+    assert(_size < MAX_SIZE);
   }
 
   /** Return the size of the string in bytes. */
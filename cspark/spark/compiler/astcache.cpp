@@ -0,0 +1,983 @@
+// ============================================================================
+// astcache.cpp: On-disk cache of parsed modules.
+// ============================================================================
+
+#include "spark/ast/defn.h"
+#include "spark/ast/ident.h"
+#include "spark/ast/literal.h"
+#include "spark/ast/module.h"
+#include "spark/ast/oper.h"
+#include "spark/collections/hashing.h"
+#include "spark/compiler/astcache.h"
+#include "spark/compiler/compiler.h"
+#include "spark/source/programsource.h"
+#include "spark/support/arena.h"
+
+#if SPARK_HAVE_ATOMIC
+  #include <atomic>
+#endif
+
+#if SPARK_HAVE_CSTRING
+  #include <cstring>
+#endif
+
+#if SPARK_HAVE_FSTREAM
+  #include <fstream>
+#endif
+
+#if SPARK_HAVE_STDIO_H
+  #include <stdio.h>
+#endif
+
+#if SPARK_HAVE_UNISTD_H
+  #include <unistd.h>
+#endif
+
+#if SPARK_HAVE_UNORDERED_MAP
+  #include <unordered_map>
+#endif
+
+#if SPARK_HAVE_VECTOR
+  #include <vector>
+#endif
+
+namespace spark {
+namespace compiler {
+using ast::Kind;
+using ast::Node;
+using ast::NodeList;
+using collections::Atom;
+using collections::StringRef;
+
+const uint32_t AstCache::FORMAT_VERSION;
+
+namespace {
+  const uint32_t MAGIC = 0x414b5053; // "SPKA"
+
+  /** Layout of the entry header. */
+  enum Header {
+    H_MAGIC,
+    H_FORMAT,
+    H_FLAGS,
+    H_SOURCE_SIZE,
+    H_SOURCE_HASH_LO,
+    H_SOURCE_HASH_HI,
+    H_VERSION_HASH_LO,
+    H_VERSION_HASH_HI,
+    H_STRING_COUNT,
+    H_NODE_COUNT,
+    H_SIZE,           // Size of the entry in words.
+    HEADER_SIZE,
+  };
+
+  /** Header flags. */
+  const uint32_t F_DEFER_BODIES = 1;
+
+  /** Node references that don't refer to a stored node. Stored nodes are numbered after these,
+      in the order that they appear in the entry. */
+  enum NodeRef {
+    REF_NULL,
+    REF_ABSENT,
+    REF_ERROR,
+    FIRST_NODE,
+  };
+
+  /** Which node class a kind is represented by. Each class has its own record layout. */
+  enum class Layout {
+    UNKNOWN,
+    NODE,
+    IDENT,
+    MEMBER,
+    BUILTIN_TYPE,
+    BUILTIN_ATTRIBUTE,
+    TEXT_LITERAL,
+    INTEGER_LITERAL,
+    FLOAT_LITERAL,
+    UNARY,
+    OPER,
+    CONTROL,
+    DEFERRED_BODY,
+    TYPE_DEFN,
+    VALUE_DEFN,
+    ENUM_VALUE,
+    PARAMETER,
+    TYPE_PARAMETER,
+    FUNCTION,
+    PROPERTY,
+    MODULE,
+    IMPORT,
+  };
+
+  Layout layoutOf(Kind kind) {
+    switch (kind) {
+      case Kind::NULL_LITERAL:
+      case Kind::SELF:
+      case Kind::SUPER:
+      case Kind::BOOLEAN_TRUE:
+      case Kind::BOOLEAN_FALSE:
+      case Kind::BREAK:
+      case Kind::CONTINUE:
+        return Layout::NODE;
+
+      case Kind::IDENT: return Layout::IDENT;
+      case Kind::MEMBER: return Layout::MEMBER;
+      case Kind::BUILTIN_TYPE: return Layout::BUILTIN_TYPE;
+      case Kind::BUILTIN_ATTRIBUTE: return Layout::BUILTIN_ATTRIBUTE;
+
+      case Kind::CHAR_LITERAL:
+      case Kind::STRING_LITERAL:
+        return Layout::TEXT_LITERAL;
+      case Kind::INTEGER_LITERAL: return Layout::INTEGER_LITERAL;
+      case Kind::FLOAT_LITERAL: return Layout::FLOAT_LITERAL;
+
+      case Kind::SELF_NAME_REF:
+      case Kind::NEGATE:
+      case Kind::COMPLEMENT:
+      case Kind::LOGICAL_NOT:
+      case Kind::PRE_INC:
+      case Kind::POST_INC:
+      case Kind::PRE_DEC:
+      case Kind::POST_DEC:
+      case Kind::STATIC:
+      case Kind::CONST:
+      case Kind::PROVISIONAL_CONST:
+      case Kind::OPTIONAL:
+      case Kind::RETURN:
+      case Kind::THROW:
+        return Layout::UNARY;
+
+      case Kind::KEYWORD_ARG:
+      case Kind::ADD:
+      case Kind::SUB:
+      case Kind::MUL:
+      case Kind::DIV:
+      case Kind::MOD:
+      case Kind::BIT_AND:
+      case Kind::BIT_OR:
+      case Kind::BIT_XOR:
+      case Kind::RSHIFT:
+      case Kind::LSHIFT:
+      case Kind::EQUAL:
+      case Kind::REF_EQUAL:
+      case Kind::NOT_EQUAL:
+      case Kind::LESS_THAN:
+      case Kind::GREATER_THAN:
+      case Kind::LESS_THAN_OR_EQUAL:
+      case Kind::GREATER_THAN_OR_EQUAL:
+      case Kind::IS_SUB_TYPE:
+      case Kind::IS_SUPER_TYPE:
+      case Kind::ASSIGN:
+      case Kind::ASSIGN_ADD:
+      case Kind::ASSIGN_SUB:
+      case Kind::ASSIGN_MUL:
+      case Kind::ASSIGN_DIV:
+      case Kind::ASSIGN_MOD:
+      case Kind::ASSIGN_BIT_AND:
+      case Kind::ASSIGN_BIT_OR:
+      case Kind::ASSIGN_BIT_XOR:
+      case Kind::ASSIGN_RSHIFT:
+      case Kind::ASSIGN_LSHIFT:
+      case Kind::LOGICAL_AND:
+      case Kind::LOGICAL_OR:
+      case Kind::RANGE:
+      case Kind::AS_TYPE:
+      case Kind::IS:
+      case Kind::IS_NOT:
+      case Kind::IN:
+      case Kind::NOT_IN:
+      case Kind::RETURNS:
+      case Kind::LAMBDA:
+      case Kind::EXPR_TYPE:
+      case Kind::TUPLE:
+      case Kind::UNION:
+      case Kind::SPECIALIZE:
+      case Kind::CALL:
+      case Kind::FLUENT_MEMBER:
+      case Kind::ARRAY_LITERAL:
+      case Kind::LIST_LITERAL:
+      case Kind::SET_LITERAL:
+      case Kind::CALL_REQUIRED:
+      case Kind::CALL_REQUIRED_STATIC:
+      case Kind::LIST:
+      case Kind::BLOCK:
+      case Kind::VAR_DEFN:
+      case Kind::ELSE:
+      case Kind::FINALLY:
+      case Kind::CASE:
+      case Kind::PATTERN:
+      case Kind::FUNCTION_TYPE:
+        return Layout::OPER;
+
+      case Kind::IF:
+      case Kind::WHILE:
+      case Kind::LOOP:
+      case Kind::FOR:
+      case Kind::FOR_IN:
+      case Kind::TRY:
+      case Kind::SWITCH:
+      case Kind::MATCH:
+        return Layout::CONTROL;
+
+      case Kind::DEFERRED_BODY: return Layout::DEFERRED_BODY;
+
+      case Kind::TYPE_DEFN:
+      case Kind::CLASS_DEFN:
+      case Kind::STRUCT_DEFN:
+      case Kind::INTERFACE_DEFN:
+      case Kind::EXTEND_DEFN:
+      case Kind::OBJECT_DEFN:
+      case Kind::ENUM_DEFN:
+        return Layout::TYPE_DEFN;
+
+      case Kind::VAR:
+      case Kind::LET:
+      case Kind::VAR_LIST:
+        return Layout::VALUE_DEFN;
+
+      case Kind::ENUM_VALUE: return Layout::ENUM_VALUE;
+      case Kind::PARAMETER: return Layout::PARAMETER;
+      case Kind::TYPE_PARAMETER: return Layout::TYPE_PARAMETER;
+      case Kind::FUNCTION: return Layout::FUNCTION;
+      case Kind::PROPERTY: return Layout::PROPERTY;
+      case Kind::MODULE: return Layout::MODULE;
+      case Kind::IMPORT: return Layout::IMPORT;
+
+      default:
+        return Layout::UNKNOWN;
+    }
+  }
+
+  /** 64-bit FNV-1a hash. */
+  uint64_t hashBytes(const char* data, std::size_t size) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (std::size_t i = 0; i < size; ++i) {
+      h = (h ^ uint8_t(data[i])) * 0x100000001b3ull;
+    }
+    return h;
+  }
+
+  uint64_t versionHash() {
+    StringRef version(Compiler::version());
+    return hashBytes(version.begin(), version.size()) ^ AstCache::FORMAT_VERSION;
+  }
+
+  /** Converts an AST into the words of a cache entry. */
+  class Writer {
+  public:
+    Writer(uint32_t base, uint32_t size)
+      : _base(base)
+      , _size(size)
+      , _nodeCount(0)
+      , _valid(true)
+    {
+      _strings.push_back(StringRef());
+      _stringIndex[StringRef()] = 0;
+    }
+
+    /** Write 'n' and everything it refers to, unless already written, and return its
+        reference. */
+    uint32_t node(const Node* n);
+
+    /** False if the AST contained something that can't be stored. */
+    bool valid() const { return _valid; }
+
+    /** Append the complete entry, including the header, to 'out'. */
+    void finish(const uint32_t* header, std::vector<uint32_t>& out);
+
+  private:
+    /** Words of a single node record, which is built up while its children are written. */
+    typedef std::vector<uint32_t> Record;
+
+    uint32_t _base;
+    uint32_t _size;
+    uint32_t _nodeCount;
+    bool _valid;
+    std::vector<uint32_t> _nodes;
+    std::vector<StringRef> _strings;
+    std::unordered_map<StringRef, uint32_t> _stringIndex;
+    std::unordered_map<const Node*, uint32_t> _nodeIndex;
+
+    uint32_t string(const StringRef& str);
+    void list(Record& r, const NodeList& nodes);
+    void defn(Record& r, const ast::Defn* d);
+  };
+
+  uint32_t Writer::string(const StringRef& str) {
+    auto it = _stringIndex.find(str);
+    if (it != _stringIndex.end()) {
+      return it->second;
+    }
+    uint32_t index = uint32_t(_strings.size());
+    _strings.push_back(str);
+    _stringIndex[str] = index;
+    return index;
+  }
+
+  void Writer::list(Record& r, const NodeList& nodes) {
+    Record refs;
+    for (const Node* n : nodes) {
+      refs.push_back(node(n));
+    }
+    r.push_back(uint32_t(refs.size()));
+    r.insert(r.end(), refs.begin(), refs.end());
+  }
+
+  void Writer::defn(Record& r, const ast::Defn* d) {
+    if (d->docComment() != nullptr) {
+      _valid = false;
+    }
+    r.push_back(string(d->name()));
+    r.push_back(
+        (d->isPrivate() << 0) | (d->isProtected() << 1) | (d->isStatic() << 2) |
+        (d->isOverride() << 3) | (d->isUndef() << 4) | (d->isFinal() << 5) |
+        (d->isAbstract() << 6));
+    list(r, d->members());
+    list(r, d->attributes());
+    list(r, d->typeParams());
+    list(r, d->requires());
+  }
+
+  uint32_t Writer::node(const Node* n) {
+    if (n == nullptr) {
+      return REF_NULL;
+    } else if (n == &Node::ABSENT) {
+      return REF_ABSENT;
+    } else if (n == &Node::ERROR) {
+      return REF_ERROR;
+    }
+    auto it = _nodeIndex.find(n);
+    if (it != _nodeIndex.end()) {
+      return it->second;
+    }
+
+    // Locations are stored relative to the start of the file, plus one, so that zero still
+    // means 'no location'.
+    source::Location loc = n->location();
+    Record r;
+    r.push_back(uint32_t(n->kind()));
+    if (loc.begin == 0) {
+      r.push_back(0);
+    } else if (loc.begin >= _base && loc.end <= _base + _size) {
+      r.push_back(loc.begin - _base + 1);
+    } else {
+      _valid = false;
+      r.push_back(0);
+    }
+    r.push_back(loc.end - loc.begin);
+
+    switch (layoutOf(n->kind())) {
+      case Layout::UNKNOWN:
+        _valid = false;
+        break;
+
+      case Layout::NODE:
+      case Layout::DEFERRED_BODY:
+        break;
+
+      case Layout::IDENT:
+        r.push_back(string(static_cast<const ast::Ident*>(n)->name()));
+        break;
+
+      case Layout::MEMBER: {
+        auto m = static_cast<const ast::MemberRef*>(n);
+        r.push_back(string(m->name()));
+        r.push_back(node(m->base()));
+        break;
+      }
+
+      case Layout::BUILTIN_TYPE:
+        r.push_back(static_cast<const ast::BuiltInType*>(n)->type());
+        break;
+
+      case Layout::BUILTIN_ATTRIBUTE:
+        r.push_back(static_cast<const ast::BuiltInAttribute*>(n)->attribute());
+        break;
+
+      case Layout::TEXT_LITERAL:
+        r.push_back(string(static_cast<const ast::TextLiteral*>(n)->value()));
+        break;
+
+      case Layout::INTEGER_LITERAL: {
+        auto lit = static_cast<const ast::IntegerLiteral*>(n);
+        uint64_t value = uint64_t(lit->value());
+        r.push_back(uint32_t(value));
+        r.push_back(uint32_t(value >> 32));
+        r.push_back(lit->isUnsigned());
+        break;
+      }
+
+      case Layout::FLOAT_LITERAL: {
+        double value = static_cast<const ast::FloatLiteral*>(n)->value();
+        uint32_t words[2];
+        static_assert(sizeof(words) == sizeof(value), "Unexpected size for double.");
+        std::memcpy(words, &value, sizeof(value));
+        r.push_back(words[0]);
+        r.push_back(words[1]);
+        break;
+      }
+
+      case Layout::UNARY:
+        r.push_back(node(static_cast<const ast::UnaryOp*>(n)->arg()));
+        break;
+
+      case Layout::OPER: {
+        auto op = static_cast<const ast::Oper*>(n);
+        r.push_back(node(op->op()));
+        list(r, op->operands());
+        break;
+      }
+
+      case Layout::CONTROL: {
+        auto st = static_cast<const ast::ControlStmt*>(n);
+        r.push_back(node(st->test()));
+        list(r, st->outcomes());
+        break;
+      }
+
+      case Layout::TYPE_DEFN: {
+        auto td = static_cast<const ast::TypeDefn*>(n);
+        defn(r, td);
+        list(r, td->bases());
+        list(r, td->friends());
+        break;
+      }
+
+      case Layout::VALUE_DEFN:
+      case Layout::ENUM_VALUE:
+      case Layout::PARAMETER: {
+        auto vd = static_cast<const ast::ValueDefn*>(n);
+        defn(r, vd);
+        r.push_back(node(vd->type()));
+        r.push_back(node(vd->init()));
+        if (n->kind() == Kind::ENUM_VALUE) {
+          r.push_back(uint32_t(static_cast<const ast::EnumValue*>(n)->ordinal()));
+        } else if (n->kind() == Kind::PARAMETER) {
+          auto p = static_cast<const ast::Parameter*>(n);
+          r.push_back(
+              (p->isKeywordOnly() << 0) | (p->isSelfParam() << 1) | (p->isClassParam() << 2) |
+              (p->isVariadic() << 3) | (p->isExpansion() << 4));
+        }
+        break;
+      }
+
+      case Layout::TYPE_PARAMETER: {
+        auto tp = static_cast<const ast::TypeParameter*>(n);
+        defn(r, tp);
+        r.push_back(node(tp->type()));
+        r.push_back(node(tp->init()));
+        r.push_back(tp->isVariadic());
+        list(r, tp->subtypeConstraints());
+        break;
+      }
+
+      case Layout::FUNCTION: {
+        auto fn = static_cast<const ast::Function*>(n);
+        defn(r, fn);
+        r.push_back(node(fn->returnType()));
+        list(r, fn->params());
+        r.push_back(node(fn->body()));
+        r.push_back(node(fn->selfType()));
+        r.push_back(
+            (fn->isConstructor() << 0) | (fn->isRequirement() << 1) | (fn->isNative() << 2));
+        break;
+      }
+
+      case Layout::PROPERTY: {
+        auto prop = static_cast<const ast::Property*>(n);
+        defn(r, prop);
+        r.push_back(node(prop->type()));
+        list(r, prop->params());
+        r.push_back(node(prop->getter()));
+        r.push_back(node(prop->setter()));
+        r.push_back(node(prop->selfType()));
+        break;
+      }
+
+      case Layout::MODULE: {
+        auto mod = static_cast<const ast::Module*>(n);
+        list(r, mod->members());
+        list(r, mod->imports());
+        r.push_back(uint32_t(mod->spans().size()));
+        for (const ast::Span& span : mod->spans()) {
+          r.push_back(span.begin);
+          r.push_back(span.end);
+        }
+        break;
+      }
+
+      case Layout::IMPORT: {
+        auto imp = static_cast<const ast::Import*>(n);
+        r.push_back(node(imp->path()));
+        r.push_back(string(imp->alias()));
+        break;
+      }
+    }
+
+    _nodes.insert(_nodes.end(), r.begin(), r.end());
+    uint32_t index = FIRST_NODE + _nodeCount++;
+    _nodeIndex[n] = index;
+    return index;
+  }
+
+  void Writer::finish(const uint32_t* header, std::vector<uint32_t>& out) {
+    std::size_t start = out.size();
+    out.insert(out.end(), header, header + HEADER_SIZE);
+
+    // Each string is its length in bytes, followed by the text padded to a whole word.
+    for (const StringRef& str : _strings) {
+      out.push_back(uint32_t(str.size()));
+      std::size_t pos = out.size();
+      if (!str.empty()) {
+        out.resize(pos + (str.size() + 3) / 4, 0);
+        std::memcpy(out.data() + pos, str.begin(), str.size());
+      }
+    }
+    out.insert(out.end(), _nodes.begin(), _nodes.end());
+
+    out[start + H_STRING_COUNT] = uint32_t(_strings.size());
+    out[start + H_NODE_COUNT] = _nodeCount;
+    out[start + H_SIZE] = uint32_t(out.size() - start);
+  }
+
+  /** Builds an AST from the words of a cache entry. Every read is checked, so that a damaged
+      entry is rejected rather than producing a broken tree. */
+  class Reader {
+  public:
+    Reader(const uint32_t* begin, const uint32_t* end, uint32_t base,
+        source::ProgramSource* source, support::Arena& arena)
+      : _pos(begin)
+      , _end(end)
+      , _base(base)
+      , _source(source)
+      , _sourceSize(uint32_t(source->content().size()))
+      , _arena(arena)
+      , _valid(true)
+    {}
+
+    const ast::Module* read(uint32_t stringCount, uint32_t nodeCount);
+
+  private:
+    const uint32_t* _pos;
+    const uint32_t* _end;
+    uint32_t _base;
+    source::ProgramSource* _source;
+    uint32_t _sourceSize;
+    support::Arena& _arena;
+    bool _valid;
+    std::vector<StringRef> _strings;
+    std::vector<Node*> _nodes;
+
+    uint32_t word() {
+      if (_pos < _end) {
+        return *_pos++;
+      }
+      _valid = false;
+      return 0;
+    }
+
+    StringRef string() {
+      uint32_t index = word();
+      if (index < _strings.size()) {
+        return _strings[index];
+      }
+      _valid = false;
+      return StringRef();
+    }
+
+    Atom atom() {
+      StringRef str = string();
+      return str.empty() ? Atom() : Atom::intern(str);
+    }
+
+    Node* node() {
+      uint32_t ref = word();
+      if (ref == REF_NULL) {
+        return nullptr;
+      } else if (ref == REF_ABSENT) {
+        return &Node::ABSENT;
+      } else if (ref == REF_ERROR) {
+        return &Node::ERROR;
+      } else if (ref - FIRST_NODE < _nodes.size()) {
+        return _nodes[ref - FIRST_NODE];
+      }
+      _valid = false;
+      return nullptr;
+    }
+
+    /** Read a list into 'nodes'. */
+    bool list(std::vector<const Node*>& nodes) {
+      uint32_t size = word();
+      if (size > uint32_t(_end - _pos)) {
+        _valid = false;
+        return false;
+      }
+      nodes.clear();
+      for (uint32_t i = 0; i < size; ++i) {
+        nodes.push_back(node());
+      }
+      return true;
+    }
+
+    NodeList list() {
+      std::vector<const Node*> nodes;
+      if (!list(nodes) || nodes.empty()) {
+        return NodeList();
+      }
+      if (ast::NodeStats::isEnabled()) {
+        ast::NodeStats::addList(nodes.size() * sizeof(Node*));
+      }
+      return _arena.copyOf(nodes);
+    }
+
+    void defn(ast::Defn* d);
+    Node* readNode();
+  };
+
+  void Reader::defn(ast::Defn* d) {
+    uint32_t flags = word();
+    d->setPrivate(flags & (1 << 0));
+    d->setProtected(flags & (1 << 1));
+    d->setStatic(flags & (1 << 2));
+    d->setOverride(flags & (1 << 3));
+    d->setUndef(flags & (1 << 4));
+    d->setFinal(flags & (1 << 5));
+    d->setAbstract(flags & (1 << 6));
+    d->setMembers(list());
+    d->setAttributes(list());
+    d->setTypeParams(list());
+    d->setRequires(list());
+  }
+
+  Node* Reader::readNode() {
+    uint32_t kindValue = word();
+    uint32_t begin = word();
+    uint32_t length = word();
+    if (kindValue >= ast::NUM_KINDS) {
+      _valid = false;
+      return nullptr;
+    }
+    Kind kind = Kind(kindValue);
+    source::Location loc;
+    // Stored locations are one past the offset, so 'begin' may be equal to the size.
+    if (begin > _sourceSize || length > _sourceSize - (begin == 0 ? 0 : begin - 1)) {
+      _valid = false;
+      return nullptr;
+    }
+    if (begin != 0) {
+      loc.begin = _base + begin - 1;
+      loc.end = loc.begin + length;
+    }
+
+    switch (layoutOf(kind)) {
+      case Layout::UNKNOWN:
+        _valid = false;
+        return nullptr;
+
+      case Layout::NODE:
+        return new (_arena) Node(kind, loc);
+
+      case Layout::IDENT: {
+        Atom name = atom();
+        return new (_arena) ast::Ident(loc, name);
+      }
+
+      case Layout::MEMBER: {
+        Atom name = atom();
+        Node* base = node();
+        return new (_arena) ast::MemberRef(loc, name, base);
+      }
+
+      case Layout::BUILTIN_TYPE: {
+        uint32_t type = word();
+        if (type > ast::BuiltInType::F64) {
+          _valid = false;
+        }
+        return new (_arena) ast::BuiltInType(loc, ast::BuiltInType::Type(type));
+      }
+
+      case Layout::BUILTIN_ATTRIBUTE: {
+        uint32_t attribute = word();
+        if (attribute > ast::BuiltInAttribute::UNSAFE) {
+          _valid = false;
+        }
+        return new (_arena) ast::BuiltInAttribute(
+            loc, ast::BuiltInAttribute::Attribute(attribute));
+      }
+
+      case Layout::TEXT_LITERAL: {
+        StringRef value = string();
+        return new (_arena) ast::TextLiteral(kind, loc, _arena.copyOf(value));
+      }
+
+      case Layout::INTEGER_LITERAL: {
+        uint64_t value = word();
+        value |= uint64_t(word()) << 32;
+        bool uns = word() != 0;
+        return new (_arena) ast::IntegerLiteral(loc, int64_t(value), uns);
+      }
+
+      case Layout::FLOAT_LITERAL: {
+        uint32_t words[2];
+        words[0] = word();
+        words[1] = word();
+        double value;
+        std::memcpy(&value, words, sizeof(value));
+        return new (_arena) ast::FloatLiteral(loc, value);
+      }
+
+      case Layout::UNARY: {
+        Node* arg = node();
+        return new (_arena) ast::UnaryOp(kind, loc, arg);
+      }
+
+      case Layout::OPER: {
+        Node* op = node();
+        std::vector<const Node*> operands;
+        list(operands);
+        ast::Oper* result = ast::Oper::create(_arena, kind, loc, operands);
+        result->setOp(op);
+        return result;
+      }
+
+      case Layout::CONTROL: {
+        Node* test = node();
+        NodeList outcomes = list();
+        return new (_arena) ast::ControlStmt(kind, loc, test, outcomes);
+      }
+
+      case Layout::DEFERRED_BODY:
+        return new (_arena) ast::DeferredBody(loc, _source, _arena);
+
+      case Layout::TYPE_DEFN: {
+        auto td = new (_arena) ast::TypeDefn(kind, loc, atom());
+        defn(td);
+        td->setBases(list());
+        td->setFriends(list());
+        return td;
+      }
+
+      case Layout::VALUE_DEFN:
+      case Layout::ENUM_VALUE:
+      case Layout::PARAMETER: {
+        Atom name = atom();
+        ast::ValueDefn* vd;
+        if (kind == Kind::ENUM_VALUE) {
+          vd = new (_arena) ast::EnumValue(loc, name);
+        } else if (kind == Kind::PARAMETER) {
+          vd = new (_arena) ast::Parameter(loc, name);
+        } else {
+          vd = new (_arena) ast::ValueDefn(kind, loc, name);
+        }
+        defn(vd);
+        vd->setType(node());
+        vd->setInit(node());
+        if (kind == Kind::ENUM_VALUE) {
+          static_cast<ast::EnumValue*>(vd)->setOrdinal(int32_t(word()));
+        } else if (kind == Kind::PARAMETER) {
+          auto p = static_cast<ast::Parameter*>(vd);
+          uint32_t flags = word();
+          p->setKeywordOnly(flags & (1 << 0));
+          p->setSelfParam(flags & (1 << 1));
+          p->setClassParam(flags & (1 << 2));
+          p->setVariadic(flags & (1 << 3));
+          p->setExpansion(flags & (1 << 4));
+        }
+        return vd;
+      }
+
+      case Layout::TYPE_PARAMETER: {
+        auto tp = new (_arena) ast::TypeParameter(loc, atom());
+        defn(tp);
+        tp->setType(node());
+        tp->setInit(node());
+        tp->setVariadic(word() != 0);
+        tp->setSubtypeConstraints(list());
+        return tp;
+      }
+
+      case Layout::FUNCTION: {
+        auto fn = new (_arena) ast::Function(loc, atom());
+        defn(fn);
+        fn->setReturnType(node());
+        fn->setParams(list());
+        fn->setBody(node());
+        fn->setSelfType(node());
+        uint32_t flags = word();
+        fn->setConstructor(flags & (1 << 0));
+        fn->setRequirement(flags & (1 << 1));
+        fn->setNative(flags & (1 << 2));
+        return fn;
+      }
+
+      case Layout::PROPERTY: {
+        auto prop = new (_arena) ast::Property(loc, atom());
+        defn(prop);
+        prop->setType(node());
+        prop->setParams(list());
+        Node* getter = node();
+        Node* setter = node();
+        if ((getter && getter->kind() != Kind::FUNCTION) ||
+            (setter && setter->kind() != Kind::FUNCTION)) {
+          _valid = false;
+          return nullptr;
+        }
+        prop->setGetter(static_cast<ast::Function*>(getter));
+        prop->setSetter(static_cast<ast::Function*>(setter));
+        prop->setSelfType(node());
+        return prop;
+      }
+
+      case Layout::MODULE: {
+        auto mod = new (_arena) ast::Module(loc);
+        mod->setMembers(list());
+        mod->setImports(list());
+        uint32_t spanCount = word();
+        if (spanCount > uint32_t(_end - _pos) / 2) {
+          _valid = false;
+          return nullptr;
+        }
+        std::vector<ast::Span> spans(spanCount);
+        for (ast::Span& span : spans) {
+          span.begin = word();
+          span.end = word();
+          if (span.begin > span.end || span.end > _sourceSize) {
+            _valid = false;
+            return nullptr;
+          }
+        }
+        if (!spans.empty()) {
+          mod->setSpans(_arena.copyOf(spans));
+        }
+        return mod;
+      }
+
+      case Layout::IMPORT: {
+        Node* path = node();
+        Atom alias = atom();
+        return new (_arena) ast::Import(loc, path, alias);
+      }
+    }
+    return nullptr;
+  }
+
+  const ast::Module* Reader::read(uint32_t stringCount, uint32_t nodeCount) {
+    _strings.reserve(stringCount);
+    for (uint32_t i = 0; i < stringCount && _valid; ++i) {
+      uint32_t size = word();
+      uint32_t words = (size + 3) / 4;
+      if (words > uint32_t(_end - _pos)) {
+        return nullptr;
+      }
+      _strings.push_back(StringRef(reinterpret_cast<const char*>(_pos), size));
+      _pos += words;
+    }
+
+    _nodes.reserve(nodeCount);
+    for (uint32_t i = 0; i < nodeCount && _valid; ++i) {
+      Node* n = readNode();
+      if (n == nullptr) {
+        return nullptr;
+      }
+      _nodes.push_back(n);
+    }
+
+    // The module is the last node written.
+    if (!_valid || _pos != _end || _nodes.empty() || _nodes.back()->kind() != Kind::MODULE) {
+      return nullptr;
+    }
+    return static_cast<const ast::Module*>(_nodes.back());
+  }
+}
+
+Path AstCache::entryPath(source::ProgramSource* source, bool deferBodies) const {
+  StringRef content = source->content();
+  uint64_t key = hashBytes(content.begin(), content.size()) ^ versionHash();
+  char name[32];
+  snprintf(name, sizeof name, "%016llx%s.ast", (unsigned long long) key,
+      deferBodies ? "-d" : "");
+  return Path(_dir, name);
+}
+
+const ast::Module* AstCache::load(
+    source::ProgramSource* source, bool deferBodies, support::Arena& arena) const {
+  source::FileSource entry(entryPath(source, deferBodies), StringRef());
+  if (!entry.valid() || entry.content().size() < HEADER_SIZE * sizeof(uint32_t)) {
+    return nullptr;
+  }
+
+  // Mapped files are page-aligned, and read buffers are at least word-aligned.
+  StringRef content = source->content();
+  const uint32_t* words = reinterpret_cast<const uint32_t*>(entry.content().begin());
+  std::size_t size = entry.content().size() / sizeof(uint32_t);
+  uint64_t sourceHash = hashBytes(content.begin(), content.size());
+  uint64_t version = versionHash();
+  if (words[H_MAGIC] != MAGIC ||
+      words[H_FORMAT] != FORMAT_VERSION ||
+      words[H_FLAGS] != (deferBodies ? F_DEFER_BODIES : 0) ||
+      words[H_SOURCE_SIZE] != content.size() ||
+      words[H_SOURCE_HASH_LO] != uint32_t(sourceHash) ||
+      words[H_SOURCE_HASH_HI] != uint32_t(sourceHash >> 32) ||
+      words[H_VERSION_HASH_LO] != uint32_t(version) ||
+      words[H_VERSION_HASH_HI] != uint32_t(version >> 32) ||
+      words[H_SIZE] != size) {
+    return nullptr;
+  }
+
+  // An entry that fails validation partway through must not leave half its nodes behind.
+  support::ArenaCheckpoint checkpoint(arena);
+  Reader reader(words + HEADER_SIZE, words + size, source->base(), source, arena);
+  const ast::Module* module = reader.read(words[H_STRING_COUNT], words[H_NODE_COUNT]);
+  if (module != nullptr) {
+    checkpoint.keep();
+  }
+  return module;
+}
+
+bool AstCache::store(
+    source::ProgramSource* source, bool deferBodies, const ast::Module* module) const {
+  StringRef content = source->content();
+  Writer writer(source->base(), uint32_t(content.size()));
+  writer.node(module);
+  if (!writer.valid()) {
+    return false;
+  }
+
+  uint64_t sourceHash = hashBytes(content.begin(), content.size());
+  uint64_t version = versionHash();
+  uint32_t header[HEADER_SIZE] = { 0 };
+  header[H_MAGIC] = MAGIC;
+  header[H_FORMAT] = FORMAT_VERSION;
+  header[H_FLAGS] = deferBodies ? F_DEFER_BODIES : 0;
+  header[H_SOURCE_SIZE] = uint32_t(content.size());
+  header[H_SOURCE_HASH_LO] = uint32_t(sourceHash);
+  header[H_SOURCE_HASH_HI] = uint32_t(sourceHash >> 32);
+  header[H_VERSION_HASH_LO] = uint32_t(version);
+  header[H_VERSION_HASH_HI] = uint32_t(version >> 32);
+  std::vector<uint32_t> words;
+  writer.finish(header, words);
+
+  // Write to a temporary file and rename it into place, so that a reader never sees a partly
+  // written entry, even if another thread or process is storing the same one.
+  static std::atomic<unsigned> tempCounter(0);
+  Path path = entryPath(source, deferBodies);
+  char suffix[48];
+  snprintf(suffix, sizeof suffix, ".%ld.%u.tmp", long(::getpid()), tempCounter++);
+  std::string tempPath(path.c_str());
+  tempPath += suffix;
+  {
+    std::ofstream out(tempPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint32_t));
+    if (!out.good()) {
+      out.close();
+      ::remove(tempPath.c_str());
+      return false;
+    }
+  }
+  if (::rename(tempPath.c_str(), path.c_str()) != 0) {
+    ::remove(tempPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+}}
@@ -0,0 +1,72 @@
+// ============================================================================
+// astcache.h: On-disk cache of parsed modules.
+// ============================================================================
+
+#ifndef SPARK_COMPILER_ASTCACHE_H
+#define SPARK_COMPILER_ASTCACHE_H 1
+
+#ifndef SPARK_SUPPORT_PATH_H
+  #include "spark/support/path.h"
+#endif
+
+#if SPARK_HAVE_STDINT_H
+  #include <stdint.h>
+#endif
+
+namespace spark {
+namespace ast {
+class Module;
+}
+namespace source {
+class ProgramSource;
+}
+namespace support {
+class Arena;
+}
+namespace compiler {
+using support::Path;
+
+/** A directory of serialized module ASTs, so that source files which haven't changed since the
+    last build don't need to be parsed again. Entries are named by a hash of the source text and
+    the compiler version, and also record both, so an entry is never used with a different
+    source or by a compiler that would have parsed it differently.
+
+    An entry is a flat array of 32-bit words: a header, a string table, and then the nodes in
+    post-order, each referring to its children by index. Source locations are stored relative to
+    the start of the file, and names as strings, so an entry doesn't depend on where the file is
+    placed in the source manager's offset space or on the state of the atom table. Loading maps
+    the entry and builds the nodes directly in the module's arena.
+
+    Only modules that were parsed without errors are stored. The cache may be used from several
+    threads at once. */
+class AstCache {
+public:
+  /** Version of the entry format. This must be changed whenever the format, or the AST that
+      the parser produces, changes. */
+  static const uint32_t FORMAT_VERSION = 2;
+
+  AstCache(const Path& dir) : _dir(dir) {}
+
+  /** The cache directory. */
+  const Path& dir() const { return _dir; }
+
+  /** Return the AST for 'source' from the cache, allocated in 'arena', or nullptr if there is
+      no valid entry for it. 'deferBodies' selects entries in which function bodies were
+      skipped (see Parser::setDeferBodies()); these are kept separately from complete ones. */
+  const ast::Module* load(
+      source::ProgramSource* source, bool deferBodies, support::Arena& arena) const;
+
+  /** Save the AST for 'source' in the cache, replacing any previous entry. Returns false if the
+      entry couldn't be written. */
+  bool store(source::ProgramSource* source, bool deferBodies, const ast::Module* module) const;
+
+  /** Path of the cache entry for 'source'. */
+  Path entryPath(source::ProgramSource* source, bool deferBodies) const;
+
+private:
+  Path _dir;
+};
+
+}}
+
+#endif
@@ -1,4 +1,5 @@
 #include "spark/ast/module.h"
+#include "spark/compiler/astcache.h"
 #include "spark/compiler/compiler.h"
 #include "spark/compiler/contextimpl.h"
 #include "spark/compiler/fsimport.h"
@@ -9,23 +10,61 @@
 #include "spark/support/path.h"
 #include "spark/sema/passes/buildgraph.h"
 #include "spark/sema/passes/nameresolution.h"
+#include "spark/sema/types/typestore.h"
 #include "spark/semgraph/module.h"
 
+#if SPARK_HAVE_ALGORITHM
+  #include <algorithm>
+#endif
+
+#if SPARK_HAVE_ATOMIC
+  #include <atomic>
+#endif
+
+#if SPARK_HAVE_IOSTREAM
+  #include <iostream>
+#endif
+
 #if SPARK_HAVE_DIRENT_H
   #include <dirent.h>
 #endif
 
+#if SPARK_HAVE_STDIO_H
+  #include <stdio.h>
+#endif
+
 #if SPARK_HAVE_SYS_STAT_H
   #include <sys/stat.h>
 #endif
 
+#if SPARK_HAVE_THREAD
+  #include <thread>
+#endif
+
 namespace spark {
 namespace compiler {
 using spark::collections::StringRef;
 using spark::support::Path;
 using spark::support::PathIterator;
 
-Compiler::Compiler(Reporter& reporter) : _reporter(reporter) {
+namespace {
+  /** A source file that is parsed on a worker thread. */
+  struct ParsedFile {
+    std::unique_ptr<source::ProgramSource> source;
+    std::unique_ptr<semgraph::Module> module;
+    const ast::Module* ast;
+    error::BufferedReporter diagnostics;
+
+    ParsedFile() : ast(nullptr) {}
+  };
+}
+
+Compiler::Compiler(Reporter& reporter)
+  : _reporter(reporter)
+  , _jobs(1)
+  , _astStats(false)
+  , _memoryStats(false)
+{
   _context.reset(new ContextImpl(reporter, *this));
   _fsImporter = new FileSystemImporter(*_context.get());
   _currentDir = support::Path::curdir();
@@ -49,10 +88,13 @@ Compiler::Compiler(Reporter& reporter) : _reporter(reporter) {
   // Name resolution phase
   phase = new compiler::Phase(
       _context.get(), "name resolution", _context->sourceModules());
-  phase->addPass(new spark::sema::passes::NameResolutionPass(_context.get()));
+  _nameResolution = new spark::sema::passes::NameResolutionPass(_context.get());
+  phase->addPass(_nameResolution);
   _phases.push_back(phase);
 }
 
+Compiler::~Compiler() {}
+
 void Compiler::setSourceRoot(const StringRef& path) {
   _sourceRoot = Path(_currentDir, path);
 }
@@ -69,7 +111,24 @@ void Compiler::setOutputDir(const StringRef& path) {
   _outputDir = Path(_currentDir, path);
 }
 
+void Compiler::setJobs(unsigned jobs) {
+  _jobs = jobs;
+}
+
 void Compiler::compile() {
+  if (_astStats) {
+    ast::NodeStats::enable();
+  }
+
+  if (!_outputDir.empty()) {
+    Path cacheDir(_outputDir, "astcache");
+    if (cacheDir.makeDirs()) {
+      _astCache.reset(new AstCache(cacheDir));
+    } else {
+      _reporter.warn() << "Unable to create AST cache directory '" << cacheDir << "'.";
+    }
+  }
+
   if (!_sourceRoot.empty()) {
     // If a source root has been specified, then use that as the root directory for sources.
     _fsImporter->addPath(_sourceRoot);
@@ -90,10 +149,25 @@ void Compiler::compile() {
     parseSource(path);
   }
   runPhases();
+
+  if (_astStats) {
+    ast::NodeStats::print(std::cerr);
+  }
+  if (_memoryStats) {
+    printMemoryStats(std::cerr);
+  }
 //     if self.outputDir:
 //       self.writePackageAliases()
 }
 
+const ModuleList& Compiler::sourceModules() const {
+  return _context->sourceModules();
+}
+
+sema::passes::TypeMemoStats Compiler::typeMemoStats(const semgraph::Module* mod) const {
+  return _nameResolution->typeMemoStats(mod);
+}
+
 void Compiler::parseSource(const Path& path) {
   if (!path.exists()) {
     _reporter.error() << "File not found: " << path;
@@ -111,8 +185,9 @@ semgraph::Module* Compiler::parseImportSource(const Path& path) {
   } else if (path.isDir()) {
     _reporter.error() << "Attempt to import a directory: " << path;
   } else {
-    // Parse the file and add to the 'modules' set.
-    processFile(path, modules);
+    // Parse the file and add to the 'modules' set. Only the declarations of an imported module
+    // are needed to resolve the import, so function bodies are left until something asks for them.
+    processFile(path, modules, true);
     // Also add to the sourceImportModules set.
     _context->sourceImportModules().insert(
         _context->sourceImportModules().end(), modules.begin(), modules.end());
@@ -129,29 +204,117 @@ semgraph::Module* Compiler::parseImportSource(const Path& path) {
 }
 
 void Compiler::processDir(const Path& path, ModuleList& modules) {
+  std::vector<Path> files;
+  collectFiles(path, files);
+  processFiles(files, modules);
+}
+
+void Compiler::collectFiles(const Path& path, std::vector<Path>& files) {
+  // Directory entries are sorted, so that modules are always processed in the same order.
+  std::vector<std::string> names;
   PathIterator iter = path.iterate();
   StringRef name;
   while (iter.next(name)) {
-    if (_reporter.errorCount() > 10) {
-      break;
-    }
+    names.push_back(std::string(name.begin(), name.size()));
+  }
+  std::sort(names.begin(), names.end());
+  for (const std::string& entryName : names) {
+    StringRef name(entryName);
     Path entry(path, name);
     if (entry.isDir() && name != "." && name != "..") {
-      processDir(entry, modules);
+      collectFiles(entry, files);
     } else if (entry.isFile() && name.endsWith(".sp")) {
-      processFile(entry, modules);
+      files.push_back(entry);
     }
   }
 }
 
-void Compiler::processFile(const Path& path, ModuleList& modules) {
+void Compiler::processFiles(const std::vector<Path>& files, ModuleList& modules) {
+  unsigned jobs = _jobs;
+  #if SPARK_HAVE_THREAD
+    if (jobs == 0) {
+      jobs = std::max(1u, std::thread::hardware_concurrency());
+    }
+  #else
+    jobs = 1;
+  #endif
+  jobs = unsigned(std::min<size_t>(jobs, files.size()));
+  if (jobs <= 1) {
+    for (const Path& path : files) {
+      if (_reporter.errorCount() > 10) {
+        break;
+      }
+      processFile(path, modules);
+    }
+    return;
+  }
+
+  #if SPARK_HAVE_THREAD
+    // Open the files and create their modules up front, in path order, so that source offsets
+    // are assigned in a fixed order. Modules are placed in their packages below, since the
+    // package tree isn't thread-safe.
+    std::vector<ParsedFile> parsed(files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+      const Path& path = files[i];
+      ParsedFile& pf = parsed[i];
+      pf.source.reset(new source::FileSource(path, path.str()));
+      if (pf.source->valid()) {
+        pf.module.reset(new semgraph::Module(pf.source.get(), path.stem()));
+        pf.source->base();
+      }
+    }
+
+    // Parse on worker threads. Each file's messages are saved until it is added below.
+    std::atomic<size_t> nextFile(0);
+    auto parseFiles = [this, &parsed, &nextFile]() {
+      for (;;) {
+        size_t i = nextFile++;
+        if (i >= parsed.size()) {
+          break;
+        }
+        ParsedFile& pf = parsed[i];
+        if (pf.module) {
+          pf.ast = parseModule(pf.diagnostics, pf.source.get(), pf.module.get(), false);
+        }
+      }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < jobs; ++i) {
+      workers.push_back(std::thread(parseFiles));
+    }
+    parseFiles();
+    for (std::thread& worker : workers) {
+      worker.join();
+    }
+
+    // Report messages and add modules in path order, just as a serial build would. Files
+    // past the point where a serial build would stop are discarded along with their modules.
+    for (size_t i = 0; i < files.size(); ++i) {
+      if (_reporter.errorCount() > 10) {
+        break;
+      }
+      ParsedFile& pf = parsed[i];
+      if (!pf.module) {
+        reportOpenError(files[i]);
+        continue;
+      }
+      semgraph::Package* package = _fsImporter->getPackageForPath(files[i].parent());
+      assert(package != nullptr);
+      pf.module->setDefinedIn(package);
+      pf.diagnostics.replay(_reporter);
+      if (pf.ast != nullptr) {
+        pf.source.release();
+        addModule(package, pf.module.release(), pf.ast, files[i], modules);
+      }
+    }
+  #endif
+}
+
+void Compiler::processFile(const Path& path, ModuleList& modules, bool deferBodies) {
   source::ProgramSource* src = new source::FileSource(path, path.str());
   if (!src->valid()) {
-    if (!path.exists()) {
-      _reporter.error() << "File '" << path << "' not found.\n";
-    } else {
-      _reporter.error() << "Unable to open file '" << path << "' for reading.\n";
-    }
+    delete src;
+    reportOpenError(path);
     return;
   }
 
@@ -165,14 +328,121 @@ void Compiler::processFile(const Path& path, ModuleList& modules) {
   semgraph::Package* package = _fsImporter->getPackageForPath(path.parent());
   assert(package != nullptr);
   semgraph::Module* module = new semgraph::Module(src, path.stem(), package);
-  parse::Parser parser(_reporter, src, module->astArena());
-  const ast::Module* modAst = parser.module();
+  const ast::Module* modAst = parseModule(_reporter, src, module, deferBodies);
   if (modAst != nullptr) {
-    module->setAst(modAst);
-    module->path() = path;
-    modules.push_back(module);
-    package->addModule(module);
-    _context->setModuleSetsChanged(true);
+    addModule(package, module, modAst, path, modules);
+  }
+}
+
+const ast::Module* Compiler::parseModule(Reporter& reporter, source::ProgramSource* src,
+    semgraph::Module* module, bool deferBodies) {
+  if (src->base() == 0) {
+    reporter.error() << "Too much source text: no room for locations in '" << src->path() <<
+        "'.";
+    return nullptr;
+  }
+
+  if (_astCache) {
+    const ast::Module* modAst = _astCache->load(src, deferBodies, module->astArena());
+    if (modAst != nullptr) {
+      return modAst;
+    }
+  }
+
+  int errorCount = reporter.errorCount();
+  parse::Parser parser(reporter, src, module->astArena());
+  parser.setDeferBodies(deferBodies);
+  const ast::Module* modAst = parser.module();
+  if (_astCache && modAst != nullptr && reporter.errorCount() == errorCount) {
+    _astCache->store(src, deferBodies, modAst);
+  }
+  return modAst;
+}
+
+void Compiler::reportOpenError(const Path& path) {
+  if (!path.exists()) {
+    _reporter.error() << "File '" << path << "' not found.\n";
+  } else {
+    _reporter.error() << "Unable to open file '" << path << "' for reading.\n";
+  }
+}
+
+void Compiler::addModule(
+    semgraph::Package* package, semgraph::Module* module, const ast::Module* modAst,
+    const Path& path, ModuleList& modules) {
+  module->setAst(modAst);
+  module->path() = path;
+  modules.push_back(module);
+  package->addModule(module);
+  _context->setModuleSetsChanged(true);
+}
+
+namespace {
+  /** Arenas of one kind, and their combined counts. */
+  struct ArenaTotals {
+    ArenaTotals(const char* name) : name(name), count(0) {}
+
+    void add(const support::Arena& arena) {
+      stats += arena.stats();
+      ++count;
+    }
+
+    const char* name;
+    std::size_t count;
+    support::ArenaStats stats;
+  };
+
+  void printArenaTotals(std::ostream& out, const ArenaTotals& totals) {
+    char line[120];
+    const support::ArenaStats& s = totals.stats;
+    snprintf(line, sizeof line, "  %-12s %6zu %12zu %12zu %12zu %8zu %8zu %9zu %10zu\n",
+        totals.name, totals.count, s.requested, s.allocated, s.reserved, s.blocks, s.recycled,
+        s.oversized, s.wasted);
+    out << line;
+  }
+}
+
+void Compiler::printMemoryStats(std::ostream& out) {
+  std::vector<semgraph::Module*> modules(
+      _context->sourceModules().begin(), _context->sourceModules().end());
+  modules.insert(modules.end(),
+      _context->sourceImportModules().begin(), _context->sourceImportModules().end());
+
+  ArenaTotals astTotals("ast");
+  ArenaTotals sgTotals("semgraph");
+  for (semgraph::Module* mod : modules) {
+    astTotals.add(mod->astArena());
+    sgTotals.add(mod->sgArena());
+  }
+  ArenaTotals typeTotals("types");
+  typeTotals.add(_context->typeStore()->arena());
+  ArenaTotals contextTotals("context");
+  contextTotals.add(_context->arena());
+  ArenaTotals total("total");
+  for (const ArenaTotals* t : { &astTotals, &sgTotals, &typeTotals, &contextTotals }) {
+    total.count += t->count;
+    total.stats += t->stats;
+  }
+
+  char line[120];
+  out << "Arena memory:\n";
+  snprintf(line, sizeof line, "  %-12s %6s %12s %12s %12s %8s %8s %9s %10s\n", "arena",
+      "count", "requested", "allocated", "reserved", "blocks", "recycled", "oversized", "wasted");
+  out << line;
+  for (const ArenaTotals* t : { &astTotals, &sgTotals, &typeTotals, &contextTotals, &total }) {
+    printArenaTotals(out, *t);
+  }
+
+  out << "Arena memory by module:\n";
+  snprintf(line, sizeof line, "  %-40s %12s %12s %12s %12s\n", "module", "ast alloc",
+      "ast reserved", "sg alloc", "sg reserved");
+  out << line;
+  for (semgraph::Module* mod : modules) {
+    const support::ArenaStats& as = mod->astArena().stats();
+    const support::ArenaStats& ss = mod->sgArena().stats();
+    snprintf(line, sizeof line, "  %-40s %12zu %12zu %12zu %12zu\n",
+        mod->qualifiedName().c_str(), as.allocated, as.reserved, ss.allocated, ss.reserved);
+    out << line;
   }
 }
 
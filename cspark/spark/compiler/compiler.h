@@ -37,21 +37,37 @@
   #include <memory>
 #endif
 
+#if SPARK_HAVE_OSTREAM
+  #include <ostream>
+#endif
+
 namespace spark {
+namespace ast {
+class Module;
+}
+namespace source {
+class ProgramSource;
+}
 namespace support {
 class Path;
 }
 namespace semgraph {
 class Module;
+class Package;
 }
 namespace sema {
 class Pass;
+namespace passes {
+class NameResolutionPass;
+struct TypeMemoStats;
+}
 }
 namespace compiler {
 using collections::StringRef;
 using error::Reporter;
 using support::Path;
 
+class AstCache;
 class Context;
 class ContextImpl;
 class FileSystemImporter;
@@ -63,6 +79,10 @@ typedef std::unordered_set<semgraph::Module*> ModuleSet;
 class Compiler {
 public:
   Compiler(Reporter& reporter);
+  ~Compiler();
+
+  /** The version of the compiler. */
+  static const char* version() { return "0.1"; }
 
   /** The error reporter for this compiler instance. */
   Reporter& reporter() const { return _reporter; }
@@ -81,12 +101,34 @@ public:
   const std::vector<Path>& modulePaths() const { return _modulePaths; }
   void addModulePath(const StringRef& path);
 
-  /** Output directory. */
+  /** Output directory. If set, parsed modules are also cached in the 'astcache' subdirectory,
+      and later builds load unchanged source files from the cache instead of parsing them. */
   const Path& outputDir() const { return _outputDir; }
   void setOutputDir(const StringRef& path);
 
+  /** Number of threads used to parse source files. Zero means one per hardware thread. The
+      results, including any error messages, are the same for any number of threads. */
+  unsigned jobs() const { return _jobs; }
+  void setJobs(unsigned jobs);
+
+  /** If true, print the number and size of the AST nodes allocated, by kind, at the end of
+      compilation. */
+  bool astStats() const { return _astStats; }
+  void setAstStats(bool enable) { _astStats = enable; }
+
+  /** If true, print the memory held by each kind of arena, and by each module, at the end of
+      compilation. */
+  bool memoryStats() const { return _memoryStats; }
+  void setMemoryStats(bool enable) { _memoryStats = enable; }
+
   void compile();
 
+  /** Modules parsed from the source files, in the order they were added. */
+  const ModuleList& sourceModules() const;
+
+  /** How the type expressions in the source module 'mod' were resolved. */
+  sema::passes::TypeMemoStats typeMemoStats(const semgraph::Module* mod) const;
+
 private:
   friend class spark::compiler::ContextImpl;
 
@@ -96,19 +138,32 @@ private:
   std::vector<Path> _modulePaths;
   Path _outputDir;
   support::Path _currentDir;
+  unsigned _jobs;
+  bool _astStats;
+  bool _memoryStats;
 
   std::auto_ptr<Context> _context;
+  std::unique_ptr<AstCache> _astCache;
   FileSystemImporter* _fsImporter; // This is actually owned by the module path scope
   std::vector<Phase*> _phases;
   Phase* _importGraphBuilder;
+  sema::passes::NameResolutionPass* _nameResolution; // Owned by its phase
 
   void parseSource(const support::Path& sourcePath);
   semgraph::Module* parseImportSource(const Path& path);
   void processDir(const support::Path& path, ModuleList& modules);
-  void processFile(const support::Path& path, ModuleList& modules);
+  void collectFiles(const support::Path& path, std::vector<Path>& files);
+  void processFiles(const std::vector<Path>& files, ModuleList& modules);
+  void processFile(const support::Path& path, ModuleList& modules, bool deferBodies = false);
+  const ast::Module* parseModule(Reporter& reporter, source::ProgramSource* src,
+      semgraph::Module* module, bool deferBodies);
+  void reportOpenError(const support::Path& path);
+  void addModule(semgraph::Package* package, semgraph::Module* module,
+      const ast::Module* modAst, const Path& path, ModuleList& modules);
   bool shortPath(support::Path& path);
 
   void runPhases();
+  void printMemoryStats(std::ostream& out);
 
 //   def addModulePath(self, path):
 //     self.basePaths.append(path)
@@ -9,6 +9,7 @@ namespace compiler {
 
 ContextImpl::ContextImpl(Reporter& reporter, Compiler& compiler)
   : _reporter(reporter)
+  , _arena("context")
   , _moduleSetsChanged(false)
   , _modulePathScope(new scope::ModulePathScope())
   , _typeStore(new sema::types::TypeStore())
@@ -18,11 +18,10 @@ DirectoryScope::DirectoryScope(const Path& path, semgraph::Package* parent, Cont
 {
   assert(path.isDir());
   Path packageOpts(path, "package.txt");
-  auto& arena = _context.arena();
   if (packageOpts.isFile()) {
     std::ifstream strm(packageOpts.c_str());
     std::string line;
-    std::vector<StringRef> parts;
+    std::vector<Atom> parts;
     while (std::getline(strm, line)) {
       if (line.empty()) {
         continue;
@@ -36,7 +35,7 @@ DirectoryScope::DirectoryScope(const Path& path, semgraph::Package* parent, Cont
         if (end == std::string::npos) {
           end = line.size();
         }
-        parts.push_back(arena.copyOf(lineStr.substr(pos, end)));
+        parts.push_back(Atom::intern(lineStr.substr(pos, end)));
         pos = end + 1;
       }
       if (parts.size() < 2) {
@@ -52,7 +51,7 @@ DirectoryScope::DirectoryScope(const Path& path, semgraph::Package* parent, Cont
   StringRef name;
   while (iter.next(name)) {
     if (name != "." && name != "..") {
-      _filenames.insert(arena.copyOf(name));
+      _filenames.insert(Atom::intern(name));
     }
   }
 }
@@ -65,7 +64,7 @@ void DirectoryScope::addMember(Member* m) {
   _entries[m->name()].push_back(m);
 }
 
-void DirectoryScope::lookupName(const StringRef& name, std::vector<Member*> &result) const {
+void DirectoryScope::lookupName(Atom name, std::vector<Member*> &result) const {
   // See if the name is an alias for a longer name.
   if (lookupAliasName(name, result)) {
     return;
@@ -75,13 +74,13 @@ void DirectoryScope::lookupName(const StringRef& name, std::vector<Member*> &res
   lookupFsName(name, result);
 }
 
-bool DirectoryScope::lookupAliasName(const StringRef& name, std::vector<Member*> &result) const {
-  auto it = _aliases.find(name.str());
+bool DirectoryScope::lookupAliasName(Atom name, std::vector<Member*> &result) const {
+  auto it = _aliases.find(name);
   if (it != _aliases.end()) {
     std::vector<Member*> members;
     std::vector<Member*> nextMembers;
     bool first = true;
-    for (StringRef part : it->second) {
+    for (Atom part : it->second) {
       if (first) {
         first = false;
         // Check the filesystem for the expansion of the alias.
@@ -106,8 +105,7 @@ bool DirectoryScope::lookupAliasName(const StringRef& name, std::vector<Member*>
   return false;
 }
 
-bool DirectoryScope::lookupFsName(
-    const StringRef& name, std::vector<Member*> &result) const {
+bool DirectoryScope::lookupFsName(Atom name, std::vector<Member*> &result) const {
   auto it = _entries.find(name);
   if (it != _entries.end()) {
     result.insert(result.end(), it->second.begin(), it->second.end());
@@ -154,7 +152,7 @@ bool DirectoryScope::lookupFsName(
 }
 
 void DirectoryScope::forAllNames(scope::NameFunctor& nameFn) const {
-  for (auto name : _filenames) {
+  for (Atom name : _filenames) {
     Path filePath(name);
     nameFn(filePath.stem());
   }
@@ -169,7 +167,9 @@ void DirectoryScope::describe(std::ostream& strm) const {
 
 bool DirectoryScope::fileExistsWithSameCase(const Path& path) const {
   if (path.isFile()) {
-    return _filenames.find(path.name()) != _filenames.end();
+    // A name that was never interned can't be in the listing.
+    Atom name = Atom::find(path.name());
+    return !name.isNull() && _filenames.find(name) != _filenames.end();
   }
   return false;
 }
@@ -187,8 +187,7 @@ void FileSystemImporter::addPath(const Path& path) {
   _roots.push_back(package);
 }
 
-void FileSystemImporter::lookupName(
-    const StringRef& name, std::vector<Member*> &result) {
+void FileSystemImporter::lookupName(Atom name, std::vector<Member*> &result) {
   for (semgraph::Package* root : _roots) {
     root->memberScope()->lookupName(name, result);
   }
@@ -210,7 +209,13 @@ semgraph::Package* FileSystemImporter::getPackageForPath(const Path& path) {
         semgraph::Package* pkg = root;
         // Now use the remaining parts to drill down into the package hierarchy.
         for (StringRef name : pathParts) {
-          std::vector<Member*> packages = pkg->memberScope()->lookupName(name);
+          // Directory listings intern every entry, so a name that was never interned isn't
+          // a package.
+          Atom atom = Atom::find(name);
+          if (atom.isNull()) {
+            return nullptr;
+          }
+          std::vector<Member*> packages = pkg->memberScope()->lookupName(atom);
           assert(packages.size() == 1);
           assert(packages.front()->kind() == Member::Kind::PACKAGE);
           pkg = static_cast<semgraph::Package*>(packages.front());
@@ -31,6 +31,7 @@ namespace compiler {
 class Context;
 
 using collections::ArrayRef;
+using collections::Atom;
 using collections::SmallSetBase;
 using collections::StringRef;
 using support::Path;
@@ -41,26 +42,26 @@ class DirectoryScope : public scope::SymbolScope {
 public:
   DirectoryScope(const Path& path, semgraph::Package* parent, Context& context);
   ScopeType scopetype() const;
-  void lookupName(const StringRef& name, std::vector<semgraph::Member*> &result) const;
+  void lookupName(Atom name, std::vector<semgraph::Member*> &result) const;
   void forAllNames(scope::NameFunctor& nameFn) const;
   void describe(std::ostream& strm) const;
 
   /** Add a member to this scope. */
   void addMember(semgraph::Member* m);
 private:
-  bool lookupAliasName(const StringRef& name, std::vector<semgraph::Member*> &result) const;
-  bool lookupFsName(const StringRef& name, std::vector<semgraph::Member*> &result) const;
+  bool lookupAliasName(Atom name, std::vector<semgraph::Member*> &result) const;
+  bool lookupFsName(Atom name, std::vector<semgraph::Member*> &result) const;
 
   // Returns true if the given file exists in this directory and has the same case. This is
   // a workaround for case-insensitive but case-preserving file systems.
   bool fileExistsWithSameCase(const Path& path) const;
 
-  typedef std::unordered_map<StringRef, std::vector<semgraph::Member*>> EntryMap;
+  typedef std::unordered_map<Atom, std::vector<semgraph::Member*>> EntryMap;
 
   Context& _context;
   mutable EntryMap _entries;
-  std::unordered_map<StringRef, std::vector<StringRef> > _aliases;
-  std::unordered_set<StringRef> _filenames;
+  std::unordered_map<Atom, std::vector<Atom> > _aliases;
+  std::unordered_set<Atom> _filenames;
   const Path _path;
   semgraph::Package* _parent;
 };
@@ -78,7 +79,7 @@ public:
       corresponds to that directory. */
   semgraph::Package* getPackageForPath(const Path& path);
 
-  void lookupName(const StringRef& name, std::vector<semgraph::Member*> &result);
+  void lookupName(Atom name, std::vector<semgraph::Member*> &result);
 
 private:
   std::vector<semgraph::Package*> _roots;
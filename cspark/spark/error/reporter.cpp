@@ -1,5 +1,6 @@
 #include "spark/error/reporter.h"
 #include "spark/source/programsource.h"
+#include "spark/source/sourcemanager.h"
 
 #if SPARK_HAVE_CASSERT
   #include <cassert>
@@ -108,8 +109,9 @@ void ConsoleReporter::report(Severity sev, Location loc, StringRef msg) {
   #endif
 
   bool showErrorLine = false;
-  if (loc.source != nullptr && !loc.source->path().empty()) {
-    std::cerr << loc.source->path() << ":" << loc.startLine << ":" << loc.startCol << ": ";
+  source::DecodedLocation dloc;
+  if (source::SourceManager::get().decode(loc, dloc) && !dloc.source->path().empty()) {
+    std::cerr << dloc.source->path() << ":" << dloc.startLine << ":" << dloc.startCol << ": ";
     showErrorLine = true;
   }
 
@@ -130,11 +132,11 @@ void ConsoleReporter::report(Severity sev, Location loc, StringRef msg) {
       }
     #endif
 
-    std::string line;
-    if (loc.source->getLine(loc.startLine - 1, line)) {
-      uint32_t beginCol = loc.startCol - 1;
-      uint32_t endCol = loc.endCol - 1;
-      if (loc.endLine > loc.startLine) {
+    StringRef line;
+    if (dloc.source->getLine(dloc.startLine - 1, line)) {
+      uint32_t beginCol = dloc.startCol - 1;
+      uint32_t endCol = dloc.endCol - 1;
+      if (dloc.endLine > dloc.startLine) {
         endCol = line.size();
       }
       std::cerr << line << "\n";
@@ -166,6 +168,29 @@ void ConsoleReporter::report(Severity sev, Location loc, StringRef msg) {
   }
 }
 
+void BufferedReporter::report(Severity sev, Location loc, StringRef msg) {
+  if (sev == ERROR || sev == FATAL) {
+    _errorCount += 1;
+  }
+  Message m;
+  m.severity = sev;
+  m.location = loc;
+  m.indent = _indentLevel;
+  m.text.assign(msg.begin(), msg.end());
+  _messages.push_back(std::move(m));
+}
+
+void BufferedReporter::replay(Reporter& target) {
+  int baseLevel = target.indentLevel();
+  for (const Message& m : _messages) {
+    target.setIndentLevel(baseLevel + m.indent);
+    target.report(m.severity, m.location, m.text);
+  }
+  target.setIndentLevel(baseLevel);
+  _messages.clear();
+  _errorCount = 0;
+}
+
 void ConsoleReporter::printStackTrace(int skipFrames) {
 #if SPARK_HAVE_BACKTRACE
   static void* stackTrace[256];
@@ -17,6 +17,14 @@
   #include <sstream>
 #endif
 
+#if SPARK_HAVE_STRING
+  #include <string>
+#endif
+
+#if SPARK_HAVE_VECTOR
+  #include <vector>
+#endif
+
 namespace spark {
 namespace error {
 using spark::collections::StringRef;
@@ -173,6 +181,34 @@ private:
   void resetColor();
 };
 
+/** Reporter that saves messages so that they can be passed on to another reporter later.
+    Used when work is done in parallel, so that messages can still be delivered in a
+    deterministic order. */
+class BufferedReporter : public IndentingReporter {
+public:
+  BufferedReporter() : _errorCount(0) {}
+
+  void report(Severity sev, Location loc, StringRef msg);
+
+  /** Number of errors saved so far. */
+  int errorCount() const { return _errorCount; }
+
+  /** Pass all saved messages on to 'target', in the order they were reported, and clear the
+      buffer. Indentation is relative to the current indent level of 'target'. */
+  void replay(Reporter& target);
+
+private:
+  struct Message {
+    Severity severity;
+    Location location;
+    int indent;
+    std::string text;
+  };
+
+  std::vector<Message> _messages;
+  int _errorCount;
+};
+
 /** Convenience class that increases indentation level within a scope. */
 class AutoIndent {
 public:
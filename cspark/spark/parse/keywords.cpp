@@ -0,0 +1,117 @@
+// ============================================================================
+// keywords.cpp: Keyword recognition.
+// ============================================================================
+
+#include "spark/parse/keywords.h"
+
+#if SPARK_HAVE_CSTRING
+  #include <cstring>
+#endif
+
+namespace spark {
+namespace parse {
+
+namespace {
+  #define KEYWORD(text, token) { text, sizeof(text) - 1, token }
+
+  #undef DEFINE_TOKEN
+  #define DEFINE_TOKEN(name)
+  #define DEFINE_KEYWORD(name, text) KEYWORD(text, TOKEN_##name),
+
+  constexpr Keyword KEYWORDS[] = {
+    #include "spark/parse/tokens.txt"
+  };
+
+  #undef DEFINE_TOKEN
+  #undef KEYWORD
+
+  constexpr size_t NUM_KEYWORDS = sizeof(KEYWORDS) / sizeof(KEYWORDS[0]);
+
+  /** Multiplier for the keyword hash. If adding a keyword causes a collision, pick another odd
+      constant that keeps the table collision-free. */
+  constexpr uint32_t HASH_MULTIPLIER = 0xb248d625u;
+
+  /** Number of slots in the hash table (must be a power of 2, at most 256). */
+  constexpr uint32_t HASH_BITS = 8;
+  constexpr uint32_t HASH_SLOTS = 1u << HASH_BITS;
+  constexpr uint8_t EMPTY_SLOT = 0xff;
+
+  /** The hash key is made from the length and the first, next-to-last and last characters. */
+  constexpr uint32_t keywordHash(const char* text, uint32_t length) {
+    return ((uint8_t(text[0])
+        | uint32_t(uint8_t(text[length - 2])) << 8
+        | uint32_t(uint8_t(text[length - 1])) << 16
+        | length << 24) * HASH_MULTIPLIER) >> (32 - HASH_BITS);
+  }
+
+  constexpr uint32_t entryHash(size_t index) {
+    return keywordHash(KEYWORDS[index].text, KEYWORDS[index].length);
+  }
+
+  /** Bitmask of keyword lengths, used to reject most identifiers without hashing them. */
+  constexpr uint32_t lengthMask(size_t index) {
+    return index == NUM_KEYWORDS ? 0 : (1u << KEYWORDS[index].length) | lengthMask(index + 1);
+  }
+
+  constexpr uint32_t KEYWORD_LENGTHS = lengthMask(0);
+
+  constexpr bool validLengths(size_t index) {
+    return index == NUM_KEYWORDS ||
+        (KEYWORDS[index].length >= 2 && KEYWORDS[index].length < 32 && validLengths(index + 1));
+  }
+
+  constexpr bool uniqueFrom(size_t index, size_t other) {
+    return other == NUM_KEYWORDS ||
+        (entryHash(index) != entryHash(other) && uniqueFrom(index, other + 1));
+  }
+
+  constexpr bool collisionFree(size_t index) {
+    return index == NUM_KEYWORDS || (uniqueFrom(index, index + 1) && collisionFree(index + 1));
+  }
+
+  static_assert(NUM_KEYWORDS < EMPTY_SLOT, "Too many keywords for the slot table.");
+  static_assert(validLengths(0), "Keyword lengths must be between 2 and 31.");
+  static_assert(collisionFree(0), "Keyword hash has a collision; change HASH_MULTIPLIER.");
+
+  /** Index of the keyword whose hash is 'hash', or EMPTY_SLOT. */
+  constexpr uint8_t slotFor(uint32_t hash, size_t index) {
+    return index == NUM_KEYWORDS ? EMPTY_SLOT :
+        entryHash(index) == hash ? uint8_t(index) : slotFor(hash, index + 1);
+  }
+
+  #define SLOT_1(h) slotFor(h, 0)
+  #define SLOT_4(h) SLOT_1(h), SLOT_1(h + 1), SLOT_1(h + 2), SLOT_1(h + 3)
+  #define SLOT_16(h) SLOT_4(h), SLOT_4(h + 4), SLOT_4(h + 8), SLOT_4(h + 12)
+  #define SLOT_64(h) SLOT_16(h), SLOT_16(h + 16), SLOT_16(h + 32), SLOT_16(h + 48)
+
+  constexpr uint8_t SLOTS[HASH_SLOTS] = {
+    SLOT_64(0), SLOT_64(64), SLOT_64(128), SLOT_64(192)
+  };
+
+  #undef SLOT_1
+  #undef SLOT_4
+  #undef SLOT_16
+  #undef SLOT_64
+}
+
+TokenType lookupKeyword(const collections::StringRef& text) {
+  size_t length = text.size();
+  if (length >= 32 || ((KEYWORD_LENGTHS >> length) & 1) == 0) {
+    return TOKEN_ID;
+  }
+  uint8_t slot = SLOTS[keywordHash(text.begin(), length)];
+  if (slot == EMPTY_SLOT) {
+    return TOKEN_ID;
+  }
+  const Keyword& kw = KEYWORDS[slot];
+  if (kw.length != length || std::memcmp(kw.text, text.begin(), length) != 0) {
+    return TOKEN_ID;
+  }
+  return kw.token;
+}
+
+collections::ArrayRef<Keyword> keywords() {
+  return KEYWORDS;
+}
+
+}}
@@ -0,0 +1,43 @@
+// ============================================================================
+// keywords.h: Keyword recognition.
+// ============================================================================
+
+#ifndef SPARK_PARSE_KEYWORDS_H
+#define SPARK_PARSE_KEYWORDS_H 1
+
+#ifndef SPARK_CONFIG_H
+  #include "spark/config.h"
+#endif
+
+#ifndef SPARK_COLLECTIONS_ARRAYREF_H
+  #include "spark/collections/arrayref.h"
+#endif
+
+#ifndef SPARK_COLLECTIONS_STRINGREF_H
+  #include "spark/collections/stringref.h"
+#endif
+
+#ifndef SPARK_PARSE_TOKENS_H
+  #include "spark/parse/tokens.h"
+#endif
+
+namespace spark {
+namespace parse {
+
+/** An entry in the keyword table. */
+struct Keyword {
+  const char* text;
+  uint32_t length;
+  TokenType token;
+};
+
+/** Return the keyword token for 'text', or TOKEN_ID if it is not a keyword. Uses a perfect hash
+    computed at compile time; most identifiers are rejected by their length alone. */
+TokenType lookupKeyword(const collections::StringRef& text);
+
+/** The complete list of keywords. */
+collections::ArrayRef<Keyword> keywords();
+
+}}
+
+#endif
@@ -4,20 +4,13 @@
 
 #include <spark/config.h>
 #include <spark/parse/lexer.h>
-#include <spark/collections/hashing.h>
+#include <spark/parse/keywords.h>
+#include <spark/support/unicode.h>
 
 #if SPARK_HAVE_ALGORITHM
   #include <algorithm>
 #endif
 
-#if SPARK_HAVE_CWCTYPE
-  #include <cwctype>
-#endif
-
-#if SPARK_HAVE_UNORDERED_MAP
-  #include <unordered_map>
-#endif
-
 #if SPARK_HAVE_CASSERT
   #include <cassert>
 #endif
@@ -26,169 +19,133 @@ namespace spark {
 namespace parse {
 
 namespace {
-  bool isNameStartChar(char32_t ch) {
-    return std::iswalpha(ch) || ch == '_';
-  }
-
-  bool isNameChar(char32_t ch) {
-    return std::iswalpha(ch) || (ch >= '0' && ch <= '9') || (ch == '_');
-  }
+  using support::decodeUtf8;
+  using support::isXIDContinue;
+  using support::isXIDStart;
+
+  /** Character class bits for the ASCII fast path. */
+  enum CharClass {
+    CC_NAME_START = 1 << 0,   // Letter or underscore
+    CC_NAME = 1 << 1,         // Letter, digit or underscore
+    CC_DIGIT = 1 << 2,        // Decimal digit
+    CC_HEX_DIGIT = 1 << 3,    // Hexadecimal digit
+    CC_NON_ASCII = 1 << 4,    // Part of a multi-byte UTF-8 sequence
+  };
 
-  bool isDigitChar(char32_t ch) {
-    return (ch >= '0' && ch <= '9');
+  constexpr bool isLetter(unsigned ch) {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z');
   }
 
-  bool isHexDigitChar(char32_t ch) {
-    return ((ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F'));
+  constexpr uint8_t classify(unsigned ch) {
+    return (isLetter(ch) || ch == '_' ? CC_NAME_START | CC_NAME : 0)
+        | (ch >= '0' && ch <= '9' ? CC_NAME | CC_DIGIT | CC_HEX_DIGIT : 0)
+        | ((ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F') ? CC_HEX_DIGIT : 0)
+        | (ch >= 0x80 ? CC_NON_ASCII : 0);
   }
 
-  struct Keyword {
-    collections::StringRef keyword;
-    TokenType token;
-  };
+  #define CLASS_4(c) classify(c), classify(c + 1), classify(c + 2), classify(c + 3)
+  #define CLASS_16(c) CLASS_4(c), CLASS_4(c + 4), CLASS_4(c + 8), CLASS_4(c + 12)
+  #define CLASS_64(c) CLASS_16(c), CLASS_16(c + 16), CLASS_16(c + 32), CLASS_16(c + 48)
 
-  Keyword keywords[] = {
-    { "abstract", TOKEN_ABSTRACT },
-    { "and", TOKEN_AND },
-    { "as", TOKEN_AS },
-    { "bool", TOKEN_BOOL },
-    { "break", TOKEN_BREAK },
-    { "catch", TOKEN_CATCH },
-    { "char", TOKEN_CHAR },
-    { "class", TOKEN_CLASS },
-    { "const", TOKEN_CONST },
-    { "continue", TOKEN_CONTINUE },
-    { "def", TOKEN_DEF },
-    { "else", TOKEN_ELSE },
-    { "enum", TOKEN_ENUM },
-    { "extend", TOKEN_EXTEND },
-    { "false", TOKEN_FALSE },
-    { "final", TOKEN_FINAL },
-    { "finally", TOKEN_FINALLY },
-    { "float", TOKEN_FLOAT },
-    { "f32", TOKEN_FLOAT32 },
-    { "f64", TOKEN_FLOAT64 },
-    { "fn", TOKEN_FN },
-    { "for", TOKEN_FOR },
-    { "friend", TOKEN_FRIEND },
-    { "i16", TOKEN_I16 },
-    { "i32", TOKEN_I32 },
-    { "i64", TOKEN_I64 },
-    { "i8", TOKEN_I8 },
-    { "id", TOKEN_ID },
-    { "if", TOKEN_IF },
-    { "import", TOKEN_IMPORT },
-    { "in", TOKEN_IN },
-    { "int", TOKEN_INT },
-    { "interface", TOKEN_INTERFACE },
-    { "internal", TOKEN_INTERNAL },
-    { "is", TOKEN_IS },
-    { "let", TOKEN_LET },
-    { "loop", TOKEN_LOOP },
-    { "match", TOKEN_MATCH },
-    { "not", TOKEN_NOT },
-    { "null", TOKEN_NULL },
-    { "object", TOKEN_OBJECT },
-    { "or", TOKEN_OR },
-    { "override", TOKEN_OVERRIDE },
-    { "public", TOKEN_PUBLIC },
-    { "private", TOKEN_PRIVATE },
-    { "protected", TOKEN_PROTECTED },
-    { "ref", TOKEN_REF },
-    { "return", TOKEN_RETURN },
-    { "self", TOKEN_SELF },
-    { "static", TOKEN_STATIC },
-    { "struct", TOKEN_STRUCT },
-    { "super", TOKEN_SUPER },
-    { "switch", TOKEN_SWITCH },
-    { "throw", TOKEN_THROW },
-    { "true", TOKEN_TRUE },
-    { "try", TOKEN_TRY },
-    { "u16", TOKEN_U16 },
-    { "u32", TOKEN_U32 },
-    { "u64", TOKEN_U64 },
-    { "u8", TOKEN_U8 },
-    { "uint", TOKEN_UINT },
-    { "undef", TOKEN_UNDEF },
-    { "var", TOKEN_VAR },
-    { "void", TOKEN_VOID },
-    { "where", TOKEN_WHERE },
-    { "while", TOKEN_WHILE },
-    { "__intrinsic__", TOKEN_INTRINSIC },
-    { "__tracemethod__", TOKEN_TRACEMETHOD },
-    { "__unsafe__", TOKEN_UNSAFE },
+  constexpr uint8_t CHAR_CLASSES[256] = {
+    CLASS_64(0), CLASS_64(64), CLASS_64(128), CLASS_64(192)
   };
 
-  typedef std::unordered_map<collections::StringRef, TokenType> KeywordMap;
+  #undef CLASS_4
+  #undef CLASS_16
+  #undef CLASS_64
 
-  template<size_t N>
-  const KeywordMap& BuildIndex(Keyword (&keywords)[N]) {
-    static KeywordMap map;
-    map.reserve(N);
-    for (int i = 0; i < N; ++i) {
-      Keyword k = keywords[i];
-      map[k.keyword] = k.token;
-    }
-    return map;
+  inline bool hasClass(char32_t ch, uint8_t cls) {
+    return ch < 256 && (CHAR_CLASSES[ch] & cls) != 0;
   }
 
+  inline bool isDigitChar(char32_t ch) {
+    return hasClass(ch, CC_DIGIT);
+  }
 
-  // Instead of a hash table or sorted list, we rely on the compiler to
-  // be smart about optimizing a switch statement that is known to
-  // have a small number of cases.
-  TokenType LookupKeyword(const collections::StringRef& tokenValue) {
-    static const KeywordMap& map = BuildIndex(keywords);
-    const KeywordMap::const_iterator it = map.find(tokenValue);
-    if (it != map.end()) {
-      return it->second;
-    }
-
-    return TOKEN_ID;
+  inline bool isHexDigitChar(char32_t ch) {
+    return hasClass(ch, CC_HEX_DIGIT);
   }
 }
 
 Lexer::Lexer(ProgramSource* src)
   : _src(src)
-  , _stream(src->open())
+  , _begin(src->content().begin())
+  , _pos(_begin)
+  , _end(src->content().end())
+  , _base(src->base())
+  , _scan(ScanKernels::select())
+  , _tokenDecoded(false)
   , _errorCode(ERROR_NONE)
 {
   _ch = 0;
   readCh();
-  _tokenLocation.source = src;
-  _tokenLocation.startLine = _line = 1;
-  _tokenLocation.startCol = _col = 1;
+  _tokenLocation.begin = _tokenLocation.end = _base;
+}
+
+Lexer::Lexer(ProgramSource* src, uint32_t begin, uint32_t end)
+  : _src(src)
+  , _begin(src->content().begin())
+  , _pos(_begin + begin)
+  , _end(_begin + end)
+  , _base(src->base())
+  , _scan(ScanKernels::select())
+  , _tokenDecoded(false)
+  , _errorCode(ERROR_NONE)
+{
+  assert(begin <= end && end <= src->content().size());
+  _ch = 0;
+  readCh();
+  _tokenLocation.begin = _tokenLocation.end = _base + begin;
 }
 
 inline void Lexer::readCh() {
-  if (_ch != EOF) {
-    _col += 1;
-  }
+  _ch = _pos < _end ? (uint8_t) *_pos++ : EOF;
+}
+
+inline char32_t Lexer::peekCh() const {
+  return _pos < _end ? (uint8_t) *_pos : EOF;
+}
+
+inline const char* Lexer::cursor() const {
+  return _ch == EOF ? _end : _pos - 1;
+}
+
+inline uint32_t Lexer::offset() const {
+  return _base + uint32_t(cursor() - _begin);
+}
+
+inline void Lexer::seek(const char* pos) {
+  _pos = pos;
+  _ch = _pos < _end ? (uint8_t) *_pos++ : EOF;
+}
 
-  _ch = _stream.get();
+inline void Lexer::setDecodedValue() {
+  _tokenText = _tokenValue;
+  _tokenDecoded = true;
 }
 
 TokenType Lexer::next() {
+  _tokenText = collections::StringRef();
+  _tokenAtom = collections::Atom();
+  _tokenValue.clear();
+  _tokenDecoded = false;
 
   // Whitespace loop
   for (;;) {
     if (_ch == EOF) {
       return TOKEN_END;
     } else if (_ch == ' ' || _ch == '\t' || _ch == '\b') {
-      // Horizontal whitespace
-      readCh();
-    } else if (_ch == '\n') {
-      // Linefeed
-      readCh();
-      _col = 1;
-      _line += 1;
-    } else if (_ch == '\r') {
-      // Carriage return. Look for CRLF pair and count as 1 line.
-      readCh();
-      if (_ch == '\n') {
+      // Horizontal whitespace. Single spaces are common, so only use the scan kernel for runs.
+      char32_t next = peekCh();
+      if (next == ' ' || next == '\t' || next == '\b') {
+        seek(_scan.skipSpace(_pos, _end));
+      } else {
         readCh();
       }
-      _col = 1;
-      _line += 1;
+    } else if (_ch == '\n' || _ch == '\r') {
+      // Line break
+      readCh();
     } else if (_ch == '/') {
       // Check for comment start
       readCh();
@@ -204,13 +161,17 @@ TokenType Lexer::next() {
 //           commentLocation.begin = currentOffset_;
         }
 
+        // Plain comments are skipped in bulk; doc comments need their text.
+        if (docComment == nullptr) {
+          seek(_scan.findLineEnd(cursor(), _end));
+        }
         while (_ch != EOF && _ch != '\n' && _ch != '\r') {
           if (docComment != nullptr) {
             // Expand tabs
             if (_ch == '\t') {
-              while ((_col++ % 4) != 1) {
+              do {
                 _commentText.push_back(' ');
-              }
+              } while (_commentText.size() % 4 != 0);
             } else {
               _commentText.push_back(_ch);
             }
@@ -240,6 +201,10 @@ TokenType Lexer::next() {
 //           commentLocation.begin = currentOffset_;
         }
 
+        // Skip in bulk up to the terminator, which the loop below consumes.
+        if (docComment == nullptr) {
+          seek(_scan.findCommentEnd(cursor(), _end));
+        }
         for (;;) {
           if (_ch == EOF) {
             _errorCode = UNTERMINATED_COMMENT;
@@ -269,15 +234,13 @@ TokenType Lexer::next() {
 //               if (docComment != nullptr) {
 //                 _commentText.push_back('\n');
 //               }
-              _col = 1;
-              _line += 1;
             } else {
               if (docComment != nullptr) {
                 // Expand tabs
                 if (_ch == '\t') {
-                  while ((_col++ % 4) != 1) {
+                  do {
                     _commentText.push_back(' ');
-                  }
+                  } while (_commentText.size() % 4 != 0);
                 } else {
                   _commentText.push_back(_ch);
                 }
@@ -293,12 +256,13 @@ TokenType Lexer::next() {
 //         }
       } else {
         // What comes after a '/' char.
-        _tokenLocation.startLine = _line;
-        _tokenLocation.startCol = _col;
+        _tokenLocation.begin = offset() - 1;
         if (_ch == '=') {
           readCh();
+          _tokenLocation.end = offset();
           return TOKEN_ASSIGN_DIV;
         }
+        _tokenLocation.end = offset();
         return TOKEN_DIV;
       }
     } else {
@@ -306,43 +270,79 @@ TokenType Lexer::next() {
     }
   }
 
-  _tokenLocation.startLine = _line;
-  _tokenLocation.startCol = _col;
-  _tokenValue.clear();
+  _tokenLocation.begin = offset();
 
   // Identifier
-  if (isNameStartChar(_ch)) {
+  if (hasClass(_ch, CC_NAME_START)) {
     TokenType result = ident();
-    _tokenLocation.endLine = _line;
-    _tokenLocation.endCol = _col;
+    _tokenLocation.end = offset();
     return result;
   }
 
+  // Non-ASCII identifier
+  if (hasClass(_ch, CC_NON_ASCII)) {
+    unsigned length;
+    char32_t cp = decodeUtf8(cursor(), _end, length);
+    if (isXIDStart(cp)) {
+      TokenType result = ident();
+      _tokenLocation.end = offset();
+      return result;
+    }
+    // Skip the whole sequence, so that the next token starts after it.
+    const char* start = cursor();
+    _tokenValue.append(start, start + length);
+    seek(start + length);
+    setDecodedValue();
+    _tokenLocation.end = offset();
+    _errorCode = cp == support::INVALID_CODE_POINT ? INVALID_UNICODE_CHAR : ILLEGAL_CHAR;
+    return TOKEN_ERROR;
+  }
+
   // Number
   if (isDigitChar(_ch) || _ch == '.') {
     TokenType result = number();
-    _tokenLocation.endLine = _line;
-    _tokenLocation.endCol = _col;
+    setDecodedValue();
+    _tokenLocation.end = offset();
     return result;
   }
 
   // Punctionation
   TokenType result = punc();
-  _tokenLocation.endLine = _line;
-  _tokenLocation.endCol = _col;
+  if (result == TOKEN_ERROR) {
+    setDecodedValue();
+  }
+  _tokenLocation.end = offset();
   return result;
 }
 
 TokenType Lexer::ident() {
-  _tokenValue.push_back(_ch);
-  readCh();
-  while (isNameChar(_ch)) {
-    _tokenValue.push_back(_ch);
-    readCh();
+  const char* start = cursor();
+  for (;;) {
+    // Runs of ASCII name characters are skipped in bulk.
+    const char* pos = cursor();
+    while (pos < _end && (CHAR_CLASSES[uint8_t(*pos)] & CC_NAME) != 0) {
+      ++pos;
+    }
+    seek(pos);
+
+    // Otherwise decode the UTF-8 sequence and check its properties.
+    if (!hasClass(_ch, CC_NON_ASCII)) {
+      break;
+    }
+    unsigned length;
+    if (!isXIDContinue(decodeUtf8(pos, _end, length))) {
+      break;
+    }
+    seek(pos + length);
   }
+  _tokenText = collections::StringRef(start, cursor() - start);
 
   // Check for keyword
-  return LookupKeyword(_tokenValue);
+  TokenType result = lookupKeyword(_tokenText);
+  if (result == TOKEN_ID) {
+    _tokenAtom = collections::Atom::intern(_tokenText);
+  }
+  return result;
 }
 
 TokenType Lexer::number() {
@@ -390,15 +390,15 @@ TokenType Lexer::number() {
 
   // Fractional part
   if (_ch == '.') {
-    readCh();
+    // Special case of '..' range token and '...' ellipsis token. If they follow an integer,
+    // then leave them unread so that they become the next token.
+    if (peekCh() == '.' && !_tokenValue.empty()) {
+      // TODO: read suffix
+      return TOKEN_DEC_INT_LIT;
+    }
 
-    // Special case of '..' range token and '...' ellipsis token.
+    readCh();
     if (_ch == '.') {
-      if (!_tokenValue.empty()) {
-        _stream.putback('.');
-        // TODO: read suffix
-        return TOKEN_DEC_INT_LIT;
-      }
       readCh();
       if (_ch == '.') {
         readCh();
@@ -658,14 +658,26 @@ TokenType Lexer::punc() {
         char quote = _ch;
         int charCount = 0;
         readCh();
+        // The value is a slice of the source unless an escape sequence is seen.
+        const char* start = cursor();
+        bool escaped = false;
         for (;;) {
           if (_ch == EOF) {
             _errorCode = UNTERMINATED_STRING;
             return TOKEN_ERROR;
           } else if (_ch == quote) {
+            if (escaped) {
+              setDecodedValue();
+            } else {
+              _tokenText = collections::StringRef(start, cursor() - start);
+            }
             readCh();
             break;
           } else if (_ch == '\\') {
+            if (!escaped) {
+              _tokenValue.assign(start, cursor());
+              escaped = true;
+            }
             readCh();
             if (_ch == EOF) {
               _errorCode = MALFORMED_ESCAPE_SEQUENCE;
@@ -675,7 +687,9 @@ TokenType Lexer::punc() {
               return TOKEN_ERROR;
             }
           } else if (_ch >= ' ') {
-            _tokenValue.push_back(_ch);
+            if (escaped) {
+              _tokenValue.push_back(_ch);
+            }
             readCh();
           } else {
             _errorCode = MALFORMED_ESCAPE_SEQUENCE;
@@ -703,6 +717,7 @@ TokenType Lexer::punc() {
   }
 
   _tokenValue.push_back(_ch);
+  readCh();
   _errorCode = ILLEGAL_CHAR;
   return TOKEN_ERROR;
 }
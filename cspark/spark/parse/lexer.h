@@ -13,6 +13,10 @@
   #include "spark/collections/stringref.h"
 #endif
 
+#ifndef SPARK_COLLECTIONS_ATOM_H
+  #include "spark/collections/atom.h"
+#endif
+
 #ifndef SPARK_SOURCE_PROGRAMSOURCE_H
   #include "spark/source/programsource.h"
 #endif
@@ -29,8 +33,8 @@
   #include "spark/parse/tokens.h"
 #endif
 
-#if SPARK_HAVE_ISTREAM
-  #include <istream>
+#ifndef SPARK_PARSE_SCAN_H
+  #include "spark/parse/scan.h"
 #endif
 
 namespace spark {
@@ -56,17 +60,25 @@ public:
   /** Constructor */
   Lexer(ProgramSource* src);
 
-  /** Destructor closes the stream. */
-  ~Lexer() {
-    _src->close();
-  }
+  /** Construct a lexer that reads only the text between the file-relative offsets 'begin'
+      and 'end'. Token locations are the same as when lexing the whole file. */
+  Lexer(ProgramSource* src, uint32_t begin, uint32_t end);
 
   /** Get the next token */
   TokenType next();
 
-  /** Current value of the token. */
-  const std::string& tokenValue() const { return _tokenValue; }
-  std::string& tokenValue() { return _tokenValue; }
+  /** Current value of the token. For identifiers and for string and character literals without
+      escapes, this is a slice of the source text that remains valid for the lifetime of the
+      source. Otherwise it refers to a decoded copy that is only valid until the next call to
+      next() (see tokenDecoded()). Numeric values are always decoded, and are null-terminated. */
+  collections::StringRef tokenValue() const { return _tokenText; }
+
+  /** True if the current token value had to be decoded, rather than being a slice of the source
+      text. */
+  bool tokenDecoded() const { return _tokenDecoded; }
+
+  /** For identifier tokens, the interned name. Null for all other tokens. */
+  collections::Atom tokenAtom() const { return _tokenAtom; }
 
   /** Suffix for numeric tokens. */
   const std::string& tokenSuffix() const { return _tokenSuffix; }
@@ -98,12 +110,17 @@ public:
 private:
   // Source file containing the buffer
   ProgramSource*    _src;           /** Pointer to source file buffer */
-  std::istream&     _stream;        /** Input stream. */
+  const char*       _begin;         /** Start of the source text. */
+  const char*       _pos;           /** Read position within the source text. */
+  const char*       _end;           /** End of the source text. */
+  uint32_t          _base;          /** Global offset of the start of the source text. */
+  const ScanKernels& _scan;         /** Routines for skipping whitespace and comments. */
   char32_t          _ch;            /** Previously read char. */
-  uint32_t          _line;          /** Line number of current read position. */
-  uint32_t          _col;           /** Column number of current read position. */
   Location          _tokenLocation; /** Current token location. */
-  std::string       _tokenValue;    /** String value of token. */
+  collections::StringRef _tokenText; /** Value of token, either a slice or _tokenValue. */
+  collections::Atom _tokenAtom;     /** Interned name of identifier token. */
+  std::string       _tokenValue;    /** Decoded value of token. */
+  bool              _tokenDecoded;  /** True if _tokenText refers to _tokenValue. */
   std::string       _tokenSuffix;   /** Numeric suffix. */
   std::string       _commentText;   /** Text of the doc comment. */
   DocComment*       _docComment;    /** Accumulated doc comment. */
@@ -111,6 +128,21 @@ private:
 
   // Read the next character.
   void readCh();
+
+  // Return the character following the current one, without consuming anything.
+  char32_t peekCh() const;
+
+  // Address of the current character within the source text.
+  const char* cursor() const;
+
+  // Global offset of the current character.
+  uint32_t offset() const;
+
+  // Make 'pos' the current character.
+  void seek(const char* pos);
+
+  // Make the decoded buffer the value of the current token.
+  void setDecodedValue();
   bool readEscapeChars();
   TokenType ident();
   TokenType number();
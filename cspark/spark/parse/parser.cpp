@@ -13,6 +13,10 @@
 #include "spark/error/reporter.h"
 #include "spark/parse/parser.h"
 
+#if SPARK_HAVE_ALGORITHM
+  #include <algorithm>
+#endif
+
 #if SPARK_HAVE_CASSERT
   #include <cassert>
 #endif
@@ -23,7 +27,9 @@ using spark::ast::Defn;
 using spark::ast::Node;
 using spark::ast::Kind;
 using spark::ast::Module;
+using spark::ast::NodeList;
 using spark::collections::StringRef;
+using spark::collections::Atom;
 
 enum precedence {
   PREC_COMMA = 0,
@@ -45,18 +51,85 @@ enum precedence {
   PREC_MUL_DIV, // multiply and divide
 };
 
+enum Associativity {
+  ASSOC_LEFT,
+  ASSOC_RIGHT,
+};
+
+enum OperandType {
+  OPERAND_EXPR,
+  OPERAND_TYPE,   // The right operand is a type expression.
+};
+
+/** How a token behaves as a binary operator. */
+struct BinaryOperator {
+  TokenType token;
+  Kind kind;          /** Operator node to build, or ABSENT if the token isn't an operator. */
+  int8_t precedence;
+  Associativity associativity;
+  OperandType operand;
+};
+
+#undef DEFINE_TOKEN
+#define DEFINE_TOKEN(name)
+#define BINARY_OPERATOR(name, kind, prec, assoc, operand) \
+  { TOKEN_##name, Kind::kind, PREC_##prec, ASSOC_##assoc, OPERAND_##operand },
+
+/** The binary operators defined in tokens.txt. */
+constexpr BinaryOperator OPERATOR_LIST[] = {
+  #include "spark/parse/tokens.txt"
+};
+
+constexpr size_t NUM_OPERATORS = sizeof(OPERATOR_LIST) / sizeof(OPERATOR_LIST[0]);
+
+constexpr BinaryOperator findOperator(TokenType tok, size_t index) {
+  return index == NUM_OPERATORS ? BinaryOperator { tok, Kind::ABSENT, 0, ASSOC_LEFT, OPERAND_EXPR }
+      : OPERATOR_LIST[index].token == tok ? OPERATOR_LIST[index] : findOperator(tok, index + 1);
+}
+
+#undef DEFINE_TOKEN
+#define DEFINE_TOKEN(name) findOperator(TOKEN_##name, 0),
+
+/** Table of binary operators, indexed by token type. */
+constexpr BinaryOperator BINARY_OPERATORS[] = {
+  #include "spark/parse/tokens.txt"
+};
+
+#undef DEFINE_TOKEN
+
+static inline bool isSpace(char ch) {
+  return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
+}
+
 Parser::Parser(Reporter& reporter, ProgramSource* source, support::Arena& arena)
   : _reporter(reporter)
   , _source(source)
   , _arena(arena)
-  , _lexer(source)
+  , _index(0)
   , _recovering(false)
+  , _deferBodies(false)
 {
-  _token = _lexer.next();
+  _tokens.tokenize(source);
+  _token = _tokens.kind(0);
+}
+
+Parser::Parser(
+    Reporter& reporter, ProgramSource* source, support::Arena& arena, uint32_t from, uint32_t to)
+  : _reporter(reporter)
+  , _source(source)
+  , _arena(arena)
+  , _index(0)
+  , _recovering(false)
+  , _deferBodies(false)
+{
+  _tokens.tokenize(source, from, to);
+  _token = _tokens.kind(0);
 }
 
 void Parser::next() {
-  _token = _lexer.next();
+  if (_token != TOKEN_END) {
+    _token = _tokens.kind(++_index);
+  }
 }
 
 bool Parser::match(TokenType tok) {
@@ -81,13 +154,13 @@ ast::Module* Parser::module() {
     }
     Node* path = dottedIdent();
     assert(path != nullptr);
-    StringRef alias;
+    Atom alias;
     if (match(TOKEN_AS)) {
       if (_token != TOKEN_ID) {
         _reporter.error(location()) << "Identifier expected.";
         return nullptr;
       }
-      alias = copyOf(tokenValue());
+      alias = tokenName();
     }
 
     if (!match(TOKEN_SEMI)) {
@@ -97,19 +170,129 @@ ast::Module* Parser::module() {
     imports.append(new (_arena) ast::Import(path->location(), path, alias));
   }
 
-  while (_token != TOKEN_END) {
-    if (!declaration(members)) {
-      return nullptr;
-    }
+  support::ArrayBuilder<ast::Span> spans(_arena);
+  if (!declarationList(members, spans)) {
+    return nullptr;
   }
 
   mod->setImports(imports.build());
   mod->setMembers(members.build());
+  mod->setSpans(spans.build());
+  return mod;
+}
+
+ast::Module* Parser::reparse(Reporter& reporter, ProgramSource* source, support::Arena& arena,
+    const ast::Module* previous, const TextEdit& edit, ModuleChanges& changes) {
+  NodeList members = previous->members();
+  collections::ArrayRef<ast::Span> spans = previous->spans();
+  StringRef text = source->content();
+  size_t count = members.size();
+  changes.removed.clear();
+  changes.added.clear();
+  changes.full = false;
+
+  // Find the declarations that the edit overlaps or touches, [first, last). If there are none,
+  // then the edit is between declarations, and that gap is parsed in case it now contains one.
+  // Offsets before the edit are the same in both versions of the text.
+  size_t first = 0;
+  size_t last = 0;
+  // An edit that reaches back into the imports means parsing the whole file.
+  bool partial = count > 0 && spans.size() == count &&
+      edit.offset + edit.newLength <= text.size() && edit.offset > spans[0].begin;
+  if (partial) {
+    uint32_t editEnd = edit.offset + edit.length;
+    while (first < count && spans[first].end < edit.offset) {
+      ++first;
+    }
+    last = first;
+    while (last < count && spans[last].begin <= editEnd) {
+      ++last;
+    }
+  }
+
+  // The text to be parsed runs from the end of the last declaration before the edit to the
+  // start of the first one after it. If the edit has joined either of those declarations onto
+  // the text being parsed, they have to be parsed as well. Declarations in the same visibility
+  // block share a span, and are always parsed together.
+  int64_t delta = int64_t(edit.newLength) - int64_t(edit.length);
+  uint32_t from = 0;
+  uint32_t to = 0;
+  while (partial) {
+    from = first > 0 ? spans[first - 1].end : spans[0].begin;
+    to = last < count ? uint32_t(spans[last].begin + delta) : uint32_t(text.size());
+    if (first > 0 && !isSpace(text[from])) {
+      do {
+        --first;
+      } while (first > 0 && spans[first - 1].begin == spans[first].begin);
+    } else if (last < count && to > from && !isSpace(text[to - 1])) {
+      do {
+        ++last;
+      } while (last < count && spans[last].begin == spans[last - 1].begin);
+    } else {
+      break;
+    }
+  }
+
+  if (partial) {
+    error::BufferedReporter diagnostics;
+    Parser parser(diagnostics, source, arena, from, to);
+    ast::NodeListBuilder added(arena);
+    support::ArrayBuilder<ast::Span> addedSpans(arena);
+    if (parser.declarationList(added, addedSpans) && diagnostics.errorCount() == 0) {
+      NodeList addedMembers = added.contents();
+      support::ArrayBuilder<const Node*> newMembers(arena);
+      support::ArrayBuilder<ast::Span> newSpans(arena);
+      newMembers.append(members.begin(), members.begin() + first);
+      newSpans.append(spans.begin(), spans.begin() + first);
+      newMembers.append(addedMembers.begin(), addedMembers.end());
+      newSpans.append(addedSpans.begin(), addedSpans.end());
+      newMembers.append(members.begin() + last, members.end());
+      for (size_t i = last; i < count; ++i) {
+        ast::Span span = { uint32_t(spans[i].begin + delta), uint32_t(spans[i].end + delta) };
+        newSpans.append(span);
+      }
+
+      Module* mod = new (arena) Module(previous->location());
+      mod->setImports(previous->imports());
+      mod->setMembers(newMembers.build());
+      mod->setSpans(newSpans.build());
+      changes.removed.assign(members.begin() + first, members.begin() + last);
+      changes.added.assign(addedMembers.begin(), addedMembers.end());
+      return mod;
+    }
+  }
+
+  // Parse the whole file. Errors are reported from here, so that they are seen in context.
+  Parser parser(reporter, source, arena);
+  Module* mod = parser.module();
+  if (mod != nullptr) {
+    changes.removed.assign(members.begin(), members.end());
+    changes.added.assign(mod->members().begin(), mod->members().end());
+    changes.full = true;
+  }
   return mod;
 }
 
 // Declaration
 
+bool Parser::declarationList(
+    ast::NodeListBuilder& decls, support::ArrayBuilder<ast::Span>& spans) {
+  uint32_t base = _source->base();
+  while (_token != TOKEN_END) {
+    size_t count = decls.size();
+    ast::Span span;
+    span.begin = _tokens.begin(_index) - base;
+    if (!declaration(decls)) {
+      return false;
+    }
+    span.end = _tokens.begin(_index - 1) + _tokens.length(_index - 1) - base;
+    for (size_t i = count; i < decls.size(); ++i) {
+      spans.append(span);
+    }
+  }
+  return true;
+}
+
 bool Parser::declaration(ast::NodeListBuilder& decls, bool isProtected, bool isPrivate) {
   ast::NodeListBuilder attributes(_arena);
   while (Node* attr = attribute()) {
@@ -239,7 +422,7 @@ Defn* Parser::compositeTypeDef() {
     _reporter.error(location()) << "Type name expected.";
     _recovering = true;
   }
-  StringRef name = copyOf(tokenValue());
+  Atom name = tokenName();
   Location loc = location();
   next();
 
@@ -317,19 +500,13 @@ bool Parser::classMember(ast::NodeListBuilder &members, ast::NodeListBuilder &fr
 
 // Enumeration types
 
-// Definitions allowed inside of an enumeration.
-static const std::unordered_set<TokenType> ENUM_MEMBERS = {
-  TOKEN_DEF, TOKEN_OVERRIDE, TOKEN_UNDEF, TOKEN_VAR, TOKEN_LET,
-  TOKEN_CLASS, TOKEN_STRUCT, TOKEN_INTERFACE, TOKEN_EXTEND, TOKEN_ENUM
-};
-
 Defn* Parser::enumTypeDef() {
   next();
   if (_token != TOKEN_ID) {
     _reporter.error(location()) << "Type name expected.";
     _recovering = true;
   }
-  StringRef name = copyOf(tokenValue());
+  Atom name = tokenName();
   Location loc = location();
   next();
 
@@ -365,7 +542,7 @@ Defn* Parser::enumTypeDef() {
         _reporter.error(loc) << "Incomplete enum.";
         return nullptr;
       }
-      if (defnMode || ENUM_MEMBERS.find(_token) != ENUM_MEMBERS.end()) {
+      if (defnMode || DEFN_START_TOKENS.contains(_token)) {
         defnMode = true;
         if (!classMember(members, friends)) {
           return nullptr;
@@ -395,7 +572,7 @@ bool Parser::enumMember(ast::NodeListBuilder &members) {
     _recovering = true;
   }
 
-  StringRef name = copyOf(tokenValue());
+  Atom name = tokenName();
   Location loc = location();
   next();
 
@@ -413,7 +590,7 @@ bool Parser::enumMember(ast::NodeListBuilder &members) {
     if (!callingArgs(args, callLoc)) {
       return false;
     }
-    ev->setInit(new (_arena) ast::Oper(Kind::CALL, callLoc, args.build()));
+    ev->setInit(ast::Oper::create(_arena, Kind::CALL, callLoc, args.contents()));
   }
   members.append(ev);
   return true;
@@ -434,7 +611,7 @@ Defn* Parser::methodDef() {
 
   // Method name (may be empty).
   Location loc = location();
-  StringRef name = methodName();
+  Atom name = methodName();
 
   // Template parameters
   ast::NodeListBuilder templateParams(_arena);
@@ -453,7 +630,7 @@ Defn* Parser::methodDef() {
   }
 
   if (name.empty()) {
-    name = "()";
+    name = Atom::intern("()");
   }
 
   Node* returnType = nullptr;
@@ -528,7 +705,7 @@ Defn* Parser::methodDef() {
 
       if (_token == TOKEN_ID) {
         loc = location();
-        name = copyOf(tokenValue());
+        name = tokenName();
         next();
 
         ast::NodeListBuilder accessorParams(_arena);
@@ -574,10 +751,14 @@ Defn* Parser::methodDef() {
   }
 }
 
-StringRef Parser::methodName() {
+Atom Parser::methodName() {
   StringRef methodName;
   switch (_token) {
-    case TOKEN_ID:      methodName = copyOf(tokenValue()); break;
+    case TOKEN_ID: {
+      Atom name = tokenName();
+      next();
+      return name;
+    }
     case TOKEN_VBAR:    methodName = "|"; break;
     case TOKEN_CARET:   methodName = "^"; break;
     case TOKEN_AMP:     methodName = "&"; break;
@@ -596,17 +777,17 @@ StringRef Parser::methodName() {
     case TOKEN_LE:      methodName = ">="; break;
     case TOKEN_GE:      methodName = "<"; break;
     default:
-      return StringRef();
+      return Atom();
   }
   next();
-  return methodName;
+  return Atom::intern(methodName);
 }
 
 Node* Parser::methodBody() {
   if (match(TOKEN_SEMI)) {
     return &Node::ABSENT;
   } else if (_token == TOKEN_LBRACE) {
-    Node* body = block();
+    Node* body = _deferBodies ? deferredBody() : block();
     if (body != nullptr) {
       return body;
     }
@@ -624,6 +805,41 @@ Node* Parser::methodBody() {
   return &Node::ERROR;
 }
 
+Node* Parser::deferredBody() {
+  // Find the matching close brace. If there isn't one, parse the body now so that the errors
+  // get reported.
+  uint32_t start = _index;
+  uint32_t depth = 0;
+  for (uint32_t i = start; i < _tokens.size(); ++i) {
+    TokenType tok = _tokens.kind(i);
+    if (tok == TOKEN_LBRACE) {
+      ++depth;
+    } else if (tok == TOKEN_RBRACE) {
+      if (--depth == 0) {
+        Location loc = _tokens.location(start) | _tokens.location(i);
+        _index = i;
+        _token = tok;
+        next();
+        return new (_arena) ast::DeferredBody(loc, _source, _arena);
+      }
+    } else if (tok == TOKEN_END) {
+      break;
+    }
+  }
+  return block();
+}
+
+const Node* Parser::parseDeferredBody(Reporter& reporter, const ast::DeferredBody* body) {
+  if (!body->isParsed()) {
+    uint32_t base = body->source()->base();
+    Parser parser(
+        reporter, body->source(), body->arena(),
+        body->location().begin - base, body->location().end - base);
+    body->setBody(parser.block());
+  }
+  return body->body();
+}
+
 // Requirements
 
 bool Parser::requirements(ast::NodeListBuilder& out) {
@@ -730,11 +946,7 @@ Node* Parser::requireBinaryOp(Kind kind, Node* left) {
   if (right == nullptr) {
     return nullptr;
   }
-  ast::NodeListBuilder builder(_arena);
-  builder.append(left);
-  builder.append(right);
-  return new (_arena) ast::Oper(
-    kind, left->location() | right ->location(), builder.build());
+  return ast::Oper::create(_arena, kind, left->location() | right->location(), { left, right });
 }
 
 Node* Parser::requireCall(Kind kind, Node* fn) {
@@ -742,9 +954,7 @@ Node* Parser::requireCall(Kind kind, Node* fn) {
   if (fnType == nullptr) {
     return nullptr;
   }
-  ast::NodeListBuilder signature(_arena);
-  signature.append(fnType);
-  ast::Oper *call = new (_arena) ast::Oper(kind, fn->location(), signature.build());
+  ast::Oper *call = ast::Oper::create(_arena, kind, fn->location(), { fnType });
   call->setOp(fn);
   return call;
 }
@@ -766,13 +976,13 @@ bool Parser::paramList(ast::NodeListBuilder& builder) {
       // Parameter name
       ast::Parameter* param = nullptr;
       if (_token == TOKEN_ID) {
-        param = new (_arena) ast::Parameter(location(), copyOf(tokenValue()));
+        param = new (_arena) ast::Parameter(location(), tokenName());
         next();
       } else if (match(TOKEN_SELF)) {
-        param = new (_arena) ast::Parameter(location(), copyOf(tokenValue()));
+        param = new (_arena) ast::Parameter(location(), tokenName());
         param->setSelfParam(true);
       } else if (match(TOKEN_CLASS)) {
-        param = new (_arena) ast::Parameter(location(), copyOf(tokenValue()));
+        param = new (_arena) ast::Parameter(location(), tokenName());
         param->setClassParam(true);
       } else {
         expected("parameter name");
@@ -898,7 +1108,7 @@ ast::ValueDefn* Parser::varDeclList(Kind kind) {
       }
     }
 
-    var = new (_arena) ast::ValueDefn(Kind::VAR_LIST, loc, "");
+    var = new (_arena) ast::ValueDefn(Kind::VAR_LIST, loc, Atom());
     var->setMembers(varList.build());
   }
 
@@ -910,7 +1120,7 @@ ast::ValueDefn* Parser::varDecl(Kind kind) {
     _reporter.error(location()) << "Variable name expected.";
     _recovering = true;
   }
-  StringRef name = copyOf(tokenValue());
+  Atom name = tokenName();
   Location loc = location();
   next();
 
@@ -938,9 +1148,7 @@ Node* Parser::attribute() {
   if (match(TOKEN_ATSIGN)) {
     if (_token != TOKEN_ID) {
       _reporter.error(location()) << "Attribute name expected.";
-      skipUntil({
-        TOKEN_ATSIGN, TOKEN_CLASS, TOKEN_STRUCT, TOKEN_INTERFACE, TOKEN_ENUM,
-        TOKEN_DEF, TOKEN_OVERRIDE, TOKEN_VAR, TOKEN_LET});
+      skipUntil(TokenSet(TOKEN_ATSIGN) | DEFN_START_TOKENS);
       return nullptr;
     }
     Node* attr = dottedIdent();
@@ -951,7 +1159,7 @@ Node* Parser::attribute() {
       if (!callingArgs(args, callLoc)) {
         return nullptr;
       }
-      ast::Oper* call = new (_arena) ast::Oper(Kind::CALL, callLoc, args.build());
+      ast::Oper* call = ast::Oper::create(_arena, Kind::CALL, callLoc, args.contents());
       call->setOp(attr);
       attr = call;
     }
@@ -994,7 +1202,7 @@ void Parser::templateParamList(ast::NodeListBuilder& builder) {
 
 ast::TypeParameter* Parser::templateParam() {
   if (_token == TOKEN_ID) {
-    ast::TypeParameter* tp = new (_arena) ast::TypeParameter(location(), copyOf(tokenValue()));
+    ast::TypeParameter* tp = new (_arena) ast::TypeParameter(location(), tokenName());
     next();
 
     if (match(TOKEN_COLON)) {
@@ -1053,7 +1261,7 @@ Node* Parser::typeUnion() {
         break;
       }
     }
-    return new ast::Oper(Kind::UNION, builder.location(), builder.build());
+    return ast::Oper::create(_arena, Kind::UNION, builder.location(), builder.contents());
   }
   return t;
 }
@@ -1113,7 +1321,7 @@ Node* Parser::typePrimary(bool allowPartial) {
       if (members.size() == 1 && !trailingComma) {
         return members[0];
       }
-      return new (_arena) ast::Oper(Kind::TUPLE, loc, members.build());
+      return ast::Oper::create(_arena, Kind::TUPLE, loc, members.contents());
     }
     case TOKEN_ID: return specializedTypeName();
     case TOKEN_VOID: return builtinType(ast::BuiltInType::VOID);
@@ -1165,8 +1373,7 @@ Node* Parser::functionType() {
     }
   }
 
-  ast::Oper *fnType = new (_arena) ast::Oper(
-      Kind::FUNCTION_TYPE, loc, params.build());
+  ast::Oper *fnType = ast::Oper::create(_arena, Kind::FUNCTION_TYPE, loc, params.contents());
   if (match(TOKEN_RETURNS)) {
     Node* returnType = typeExpression();
     if (returnType == nullptr) {
@@ -1203,12 +1410,12 @@ Node* Parser::specializedTypeName() {
           }
         }
       }
-      ast::Oper* spec = new (_arena) ast::Oper(Kind::SPECIALIZE, loc, builder.build());
+      ast::Oper* spec = ast::Oper::create(_arena, Kind::SPECIALIZE, loc, builder.contents());
       spec->setOp(type);
       type = spec;
     } else if (match(TOKEN_DOT)) {
       if (_token == TOKEN_ID) {
-        type = new (_arena) ast::MemberRef(location(), copyOf(tokenValue()), type);
+        type = new (_arena) ast::MemberRef(location(), tokenName(), type);
         next();
       } else {
         expected("identifier");
@@ -1228,13 +1435,6 @@ Node* Parser::builtinType(ast::BuiltInType::Type t) {
 
 // Statements
 
-// Statements that don't require a terminating semicolon.
-static const std::unordered_set<TokenType> BLOCK_ENDING_STMTS = {
-  TOKEN_IF, TOKEN_WHILE, TOKEN_LOOP, TOKEN_FOR, TOKEN_SWITCH, TOKEN_MATCH, TOKEN_TRY,
-  TOKEN_LET, TOKEN_VAR, TOKEN_DEF, TOKEN_CLASS, TOKEN_STRUCT, TOKEN_INTERFACE, TOKEN_ENUM,
-  TOKEN_EXTEND
-};
-
 Node* Parser::block() {
   Location loc = location();
   if (match(TOKEN_LBRACE)) {
@@ -1254,13 +1454,13 @@ Node* Parser::block() {
 
       // Semicolon is only required *between* statements, and only for some statement types.
       if (!match(TOKEN_SEMI)) {
-        if (_token != TOKEN_RBRACE && BLOCK_ENDING_STMTS.find(stType) == BLOCK_ENDING_STMTS.end()) {
+        if (_token != TOKEN_RBRACE && !BLOCK_STMT_START_TOKENS.contains(stType)) {
           _reporter.error(location()) << "Semicolon expected after statement.";
         }
       }
       stmts.append(st);
     }
-    return new (_arena) ast::Oper(Kind::BLOCK, loc, stmts.build());
+    return ast::Oper::create(_arena, Kind::BLOCK, loc, stmts.contents());
   }
   assert(false && "Missing opening brace.");
   return nullptr;
@@ -1347,11 +1547,7 @@ Node* Parser::assignStmt() {
     return nullptr;
   }
 
-  ast::NodeListBuilder operands(_arena);
-  operands.append(left);
-  operands.append(right);
-
-  return new (_arena) ast::Oper(kind, left->location() | right->location(), operands.build());
+  return ast::Oper::create(_arena, kind, left->location() | right->location(), { left, right });
 }
 
 Node* Parser::ifStmt() {
@@ -1536,7 +1732,8 @@ Node* Parser::switchStmt() {
       return nullptr;
     }
 
-    ast::Oper* caseSt = new (_arena) ast::Oper(kind, caseValues.location(), caseValues.build());
+    ast::Oper* caseSt =
+        ast::Oper::create(_arena, kind, caseValues.location(), caseValues.contents());
     caseSt->setOp(body);
     cases.append(caseSt);
   }
@@ -1550,10 +1747,7 @@ Node* Parser::caseExpr() {
     if (e2 == nullptr) {
       return nullptr;
     }
-    ast::NodeListBuilder rangeBounds(_arena);
-    rangeBounds.append(e);
-    rangeBounds.append(e2);
-    return new (_arena) ast::Oper(Kind::RANGE, rangeBounds.location(), rangeBounds.build());
+    return ast::Oper::create(_arena, Kind::RANGE, e->location() | e2->location(), { e, e2 });
   }
   return e;
 }
@@ -1611,6 +1805,7 @@ Node* Parser::matchStmt() {
       patternArgs.append(name);
       patternArgs.append(type);
     } else {
+      kind = Kind::PATTERN;
       Node* type = typeTerm(false);
       if (type == nullptr) {
         _reporter.error(location()) << "Match pattern expected.";
@@ -1631,7 +1826,7 @@ Node* Parser::matchStmt() {
       return nullptr;
     }
     patternArgs.append(body);
-    ast::Oper* pattern = new (_arena) ast::Oper(kind, patternLoc, patternArgs.build());
+    ast::Oper* pattern = ast::Oper::create(_arena, kind, patternLoc, patternArgs.contents());
     patterns.append(pattern);
   }
 
@@ -1722,7 +1917,7 @@ Node* Parser::exprList() {
         break;
       }
     }
-    return new (_arena) ast::Oper(Kind::TUPLE, builder.location(), builder.build());
+    return ast::Oper::create(_arena, Kind::TUPLE, builder.location(), builder.contents());
   }
   return expr;
 }
@@ -1732,198 +1927,46 @@ Node* Parser::binary() {
   if (e0 == nullptr) {
     return nullptr;
   }
+  return binaryRest(e0, 0);
+}
 
-  OperatorStack opstack(e0, _arena);
+/** Parse the operators and operands following 'left', for as long as the operators bind at
+    least as tightly as 'minPrec'. The right operand of each operator absorbs the operators that
+    bind more tightly than it does (or as tightly, for right-associative operators). */
+Node* Parser::binaryRest(Node* left, int minPrec) {
   for (;;) {
-    switch (_token) {
-      case TOKEN_PLUS:
-        opstack.pushOperator(Kind::ADD, PREC_ADD_SUB);
-        next();
-        break;
-
-      case TOKEN_MINUS:
-        opstack.pushOperator(Kind::SUB, PREC_ADD_SUB);
-        next();
-        break;
-
-      case TOKEN_MUL:
-        opstack.pushOperator(Kind::MUL, PREC_MUL_DIV);
-        next();
-        break;
-
-      case TOKEN_DIV:
-        opstack.pushOperator(Kind::DIV, PREC_MUL_DIV);
-        next();
-        break;
-
-      case TOKEN_MOD:
-        opstack.pushOperator(Kind::MOD, PREC_MUL_DIV);
-        next();
-        break;
-
-      case TOKEN_AMP:
-        opstack.pushOperator(Kind::BIT_AND, PREC_BIT_AND);
-        next();
-        break;
-
-      case TOKEN_VBAR:
-        opstack.pushOperator(Kind::BIT_OR, PREC_BIT_OR);
-        next();
-        break;
-
-      case TOKEN_CARET:
-        opstack.pushOperator(Kind::BIT_XOR, PREC_BIT_XOR);
-        next();
-        break;
-
-      case TOKEN_AND:
-        opstack.pushOperator(Kind::LOGICAL_AND, PREC_LOGICAL_AND);
-        next();
-        break;
-
-      case TOKEN_OR:
-        opstack.pushOperator(Kind::LOGICAL_OR, PREC_LOGICAL_OR);
-        next();
-        break;
-
-      case TOKEN_LSHIFT:
-        opstack.pushOperator(Kind::LSHIFT, PREC_SHIFT);
-        next();
-        break;
-
-      case TOKEN_RSHIFT:
-        opstack.pushOperator(Kind::RSHIFT, PREC_SHIFT);
-        next();
-        break;
-
-        case TOKEN_RANGE:
-        opstack.pushOperator(Kind::RANGE, PREC_RANGE);
-        next();
-        break;
-
-      case TOKEN_EQ:
-        opstack.pushOperator(Kind::EQUAL, PREC_RELATIONAL);
-        next();
-        break;
-
-      case TOKEN_NE:
-        opstack.pushOperator(Kind::NOT_EQUAL, PREC_RELATIONAL);
-        next();
-        break;
-
-      case TOKEN_REF_EQ:
-        opstack.pushOperator(Kind::REF_EQUAL, PREC_RELATIONAL);
-        next();
-        break;
-
-      case TOKEN_LT:
-        opstack.pushOperator(Kind::LESS_THAN, PREC_RELATIONAL);
-        next();
-        break;
-
-      case TOKEN_GT:
-        opstack.pushOperator(Kind::GREATER_THAN, PREC_RELATIONAL);
-        next();
-        break;
-
-      case TOKEN_LE:
-        opstack.pushOperator(Kind::LESS_THAN_OR_EQUAL, PREC_RELATIONAL);
-        next();
-        break;
-
-      case TOKEN_GE:
-        opstack.pushOperator(Kind::GREATER_THAN_OR_EQUAL, PREC_RELATIONAL);
-        next();
-        break;
-
-//       case TOKEN_RETURNS: {
-//         opstack.pushOperator(Kind::RETURNS, PREC_RETURNS);
-//         next();
-//         break;
-//       }
-
-      case TOKEN_AS: {
-        // The second argument to 'as' is a type expression.
-        opstack.pushOperator(Kind::AS_TYPE, PREC_IS_AS);
-        next();
-        Node* t1 = typeExpression();
-        if (t1 == nullptr) {
-          return nullptr;
-        }
-        opstack.pushOperand(t1);
-        continue;
-      }
-
-      case TOKEN_IS: {
-        next();
-
-        // Handle 'is not'
-        if (match(TOKEN_NOT)) {
-          opstack.pushOperator(Kind::IS_NOT, PREC_IS_AS);
-        } else {
-          opstack.pushOperator(Kind::IS, PREC_IS_AS);
-        }
-
-        // Second argument is a type
-        Node* t1 = typeExpression();
-        if (t1 == nullptr) {
-          return nullptr;
-        }
-        opstack.pushOperand(t1);
-        continue;
-      }
-
-      case TOKEN_COLON: {
-        // Used is for tuples that are actually parameter lists.
-        opstack.pushOperator(Kind::EXPR_TYPE, PREC_RANGE);
-        next();
-        Node* t1 = typeExpression();
-        if (t1 == nullptr) {
-          return nullptr;
-        }
-        opstack.pushOperand(t1);
-        continue;
-      }
-
-      case TOKEN_IN:
-        opstack.pushOperator(Kind::IN, PREC_IN);
-        next();
-        break;
-
-      case TOKEN_FAT_ARROW:
-        opstack.pushOperator(Kind::LAMBDA, PREC_FAT_ARROW);
-        next();
-        break;
+    const BinaryOperator& op = BINARY_OPERATORS[_token];
+    if (op.kind == Kind::ABSENT || op.precedence < minPrec) {
+      return left;
+    }
+    next();
 
-      case TOKEN_NOT: {
-        // Negated operators
-        next();
-        Location loc = location();
-        if (match(TOKEN_IN)) {
-          opstack.pushOperator(Kind::NOT_IN, PREC_IN);
-        } else {
-          _reporter.error(loc) << "'in' expected after 'not'";
-        }
-        break;
+    Kind kind = op.kind;
+    if (_token == TOKEN_NOT && kind == Kind::IS) {
+      // Handle 'is not'
+      next();
+      kind = Kind::IS_NOT;
+    } else if (kind == Kind::NOT_IN) {
+      // Negated operators
+      Location loc = location();
+      if (!match(TOKEN_IN)) {
+        _reporter.error(loc) << "'in' expected after 'not'";
+        return nullptr;
       }
-
-      default:
-        goto done;
     }
 
-    Node* e1 = unary();
-    if (e1 == nullptr) {
+    Node* right = op.operand == OPERAND_TYPE ? typeExpression() : unary();
+    if (right == nullptr) {
       return nullptr;
     }
-    opstack.pushOperand(e1);
-  }
-
-done:
-  if (!opstack.reduceAll()) {
-    return e0;
+    right = binaryRest(
+        right, op.associativity == ASSOC_RIGHT ? op.precedence : op.precedence + 1);
+    if (right == nullptr) {
+      return nullptr;
+    }
+    left = ast::Oper::create(
+        _arena, kind, left->location() | right->location(), { left, right });
   }
-
-  return opstack.expression();
 }
 
 #if 0
@@ -2031,7 +2074,7 @@ Node* Parser::primary() {
       if (builder.size() == 1 && !trailingComma) {
         return builder[0];
       }
-      return new (_arena) ast::Oper(Kind::TUPLE, loc, builder.build());
+      return ast::Oper::create(_arena, Kind::TUPLE, loc, builder.contents());
     }
     case TOKEN_TRUE: return node(Kind::BOOLEAN_TRUE);
     case TOKEN_FALSE: return node(Kind::BOOLEAN_FALSE);
@@ -2131,7 +2174,7 @@ Node* Parser::primarySuffix(Node* expr) {
   while (_token != TOKEN_END) {
     if (match(TOKEN_DOT)) {
       if (_token == TOKEN_ID) {
-        expr = new (_arena) ast::MemberRef(openLoc | location(), copyOf(tokenValue()), expr);
+        expr = new (_arena) ast::MemberRef(openLoc | location(), tokenName(), expr);
         next();
       } else {
         expected("identifier");
@@ -2142,7 +2185,7 @@ Node* Parser::primarySuffix(Node* expr) {
       if (!callingArgs(args, callLoc)) {
         return nullptr;
       }
-      ast::Oper* call = new (_arena) ast::Oper(Kind::CALL, callLoc, args.build());
+      ast::Oper* call = ast::Oper::create(_arena, Kind::CALL, callLoc, args.contents());
       call->setOp(expr);
       expr = call;
     } else if (match(TOKEN_LBRACKET)) {
@@ -2168,7 +2211,8 @@ Node* Parser::primarySuffix(Node* expr) {
           }
         }
       }
-      ast::Oper* spec = new (_arena) ast::Oper(Kind::SPECIALIZE, fullLoc, typeArgs.build());
+      ast::Oper* spec =
+          ast::Oper::create(_arena, Kind::SPECIALIZE, fullLoc, typeArgs.contents());
       spec->setOp(expr);
       expr = spec;
     } else {
@@ -2196,11 +2240,8 @@ bool Parser::callingArgs(ast::NodeListBuilder &args, Location& argsLoc) {
         if (kwValue == nullptr) {
           return false;
         }
-        ast::NodeListBuilder kwArg(_arena);
-        kwArg.append(arg);
-        kwArg.append(kwValue);
-        arg = new (_arena) ast::Oper(
-            Kind::KEYWORD_ARG, arg->location() | kwValue->location(), kwArg.build());
+        arg = ast::Oper::create(
+            _arena, Kind::KEYWORD_ARG, arg->location() | kwValue->location(), { arg, kwValue });
       }
 
       args.append(arg);
@@ -2243,7 +2284,7 @@ Node* Parser::dottedIdent() {
     while (match(TOKEN_DOT)) {
       if (_token == TOKEN_ID) {
         result = new (_arena) ast::MemberRef(
-            result->location() | location(), copyOf(tokenValue()), result);
+            result->location() | location(), tokenName(), result);
         next();
       } else {
         expected("identifier");
@@ -2255,7 +2296,7 @@ Node* Parser::dottedIdent() {
 
 Node* Parser::id() {
   assert(_token == TOKEN_ID);
-  Node* node = new (_arena) ast::Ident(location(), copyOf(tokenValue()));
+  Node* node = new (_arena) ast::Ident(location(), tokenName());
   next();
   return node;
 }
@@ -2263,7 +2304,7 @@ Node* Parser::id() {
 Node* Parser::stringLit() {
   assert(_token == TOKEN_STRING_LIT);
   Node* node = new (_arena) ast::TextLiteral(
-      Kind::STRING_LITERAL, location(), copyOf(tokenValue()));
+      Kind::STRING_LITERAL, location(), tokenText());
   next();
   return node;
 }
@@ -2271,7 +2312,7 @@ Node* Parser::stringLit() {
 Node* Parser::charLit() {
   assert(_token == TOKEN_CHAR_LIT);
   Node* node = new (_arena) ast::TextLiteral(
-      Kind::CHAR_LITERAL, location(), copyOf(tokenValue()));
+      Kind::CHAR_LITERAL, location(), tokenText());
   next();
   return node;
 }
@@ -2281,12 +2322,12 @@ Node* Parser::integerLit() {
   bool uns = false;
   int64_t value;
   if (_token == TOKEN_DEC_INT_LIT) {
-    value = strtoll(_lexer.tokenValue().c_str(), nullptr, 10);
+    value = strtoll(tokenValue().begin(), nullptr, 10);
   } else {
-    value = strtoll(_lexer.tokenValue().c_str(), nullptr, 16);
+    value = strtoll(tokenValue().begin(), nullptr, 16);
   }
-  if (_lexer.tokenSuffix().empty()) {
-    for (char ch : _lexer.tokenSuffix()) {
+  if (_tokens.suffix(_index).empty()) {
+    for (char ch : _tokens.suffix(_index)) {
       assert(ch == 'u');
       uns = true;
     }
@@ -2298,12 +2339,20 @@ Node* Parser::integerLit() {
 
 Node* Parser::floatLit() {
   assert(_token == TOKEN_FLOAT_LIT);
-  double d = strtod(_lexer.tokenValue().c_str(), nullptr);
+  double d = strtod(tokenValue().begin(), nullptr);
   Node* node = new (_arena) ast::FloatLiteral(location(), d);
   next();
   return node;
 }
 
+StringRef Parser::tokenText() {
+  return (_tokens.flags(_index) & TokenBuffer::DECODED) ? copyOf(tokenValue()) : tokenValue();
+}
+
+Atom Parser::tokenName() {
+  return _token == TOKEN_ID ? _tokens.atom(_index) : Atom::intern(tokenValue());
+}
+
 StringRef Parser::copyOf(const StringRef& str) {
   support::Arena::value_type* data = _arena.allocate(str.size());
   std::copy(str.begin(), str.end(), data);
@@ -2321,9 +2370,9 @@ void Parser::expected(const StringRef& tokens) {
   _reporter.error(location()) << "Expected " << tokens << ".";
 }
 
-bool Parser::skipUntil(const std::unordered_set<TokenType>& tokens) {
+bool Parser::skipUntil(const TokenSet& tokens) {
   while (_token != TOKEN_END) {
-    if (tokens.find(_token) != tokens.end()) {
+    if (tokens.contains(_token)) {
       return true;
     }
     next();
@@ -2331,12 +2380,6 @@ bool Parser::skipUntil(const std::unordered_set<TokenType>& tokens) {
   return false;
 }
 
-static const std::unordered_set<TokenType> DEFN_TOKENS = {
-  TOKEN_CLASS, TOKEN_STRUCT, TOKEN_INTERFACE, TOKEN_ENUM, TOKEN_EXTEND,
-  TOKEN_DEF, TOKEN_UNDEF, TOKEN_OVERRIDE,
-  TOKEN_VAR, TOKEN_LET
-};
-
 bool Parser::skipOverDefn() {
   int nesting = 0;
   while (_token != TOKEN_END) {
@@ -2346,7 +2389,7 @@ bool Parser::skipOverDefn() {
       if (nesting > 0) {
         nesting -= 1;
       }
-    } else if (nesting == 0 && DEFN_TOKENS.find(_token) != DEFN_TOKENS.end()) {
+    } else if (nesting == 0 && DEFN_START_TOKENS.contains(_token)) {
       return true;
     }
     next();
@@ -2370,49 +2413,4 @@ bool Parser::skipOverDefn() {
       self.lexer.commentLines = []
 #endif
 
-void OperatorStack::pushOperand(Node* operand) {
-  assert(_entries.back().operand == nullptr);
-  _entries.back().operand = operand;
-}
-
-bool OperatorStack::pushOperator(ast::Kind oper, int16_t prec, bool rightAssoc) {
-  assert(_entries.back().operand != nullptr);
-  if (!reduce(prec, rightAssoc)) {
-    return false;
-  }
-
-  _entries.push_back(Entry());
-  _entries.back().oper = oper;
-  _entries.back().precedence = prec;
-  _entries.back().rightAssoc = rightAssoc;
-  _entries.back().operand = nullptr;
-  return true;
-}
-
-bool OperatorStack::reduce(int16_t precedence, bool rightAssoc) {
-  while (_entries.size() > 1) {
-    Entry back = _entries.back();
-    if (back.precedence < precedence) {
-      break;
-    }
-    assert(back.operand != nullptr);
-    _entries.pop_back();
-    ast::NodeListBuilder args(_arena);
-    args.append(_entries.back().operand);
-    args.append(back.operand);
-    Location loc = _entries.back().operand->location() | back.operand->location();
-    Node* combined = new (_arena) ast::Oper(back.oper, loc, args.build());
-    _entries.back().operand = combined;
-  }
-  return true;
-}
-
-bool OperatorStack::reduceAll() {
-  if (!reduce(0, 0)) {
-    return false;
-  }
-  assert(_entries.size() == 1);
-  return true;
-}
-
 }}
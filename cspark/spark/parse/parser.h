@@ -9,8 +9,8 @@
   #include "spark/config.h"
 #endif
 
-#ifndef SPARK_PARSE_LEXER_H
-  #include "spark/parse/lexer.h"
+#ifndef SPARK_PARSE_TOKENBUFFER_H
+  #include "spark/parse/tokenbuffer.h"
 #endif
 
 #ifndef SPARK_AST_NODE_H
@@ -33,14 +33,19 @@
   #include "spark/support/arena.h"
 #endif
 
-#if SPARK_HAVE_UNORDERED_SET
-  #include <unordered_set>
+#ifndef SPARK_SUPPORT_ARRAYBUILDER_H
+  #include "spark/support/arraybuilder.h"
+#endif
+
+#if SPARK_HAVE_VECTOR
+  #include <vector>
 #endif
 
 namespace spark {
 namespace ast {
 class Defn;
 class Module;
+struct Span;
 }
 namespace error {
 class Reporter;
@@ -51,75 +56,79 @@ using spark::source::ProgramSource;
 using spark::source::Location;
 using spark::error::Reporter;
 
-/** Stack used for operator precedence parsing. */
-class OperatorStack {
-public:
-  /** Contains an operator/operand pair. The bottom element of the stack contains only an
-      operand:
-
-      [NULL value][op value][op value] ...
-   */
-  struct Entry {
-    ast::Node* operand;
-    ast::Kind oper;
-    int16_t precedence;
-    bool rightAssoc;
-
-    Entry()
-      : operand(nullptr)
-      , oper(ast::Kind::ABSENT)
-      , precedence(0)
-      , rightAssoc(false)
-    {}
-
-    Entry(const Entry& entry)
-      : operand(entry.operand)
-      , oper(entry.oper)
-      , precedence(entry.precedence)
-      , rightAssoc(entry.rightAssoc)
-    {}
-  };
-
-  OperatorStack(ast::Node* initialExpr, support::Arena& arena)
-    : _arena(arena)
-  {
-    _entries.push_back(Entry());
-    _entries.back().operand = initialExpr;
-  }
+/** A change to the text of a source file: 'length' bytes starting at file offset 'offset' were
+    replaced by 'newLength' bytes. */
+struct TextEdit {
+  uint32_t offset;
+  uint32_t length;
+  uint32_t newLength;
+};
 
-  void pushOperand(ast::Node* operand);
-  bool pushOperator(ast::Kind oper, int16_t prec, bool rightAssoc = false);
-  bool reduce(int16_t precedence, bool rightAssoc = false);
-  bool reduceAll();
+/** The top-level definitions that were changed by an incremental reparse. */
+struct ModuleChanges {
+  /** Members of the previous module that were replaced. */
+  std::vector<const ast::Node*> removed;
 
-  ast::Node * expression() const {
-    return _entries.front().operand;
-  }
-private:
-  support::Arena& _arena;
-  std::vector<Entry> _entries;
+  /** Members of the new module that were parsed, rather than reused. */
+  std::vector<const ast::Node*> added;
+
+  /** True if the whole file had to be parsed again, so that no members were reused. */
+  bool full;
+
+  ModuleChanges() : full(false) {}
 };
 
-/** Spark source parser. */
+/** Spark source parser. The source file is tokenized in full before parsing begins, and the
+    parser walks the resulting token buffer by index. Names and literal text in the resulting AST
+    may refer directly to the source text, so the source must outlive the AST. */
 class Parser {
 public:
   Parser(Reporter& reporter, ProgramSource* source, support::Arena& arena);
 
+  /** If true, the bodies of functions and property accessors are not parsed; the parser only
+      finds the matching closing brace, and stores an ast::DeferredBody in place of the body.
+      This is used for modules which are only loaded so that their declarations can be seen. */
+  bool deferBodies() const { return _deferBodies; }
+  void setDeferBodies(bool defer) { _deferBodies = defer; }
+
   ast::Module* module();
   ast::Node* expression();
   ast::Node* typeExpression();
+
+  /** Return the body of a function which was skipped by a parser with deferBodies set,
+      parsing it first if it has not been parsed already. Errors in the body are reported to
+      'reporter', and result in a null return. */
+  static const ast::Node* parseDeferredBody(Reporter& reporter, const ast::DeferredBody* body);
+
+  /** Parse 'source', the result of applying 'edit' to the text that 'previous' was parsed
+      from, parsing only the top-level declarations that the edit touches. The other members of
+      'previous' are reused as they are, along with its imports; since they are the same
+      objects, their locations still refer to the previous version of the source, which must
+      be kept for as long as they are in use. If the edit affects the imports, or the
+      declarations can't be parsed on their own, the whole file is parsed again. The members
+      that were replaced and added are recorded in 'changes'. Returns nullptr if the new text
+      has syntax errors. */
+  static ast::Module* reparse(Reporter& reporter, ProgramSource* source, support::Arena& arena,
+      const ast::Module* previous, const TextEdit& edit, ModuleChanges& changes);
 private:
   Reporter&         _reporter;
   ProgramSource*    _source;
   support::Arena&   _arena;
-  Lexer             _lexer;
-  TokenType         _token;
+  TokenBuffer       _tokens;
+  uint32_t          _index;         /** Index of the current token. */
+  TokenType         _token;         /** Type of the current token. */
   bool              _recovering;
+  bool              _deferBodies;
+
+  /** Construct a parser for the tokens between the file-relative offsets 'from' and 'to'. */
+  Parser(Reporter& reporter, ProgramSource* source, support::Arena& arena, uint32_t from,
+      uint32_t to);
 
+  bool declarationList(ast::NodeListBuilder& decls, support::ArrayBuilder<ast::Span>& spans);
   bool declaration(ast::NodeListBuilder& decls, bool isProtected = false, bool isPrivate = false);
   ast::Node* attribute();
   ast::Defn* memberDef();
-  collections::StringRef methodName();
+  collections::Atom methodName();
   ast::Defn* compositeTypeDef();
   bool classBody(ast::TypeDefn* d);
   bool classMember(ast::NodeListBuilder &members, ast::NodeListBuilder &friends);
@@ -127,6 +136,7 @@ private:
   bool enumMember(ast::NodeListBuilder &members);
   ast::Defn* methodDef();
   ast::Node* methodBody();
+  ast::Node* deferredBody();
   void templateParamList(ast::NodeListBuilder& params);
   ast::TypeParameter* templateParam();
 
@@ -149,6 +159,7 @@ private:
 
   ast::Node* exprList();
   ast::Node* binary();
+  ast::Node* binaryRest(ast::Node* left, int minPrec);
   ast::Node* unary();
   ast::Node* primary();
   ast::Node* namedPrimary();
@@ -185,11 +196,23 @@ private:
   /** Match a token. */
   bool match(TokenType tok);
 
+  /** Return the type of the token 'n' places after the current one. */
+  TokenType peek(uint32_t n = 1) const {
+    return _tokens.kind(std::min(_index + n, _tokens.size() - 1));
+  }
+
   /** Location of current token. */
-  const Location& location() const { return _lexer.tokenLocation(); }
+  Location location() const { return _tokens.location(_index); }
 
   /** String value of current token. */
-  const std::string& tokenValue() const { return _lexer.tokenValue(); }
+  collections::StringRef tokenValue() const { return _tokens.value(_index); }
+
+  /** String value of the current token, in storage that lives as long as the AST: either a slice
+      of the source text, or a copy in the arena if the token had to be decoded. */
+  collections::StringRef tokenText();
+
+  /** Interned name of the current token. */
+  collections::Atom tokenName();
 
   /** Make a copy of this string within the current arena. */
   collections::StringRef copyOf(const collections::StringRef& str);
@@ -198,7 +221,7 @@ private:
   void expected(const collections::StringRef& tokens);
 
   /** Skip until one of the given tokens is encountered. */
-  bool skipUntil(const std::unordered_set<TokenType>& tokens);
+  bool skipUntil(const TokenSet& tokens);
 
   /** Skip to the start of the next defn. */
   bool skipOverDefn();
@@ -0,0 +1,205 @@
+// ============================================================================
+// scan.cpp: Vectorized character scanning kernels used by the lexer.
+// ============================================================================
+
+#include "spark/parse/scan.h"
+
+#if SPARK_HAVE_STDINT_H
+  #include <stdint.h>
+#endif
+
+#if SPARK_HAVE_IMMINTRIN_H && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #define SPARK_SCAN_X86 1
+  #include <immintrin.h>
+#endif
+
+namespace spark {
+namespace parse {
+
+namespace {
+  inline bool isHorizontalSpace(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\b';
+  }
+
+  // Scalar kernels. The vector kernels also use these to process the tail of the buffer.
+
+  const char* skipSpaceScalar(const char* pos, const char* end) {
+    while (pos < end && isHorizontalSpace(*pos)) {
+      ++pos;
+    }
+    return pos;
+  }
+
+  const char* findLineEndScalar(const char* pos, const char* end) {
+    while (pos < end && *pos != '\n' && *pos != '\r') {
+      ++pos;
+    }
+    return pos;
+  }
+
+  const char* findCommentEndScalar(const char* pos, const char* end) {
+    for (; pos < end; ++pos) {
+      if (*pos == '*' && pos + 1 < end && pos[1] == '/') {
+        return pos;
+      }
+    }
+    return end;
+  }
+
+  const ScanKernels SCALAR_KERNELS = {
+    "scalar",
+    skipSpaceScalar,
+    findLineEndScalar,
+    findCommentEndScalar,
+  };
+
+#if SPARK_SCAN_X86
+  __attribute__((target("sse2")))
+  const char* skipSpaceSSE2(const char* pos, const char* end) {
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i bs = _mm_set1_epi8('\b');
+    while (end - pos >= 16) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+      __m128i ws = _mm_or_si128(
+          _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+          _mm_cmpeq_epi8(v, bs));
+      uint32_t other = ~uint32_t(_mm_movemask_epi8(ws)) & 0xffff;
+      if (other != 0) {
+        return pos + __builtin_ctz(other);
+      }
+      pos += 16;
+    }
+    return skipSpaceScalar(pos, end);
+  }
+
+  __attribute__((target("sse2")))
+  const char* findLineEndSSE2(const char* pos, const char* end) {
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    while (end - pos >= 16) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+      uint32_t eol = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr)));
+      if (eol != 0) {
+        return pos + __builtin_ctz(eol);
+      }
+      pos += 16;
+    }
+    return findLineEndScalar(pos, end);
+  }
+
+  __attribute__((target("sse2")))
+  const char* findCommentEndSSE2(const char* pos, const char* end) {
+    const __m128i star = _mm_set1_epi8('*');
+    while (end - pos >= 16) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+      uint32_t stars = _mm_movemask_epi8(_mm_cmpeq_epi8(v, star));
+      while (stars != 0) {
+        unsigned index = __builtin_ctz(stars);
+        if (pos + index + 1 < end && pos[index + 1] == '/') {
+          return pos + index;
+        }
+        stars &= stars - 1;
+      }
+      pos += 16;
+    }
+    return findCommentEndScalar(pos, end);
+  }
+
+  __attribute__((target("avx2")))
+  const char* skipSpaceAVX2(const char* pos, const char* end) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i bs = _mm256_set1_epi8('\b');
+    while (end - pos >= 32) {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+      __m256i ws = _mm256_or_si256(
+          _mm256_or_si256(_mm256_cmpeq_epi8(v, space), _mm256_cmpeq_epi8(v, tab)),
+          _mm256_cmpeq_epi8(v, bs));
+      uint32_t other = ~uint32_t(_mm256_movemask_epi8(ws));
+      if (other != 0) {
+        return pos + __builtin_ctz(other);
+      }
+      pos += 32;
+    }
+    return skipSpaceSSE2(pos, end);
+  }
+
+  __attribute__((target("avx2")))
+  const char* findLineEndAVX2(const char* pos, const char* end) {
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    while (end - pos >= 32) {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+      uint32_t eol = _mm256_movemask_epi8(
+          _mm256_or_si256(_mm256_cmpeq_epi8(v, lf), _mm256_cmpeq_epi8(v, cr)));
+      if (eol != 0) {
+        return pos + __builtin_ctz(eol);
+      }
+      pos += 32;
+    }
+    return findLineEndSSE2(pos, end);
+  }
+
+  __attribute__((target("avx2")))
+  const char* findCommentEndAVX2(const char* pos, const char* end) {
+    const __m256i star = _mm256_set1_epi8('*');
+    while (end - pos >= 32) {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+      uint32_t stars = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, star));
+      while (stars != 0) {
+        unsigned index = __builtin_ctz(stars);
+        if (pos + index + 1 < end && pos[index + 1] == '/') {
+          return pos + index;
+        }
+        stars &= stars - 1;
+      }
+      pos += 32;
+    }
+    return findCommentEndSSE2(pos, end);
+  }
+
+  const ScanKernels SSE2_KERNELS = {
+    "sse2",
+    skipSpaceSSE2,
+    findLineEndSSE2,
+    findCommentEndSSE2,
+  };
+
+  const ScanKernels AVX2_KERNELS = {
+    "avx2",
+    skipSpaceAVX2,
+    findLineEndAVX2,
+    findCommentEndAVX2,
+  };
+#endif
+}
+
+const ScanKernels& ScanKernels::select() {
+  static const ScanKernels& best = avx2() ? *avx2() : sse2() ? *sse2() : scalar();
+  return best;
+}
+
+const ScanKernels& ScanKernels::scalar() {
+  return SCALAR_KERNELS;
+}
+
+const ScanKernels* ScanKernels::sse2() {
+#if SPARK_SCAN_X86
+  if (__builtin_cpu_supports("sse2")) {
+    return &SSE2_KERNELS;
+  }
+#endif
+  return nullptr;
+}
+
+const ScanKernels* ScanKernels::avx2() {
+#if SPARK_SCAN_X86
+  if (__builtin_cpu_supports("avx2")) {
+    return &AVX2_KERNELS;
+  }
+#endif
+  return nullptr;
+}
+
+}}
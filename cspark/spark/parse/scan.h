@@ -0,0 +1,47 @@
+// ============================================================================
+// scan.h: Vectorized character scanning kernels used by the lexer.
+// ============================================================================
+
+#ifndef SPARK_PARSE_SCAN_H
+#define SPARK_PARSE_SCAN_H 1
+
+#ifndef SPARK_CONFIG_H
+  #include "spark/config.h"
+#endif
+
+namespace spark {
+namespace parse {
+
+/** A set of routines for quickly skipping over runs of whitespace and comment text. Each
+    routine scans forward from 'pos' and never reads at or past 'end'. Several implementations
+    exist; the best one for the host CPU is chosen at runtime. */
+struct ScanKernels {
+  /** Name of this implementation, for diagnostics and benchmarks. */
+  const char* name;
+
+  /** Return the first character in [pos, end) that is not a space, tab or backspace. */
+  const char* (*skipSpace)(const char* pos, const char* end);
+
+  /** Return the first CR or LF character in [pos, end), or 'end' if there is none. */
+  const char* (*findLineEnd)(const char* pos, const char* end);
+
+  /** Return a pointer to the first '*' character in [pos, end) that is followed by a '/', or
+      'end' if the comment is not terminated. */
+  const char* (*findCommentEnd)(const char* pos, const char* end);
+
+  /** The best implementation supported by this CPU. */
+  static const ScanKernels& select();
+
+  /** Portable implementation, one character at a time. */
+  static const ScanKernels& scalar();
+
+  /** SSE2 implementation, or nullptr if not available. */
+  static const ScanKernels* sse2();
+
+  /** AVX2 implementation, or nullptr if not available. */
+  static const ScanKernels* avx2();
+};
+
+}}
+
+#endif
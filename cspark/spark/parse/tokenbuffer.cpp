@@ -0,0 +1,120 @@
+// ============================================================================
+// tokenbuffer.cpp: The tokens of an entire source file.
+// ============================================================================
+
+#include "spark/parse/tokenbuffer.h"
+
+#if SPARK_HAVE_ALGORITHM
+  #include <algorithm>
+#endif
+
+#if SPARK_HAVE_CSTRING
+  #include <cstring>
+#endif
+
+namespace spark {
+namespace parse {
+using collections::StringRef;
+
+static_assert(TOKEN_LAST <= 256, "Token types must fit in a byte.");
+
+namespace {
+  /** True if the text between two tokens includes a line break. */
+  inline bool hasLineBreak(const char* pos, size_t size) {
+    return ::memchr(pos, '\n', size) != nullptr || ::memchr(pos, '\r', size) != nullptr;
+  }
+}
+
+void TokenBuffer::tokenize(source::ProgramSource* source) {
+  tokenize(source, 0, uint32_t(source->content().size()));
+}
+
+void TokenBuffer::tokenize(source::ProgramSource* source, uint32_t from, uint32_t to) {
+  StringRef content = source->content();
+  _text = content.begin();
+  _base = source->base();
+  _kinds.clear();
+  _begins.clear();
+  _lengths.clear();
+  _flags.clear();
+  _valueIndex.clear();
+  _values.clear();
+  _strings.clear();
+
+  // Source files average a little over one token per five bytes.
+  size_t estimate = (to - from) / 5 + 16;
+  _kinds.reserve(estimate);
+  _begins.reserve(estimate);
+  _lengths.reserve(estimate);
+  _flags.reserve(estimate);
+  _valueIndex.reserve(estimate);
+
+  Lexer lexer(source, from, to);
+  uint32_t prevEnd = _base + from;
+  bool stalled = false;
+  for (;;) {
+    // A token that doesn't advance past the previous one would repeat forever, so end there.
+    TokenType tok = stalled ? TOKEN_END : lexer.next();
+    uint32_t begin;
+    uint32_t end;
+    if (tok == TOKEN_END) {
+      // The lexer doesn't give the end token a location, so put it at the end of the text.
+      begin = end = _base + to;
+    } else {
+      begin = lexer.tokenLocation().begin;
+      end = lexer.tokenLocation().end;
+    }
+
+    uint8_t flags = 0;
+    if (begin > prevEnd) {
+      flags |= SPACE_BEFORE;
+    }
+    if (_kinds.empty() || hasLineBreak(_text + (prevEnd - _base), begin - prevEnd)) {
+      flags |= LINE_START;
+    }
+
+    uint32_t valueIndex = 0;
+    StringRef value = tok == TOKEN_END ? StringRef() : lexer.tokenValue();
+    if (!value.empty() || tok == TOKEN_ERROR) {
+      if (tok != TOKEN_ID && !lexer.tokenDecoded() && value.begin() == _text + (begin - _base) &&
+          value.size() == end - begin) {
+        flags |= TEXT_VALUE;
+      } else {
+        Value v;
+        v.value = value;
+        if (lexer.tokenDecoded()) {
+          v.value = copyValue(value);
+          flags |= DECODED;
+        }
+        v.suffix = lexer.tokenSuffix().empty() ? StringRef() : copyValue(lexer.tokenSuffix());
+        v.atom = lexer.tokenAtom();
+        v.error = tok == TOKEN_ERROR ? lexer.errorCode() : Lexer::ERROR_NONE;
+        valueIndex = uint32_t(_values.size());
+        _values.push_back(v);
+        flags |= HAS_VALUE;
+      }
+    }
+
+    _kinds.push_back(uint8_t(tok));
+    _begins.push_back(begin);
+    _lengths.push_back(end - begin);
+    _flags.push_back(flags);
+    _valueIndex.push_back(valueIndex);
+    stalled = end <= prevEnd;
+    prevEnd = std::max(prevEnd, end);
+
+    if (tok == TOKEN_END) {
+      break;
+    }
+  }
+}
+
+StringRef TokenBuffer::copyValue(const StringRef& str) {
+  // Numeric values are parsed with strtoll() and friends, so keep them null-terminated.
+  char* data = reinterpret_cast<char*>(_strings.allocate(str.size() + 1));
+  std::copy(str.begin(), str.end(), data);
+  data[str.size()] = '\0';
+  return StringRef(data, str.size());
+}
+
+}}
@@ -0,0 +1,127 @@
+// ============================================================================
+// tokenbuffer.h: The tokens of an entire source file.
+// ============================================================================
+
+#ifndef SPARK_PARSE_TOKENBUFFER_H
+#define SPARK_PARSE_TOKENBUFFER_H 1
+
+#ifndef SPARK_PARSE_LEXER_H
+  #include "spark/parse/lexer.h"
+#endif
+
+#ifndef SPARK_SUPPORT_ARENA_H
+  #include "spark/support/arena.h"
+#endif
+
+#if SPARK_HAVE_VECTOR
+  #include <vector>
+#endif
+
+namespace spark {
+namespace parse {
+
+/** The complete token stream of a source file, produced by running the lexer over the whole
+    file in one pass. Tokens are stored as parallel arrays (kind, begin offset, length and
+    flags) and are addressed by index, so any token can be examined at any time; the stream can
+    be walked more than once, and by tools other than the parser. The last token is always
+    TOKEN_END.
+
+    Token values (identifier names, literal contents and numeric suffixes) are kept in a
+    separate table, since most tokens are punctuation or keywords that don't need one. The
+    buffer must not outlive the source that it was built from. */
+class TokenBuffer {
+public:
+  /** Token flags. */
+  enum Flags {
+    SPACE_BEFORE = 1 << 0,  /** Token is preceded by whitespace or a comment. */
+    LINE_START = 1 << 1,    /** Token is the first on its line. */
+    HAS_VALUE = 1 << 2,     /** Token has an entry in the value table. */
+    TEXT_VALUE = 1 << 3,    /** Token value is the token text (keywords). */
+    DECODED = 1 << 4,       /** Token value was decoded rather than sliced from the source. */
+  };
+
+  TokenBuffer() : _text(nullptr), _base(0) {}
+  TokenBuffer(const TokenBuffer&) = delete;
+  TokenBuffer& operator=(const TokenBuffer&) = delete;
+
+  /** Tokenize the entire contents of 'source', replacing the current contents. */
+  void tokenize(source::ProgramSource* source);
+
+  /** Tokenize the text of 'source' between the file-relative offsets 'from' and 'to'. The
+      final TOKEN_END is placed at 'to'. */
+  void tokenize(source::ProgramSource* source, uint32_t from, uint32_t to);
+
+  /** Number of tokens, including the final TOKEN_END. */
+  uint32_t size() const { return uint32_t(_kinds.size()); }
+
+  /** The type of token 'index'. */
+  TokenType kind(uint32_t index) const { return TokenType(_kinds[index]); }
+
+  /** Global offset of the first character of token 'index'. */
+  uint32_t begin(uint32_t index) const { return _begins[index]; }
+
+  /** Length of token 'index' in bytes. */
+  uint32_t length(uint32_t index) const { return _lengths[index]; }
+
+  /** Flags for token 'index'. */
+  uint8_t flags(uint32_t index) const { return _flags[index]; }
+
+  /** Source location of token 'index'. */
+  source::Location location(uint32_t index) const {
+    return source::Location(_begins[index], _begins[index] + _lengths[index]);
+  }
+
+  /** The source text of token 'index'. */
+  collections::StringRef text(uint32_t index) const {
+    return collections::StringRef(_text + (_begins[index] - _base), _lengths[index]);
+  }
+
+  /** The value of token 'index', as Lexer::tokenValue() would have returned it. Unlike the
+      lexer, decoded values remain valid for the lifetime of the buffer. */
+  collections::StringRef value(uint32_t index) const {
+    if (_flags[index] & HAS_VALUE) {
+      return _values[_valueIndex[index]].value;
+    }
+    return (_flags[index] & TEXT_VALUE) ? text(index) : collections::StringRef();
+  }
+
+  /** For identifier tokens, the interned name. */
+  collections::Atom atom(uint32_t index) const {
+    return (_flags[index] & HAS_VALUE) ? _values[_valueIndex[index]].atom : collections::Atom();
+  }
+
+  /** Numeric suffix of token 'index'. */
+  collections::StringRef suffix(uint32_t index) const {
+    return (_flags[index] & HAS_VALUE) ? _values[_valueIndex[index]].suffix
+                                       : collections::StringRef();
+  }
+
+  /** For error tokens, the reason for the error. */
+  Lexer::LexerError errorCode(uint32_t index) const {
+    return (_flags[index] & HAS_VALUE) ? _values[_valueIndex[index]].error : Lexer::ERROR_NONE;
+  }
+
+private:
+  struct Value {
+    collections::StringRef value;
+    collections::StringRef suffix;
+    collections::Atom atom;
+    Lexer::LexerError error;
+  };
+
+  const char* _text;                  /** Start of the source text. */
+  uint32_t _base;                     /** Global offset of the start of the source text. */
+  std::vector<uint8_t> _kinds;
+  std::vector<uint32_t> _begins;
+  std::vector<uint32_t> _lengths;
+  std::vector<uint8_t> _flags;
+  std::vector<uint32_t> _valueIndex;  /** Index into _values, for tokens with HAS_VALUE. */
+  std::vector<Value> _values;
+  support::Arena _strings;            /** Storage for decoded values. */
+
+  collections::StringRef copyValue(const collections::StringRef& str);
+};
+
+}}
+
+#endif
@@ -18,10 +18,13 @@
 namespace spark {
 namespace parse {
 
-const char* TOKEN_NAMES[] = {
+constexpr const char* TOKEN_NAMES[] = {
   #include "spark/parse/tokens.txt"
 };
 
+static_assert(sizeof(TOKEN_NAMES) / sizeof(TOKEN_NAMES[0]) == TOKEN_LAST,
+    "Token name table is out of step with the token list.");
+
 const char* GetTokenName(TokenType tt) {
   uint32_t index = (uint32_t)tt;
   if (index < TOKEN_LAST) {
@@ -9,6 +9,10 @@
   #include <ostream>
 #endif
 
+#if SPARK_HAVE_STDINT_H
+  #include <stdint.h>
+#endif
+
 #if SPARK_HAVE_TOKENS_TXT
   #include <tokens.txt>
 #endif
@@ -30,6 +34,53 @@ enum TokenType {
 // Return the name of the specified token.
 const char* GetTokenName(TokenType tt);
 
+/** A set of token types, stored as a bitset. Sets are constexpr, so that sets of constant tokens
+    are built at compile time, and testing membership is a single bit test. */
+class TokenSet {
+public:
+  constexpr TokenSet() : _bits { 0, 0, 0 } {}
+
+  template<class... Tokens>
+  constexpr TokenSet(TokenType first, Tokens... rest)
+    : _bits { word(0, first, rest...), word(1, first, rest...), word(2, first, rest...) }
+  {}
+
+  /** True if 'tok' is in the set. */
+  constexpr bool contains(TokenType tok) const {
+    return (_bits[unsigned(tok) >> 6] >> (unsigned(tok) & 63)) & 1;
+  }
+
+  /** The union of this set and 'other'. */
+  constexpr TokenSet operator|(const TokenSet& other) const {
+    return TokenSet(_bits[0] | other._bits[0], _bits[1] | other._bits[1],
+        _bits[2] | other._bits[2]);
+  }
+
+private:
+  static const unsigned WORDS = 3;
+  uint64_t _bits[WORDS];
+
+  constexpr TokenSet(uint64_t w0, uint64_t w1, uint64_t w2) : _bits { w0, w1, w2 } {}
+
+  /** Bits for word 'index' of the set containing the given tokens. */
+  static constexpr uint64_t word(unsigned) { return 0; }
+
+  template<class... Tokens>
+  static constexpr uint64_t word(unsigned index, TokenType tok, Tokens... rest) {
+    return (unsigned(tok) >> 6 == index ? uint64_t(1) << (unsigned(tok) & 63) : 0)
+        | word(index, rest...);
+  }
+
+  static_assert(TOKEN_LAST <= WORDS * 64, "Too many tokens for TokenSet.");
+};
+
+// Named token sets, from tokens.txt.
+#undef DEFINE_TOKEN
+#define DEFINE_TOKEN(x)
+#define TOKEN_SET(name, ...) constexpr TokenSet name##_TOKENS(__VA_ARGS__);
+#include "tokens.txt"
+#undef DEFINE_TOKEN
+
 // How to print a token type.
 inline ::std::ostream& operator<<(::std::ostream& os, TokenType tt) {
   return os << GetTokenName(tt);
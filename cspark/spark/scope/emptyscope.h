@@ -0,0 +1,42 @@
+// ============================================================================
+// scope/emptyscope.h: A scope with nothing in it.
+// ============================================================================
+
+#ifndef SPARK_SCOPE_EMPTYSCOPE_H
+#define SPARK_SCOPE_EMPTYSCOPE_H 1
+
+#ifndef SPARK_SCOPE_SCOPE_H
+  #include "spark/scope/scope.h"
+#endif
+
+#if SPARK_HAVE_CASSERT
+  #include <cassert>
+#endif
+
+namespace spark {
+namespace scope {
+
+/** A scope which never contains anything. This stands in for scopes which are created lazily,
+    and haven't been created yet because nothing has been added to them. */
+class EmptyScope : public SymbolScope {
+public:
+  /** The one and only empty scope. */
+  static EmptyScope* get() {
+    static EmptyScope instance;
+    return &instance;
+  }
+
+  ScopeType scopetype() const { return DEFAULT; }
+  void addMember(Member* m) { assert(false && "Can't add members to the empty scope."); }
+  void lookupName(Atom name, std::vector<Member*> &result) const {}
+  void forAllNames(NameFunctor& nameFn) const {}
+  bool empty() const { return true; }
+  void describe(std::ostream& strm) const { strm << "empty scope"; }
+
+private:
+  EmptyScope() {}
+};
+
+}}
+
+#endif
@@ -15,7 +15,7 @@ void InheritedScope::addMember(Member* m) {
   assert(false && "not implemented");
 }
 
-void InheritedScope::lookupName(const StringRef& name, std::vector<Member*> &result) const {
+void InheritedScope::lookupName(Atom name, std::vector<Member*> &result) const {
   std::vector<Member*> members;
   _primary->lookupName(name, members);
   if (!members.empty()) {
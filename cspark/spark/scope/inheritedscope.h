@@ -39,7 +39,7 @@ public:
   }
 
   void addMember(Member* m);
-  void lookupName(const StringRef& name, std::vector<Member*> &result) const;
+  void lookupName(Atom name, std::vector<Member*> &result) const;
   void forAllNames(NameFunctor& nameFn) const;
   void describe(std::ostream& strm) const;
 private:
@@ -7,7 +7,7 @@ void ModulePathScope::addMember(semgraph::Member* m) {
   assert(false && "addMember() not implemented for ModulePathScope");
 }
 
-void ModulePathScope::lookupName(const StringRef& name, std::vector<Member*> &result) const {
+void ModulePathScope::lookupName(Atom name, std::vector<Member*> &result) const {
   for (Importer* imp : _importers) {
     imp->lookupName(name, result);
   }
@@ -21,14 +21,14 @@ using semgraph::Defn;
 class Importer {
 public:
   /** Attempt to locate all symbols under this package with the name 'name'. */
-  virtual void lookupName(const StringRef& name, std::vector<Member*> &result) = 0;
+  virtual void lookupName(Atom name, std::vector<Member*> &result) = 0;
 };
 
 /** A virtual scope that looks for top-level symbols via the module path list. */
 class ModulePathScope : public scope::SymbolScope {
 public:
   ScopeType scopetype() const { return DEFAULT; }
-  void lookupName(const StringRef& name, std::vector<Member*> &result) const;
+  void lookupName(Atom name, std::vector<Member*> &result) const;
   void forAllNames(NameFunctor& nameFn) const {}
   void describe(std::ostream& strm) const;
 
@@ -9,8 +9,8 @@
   #include "spark/config.h"
 #endif
 
-#ifndef SPARK_COLLECTIONS_STRINGREF_H
-  #include "spark/collections/stringref.h"
+#ifndef SPARK_COLLECTIONS_ATOM_H
+  #include "spark/collections/atom.h"
 #endif
 
 #ifndef SPARK_COLLECTIONS_SMALLSET_H
@@ -30,6 +30,7 @@ namespace semgraph {
 class Member;
 }
 namespace scope {
+using collections::Atom;
 using collections::StringRef;
 using collections::SmallSetBase;
 using semgraph::Member;
@@ -57,11 +58,12 @@ public:
   /** Add a member to this scope. Note that many scope implementations don't allow this. */
   virtual void addMember(semgraph::Member* m) = 0;
 
-  /** Lookup a name, and produce a list of results for that name. */
-  virtual void lookupName(const StringRef& name, std::vector<Member*> &result) const = 0;
+  /** Lookup a name, and produce a list of results for that name. Names are interned, so a name
+      that has never been interned (see Atom::find) can be skipped without a lookup. */
+  virtual void lookupName(Atom name, std::vector<Member*> &result) const = 0;
 
   /** Lookup a name, and produce a list of results for that name. */
-  const std::vector<Member*> lookupName(const StringRef& name) const {
+  const std::vector<Member*> lookupName(Atom name) const {
     std::vector<Member*> result;
     lookupName(name, result);
     return result;
@@ -70,6 +72,10 @@ public:
   /** Call the specified functor for all names defined in this scope. */
   virtual void forAllNames(NameFunctor& nameFn) const = 0;
 
+  /** True if this scope is known to define no names at all. Scopes that can't tell cheaply
+      return false. */
+  virtual bool empty() const { return false; }
+
   /** Produce a description of this scope. */
   virtual void describe(std::ostream& strm) const = 0;
 
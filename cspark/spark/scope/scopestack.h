@@ -9,6 +9,10 @@
   #include "spark/scope/scope.h"
 #endif
 
+#ifndef SPARK_SCOPE_EMPTYSCOPE_H
+  #include "spark/scope/emptyscope.h"
+#endif
+
 namespace spark {
 namespace semgraph {
 class Expr;
@@ -60,6 +64,10 @@ public:
       return *this;
     }
 
+    bool operator==(const Entry& other) const {
+      return scope == other.scope && stem == other.stem;
+    }
+
     SymbolScope* scope;
     Expr* stem;
   };
@@ -68,9 +76,11 @@ public:
   ScopeStack(const ScopeStack& src) : _stack(src._stack) {}
 
   /** Push a new scope onto the stack. The optional 'stem' expression is a reference to the
-      object whose type defines the scope. Most often, 'stem' will be a 'self' expression. */
+      object whose type defines the scope. Most often, 'stem' will be a 'self' expression.
+      A null scope is one that was never created because it would have been empty; it still
+      takes up an entry, so that every push is matched by a pop. */
   void push(SymbolScope* scope, Expr* stem = nullptr) {
-    _stack.push_back(Entry(scope, stem));
+    _stack.push_back(Entry(scope != nullptr ? scope : EmptyScope::get(), stem));
   }
 
   /** Remove the top-most scope from the stack. */
@@ -79,7 +89,7 @@ public:
   }
 
   /** Find a symbol on the closest enclosing scope. */
-  NameLookupResult find(const StringRef& name) {
+  NameLookupResult find(Atom name) {
     NameLookupResult result;
     auto it = _stack.end();
     while (it != _stack.begin()) {
@@ -94,7 +104,7 @@ public:
     return result;
   }
 
-  bool find(const StringRef& name, NameLookupResult& result) {
+  bool find(Atom name, NameLookupResult& result) {
     auto it = _stack.end();
     while (it != _stack.begin()) {
       --it;
@@ -117,6 +127,9 @@ public:
     }
   }
 
+  /** The entries on the stack, outermost first. */
+  const std::vector<Entry>& entries() const { return _stack; }
+
   /** The current size of the stack. */
   size_t size() const { return _stack.size(); }
 
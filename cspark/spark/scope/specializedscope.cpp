@@ -17,7 +17,7 @@ void SpecializedScope::addMember (Member* m) {
   assert(false && "not implemented");
 }
 
-void SpecializedScope::lookupName(const StringRef& name, std::vector<Member*> &result) const {
+void SpecializedScope::lookupName(Atom name, std::vector<Member*> &result) const {
   std::vector<Member*> members;
   _primary->lookupName(name, members);
   sema::types::ApplyEnv apply(_typeStore);
@@ -35,7 +35,7 @@ public:
   ScopeType scopetype() const { return _primary->scopetype(); }
 
   void addMember(Member* m);
-  void lookupName(const StringRef& name, std::vector<Member*> &result) const;
+  void lookupName(Atom name, std::vector<Member*> &result) const;
   void forAllNames(NameFunctor& nameFn) const;
   void describe(std::ostream& strm) const;
 private:
@@ -10,7 +10,7 @@ void StandardScope::addMember(semgraph::Member* m) {
   _entries[m->name()].push_back(m);
 }
 
-void StandardScope::lookupName(const StringRef& name, std::vector<Member*>& result) const {
+void StandardScope::lookupName(Atom name, std::vector<Member*>& result) const {
   EntryMap::const_iterator it = _entries.find(name);
   if (it != _entries.end()) {
     result.insert(result.end(), it->second.begin(), it->second.end());
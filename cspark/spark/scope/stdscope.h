@@ -46,12 +46,13 @@ public:
   void addMember(semgraph::Member* m);
 
   ScopeType scopetype() const { return _scopeType; }
-  void lookupName(const StringRef& name, std::vector<Member*> &result) const;
+  void lookupName(Atom name, std::vector<Member*> &result) const;
   void forAllNames(NameFunctor& nameFn) const;
+  bool empty() const { return _entries.empty(); }
   void describe(std::ostream& strm) const;
   void validate() const final;
 protected:
-  typedef std::unordered_map<StringRef, std::vector<Member*>> EntryMap;
+  typedef std::unordered_map<Atom, std::vector<Member*>> EntryMap;
 
   ScopeType _scopeType;
   EntryMap _entries;
@@ -19,7 +19,7 @@ using support::isa;
 using support::dyn_cast;
 
 void MemberLookup::lookup(
-    const StringRef& name,
+    collections::Atom name,
     const ArrayRef<Member*>& stem,
     bool fromStatic,
     SmallSetBase<Member*>& result) {
@@ -30,7 +30,7 @@ void MemberLookup::lookup(
 }
 
 void MemberLookup::lookup(
-    const StringRef& name,
+    collections::Atom name,
     const ArrayRef<Type*>& stem,
     bool fromStatic,
     SmallSetBase<Member*>& result) {
@@ -40,7 +40,7 @@ void MemberLookup::lookup(
 }
 
 void MemberLookup::lookup(
-    const collections::StringRef& name,
+    collections::Atom name,
     Member* stem,
     bool fromStatic,
     SmallSetBase<Member*>& result) {
@@ -136,7 +136,7 @@ void MemberLookup::forAllNames(Member* stem, scope::NameFunctor& nameFn) {
 }
 
 void MemberLookup::lookup(
-    const collections::StringRef& name,
+    collections::Atom name,
     Type* stem,
     bool fromStatic,
     SmallSetBase<Member*>& result) {
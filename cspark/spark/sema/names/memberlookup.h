@@ -37,6 +37,7 @@ namespace sema {
 namespace names {
 using collections::ArrayRef;
 using collections::SmallSetBase;
+using collections::Atom;
 using collections::StringRef;
 using error::Reporter;
 using semgraph::Member;
@@ -53,28 +54,28 @@ public:
 
   /** Given a list of members to look in, find members with the specified name. */
   void lookup(
-      const StringRef& name,
+      Atom name,
       const ArrayRef<Member*>& stem,
       bool fromStatic,
       SmallSetBase<Member*>& result);
 
   /** Given a list of types to look in, find members with the specified name. */
   void lookup(
-      const StringRef& name,
+      Atom name,
       const ArrayRef<Type*>& stem,
       bool fromStatic,
       SmallSetBase<Member*>& result);
 
   /** Given a member to look in, find members with the specified name. */
   void lookup(
-      const StringRef& name,
+      Atom name,
       Member* stem,
       bool fromStatic,
       SmallSetBase<Member*>& result);
 
   /** Given a type to look in, find members with the specified name. */
   void lookup(
-      const collections::StringRef& name,
+      Atom name,
       Type* stem,
       bool fromStatic,
       SmallSetBase<Member*>& result);
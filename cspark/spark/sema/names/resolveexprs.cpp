@@ -764,7 +764,7 @@ Expr* ResolveExprs::visitBlock(const ast::Oper* oper) {
     if (node->kind() == ast::Kind::VAR || node->kind() == ast::Kind::LET) {
       auto v = static_cast<const ast::ValueDefn*>(node);
       if (blockScope == nullptr) {
-        blockScope = new scope::StandardScope(scope::SymbolScope::LOCAL, "local scope");
+        blockScope = new (_arena) scope::StandardScope(scope::SymbolScope::LOCAL, "local scope");
         _scopeStack->push(blockScope);
         _localScopes.push_back(blockScope);
       }
@@ -793,7 +793,7 @@ Expr* ResolveExprs::visitBlock(const ast::Oper* oper) {
         _reporter.error(alreadyDefined->location()) << "Defined here.";
       }
 
-      auto vdef = new ValueDefn(
+      auto vdef = new (_arena) ValueDefn(
           node->kind() == ast::Kind::VAR ? Defn::Kind::VAR : Defn::Kind::LET,
           v->location(),
           v->name());
@@ -911,7 +911,8 @@ Expr* ResolveExprs::visitFor(const ast::ControlStmt* ast) {
   stmtVars(varsAst, vars);
   stmt->setVars(vars.build());
 
-  scope::SymbolScope* forScope = new scope::StandardScope(scope::SymbolScope::LOCAL, "for scope");
+  scope::SymbolScope* forScope =
+      new (_arena) scope::StandardScope(scope::SymbolScope::LOCAL, "for scope");
   _scopeStack->push(forScope);
   _localScopes.push_back(forScope);
   for (auto vd : stmt->vars()) {
@@ -941,7 +942,8 @@ Expr* ResolveExprs::visitForIn(const ast::ControlStmt* ast) {
   stmtVars(varsAst, vars);
   stmt->setVars(vars.build());
 
-  scope::SymbolScope* forScope = new scope::StandardScope(scope::SymbolScope::LOCAL, "for scope");
+  scope::SymbolScope* forScope =
+      new (_arena) scope::StandardScope(scope::SymbolScope::LOCAL, "for scope");
   _scopeStack->push(forScope);
   _localScopes.push_back(forScope);
   for (auto vd : stmt->vars()) {
@@ -1043,7 +1045,7 @@ Expr* ResolveExprs::visitMatch(const ast::ControlStmt* node) {
         assert(nameAst->kind() == ast::Kind::IDENT);
         name = static_cast<const ast::Ident*>(nameAst)->name();
       }
-      auto var = new ValueDefn(Member::Kind::LET, pn->location(), name);
+      auto var = new (_arena) ValueDefn(Member::Kind::LET, pn->location(), name);
       Type* type = nullptr;
       if (ast::Node::isPresent(typeAst)) {
         type = rt.exec(exec(typeAst));
@@ -1550,7 +1552,7 @@ void ResolveExprs::stmtVars(const ast::ValueDefn* var, support::ArrayBuilder<Val
       stmtVars(static_cast<const ast::ValueDefn*>(m), result);
     }
   } else {
-    auto vd = new ValueDefn(
+    auto vd = new (_arena) ValueDefn(
       var->kind() == ast::Kind::LET ? Defn::Kind::LET : Defn::Kind::VAR,
       var->location(),
       var->name());
@@ -26,7 +26,6 @@ using namespace semgraph;
 using support::dyn_cast;
 
 bool ResolveRequirements::exec(const ast::Node* node) {
-  (void)_arena;
   switch (node->kind()) {
     case ast::Kind::CALL_REQUIRED:
     case ast::Kind::CALL_REQUIRED_STATIC:
@@ -68,7 +67,7 @@ bool ResolveRequirements::visitCallRequired(const ast::Oper* ast) {
 
   std::vector<Parameter*> params;
 
-  auto reqFunc = new Function(ast->location(), funcName, _subject.get());
+  auto reqFunc = new (_arena) Function(ast->location(), funcName, _subject.get());
   if (ast->kind() == ast::Kind::CALL_REQUIRED_STATIC) {
     reqFunc->setStatic(true);
   }
@@ -122,7 +121,7 @@ bool ResolveRequirements::visitCallRequired(const ast::Oper* ast) {
         scope::StandardScope* s;
         auto it = pg->interceptScopes().find(m);
         if (it == pg->interceptScopes().end()) {
-          s = new scope::StandardScope(scope::SymbolScope::INTERCEPT, pg);
+          s = new (_arena) scope::StandardScope(scope::SymbolScope::INTERCEPT, pg);
           pg->interceptScopes()[m] = s;
         } else {
           s = it->second;
@@ -183,18 +182,18 @@ void ResolveRequirements::relationalOp(
     const StringRef& name,
     const ast::Node* left,
     const ast::Node* right) {
-  Function* reqFunc = new Function(loc, name, _subject.get());
+  Function* reqFunc = new (_arena) Function(loc, name, _subject.get());
   reqFunc->setRequirement(true);
   reqFunc->setStatic(true);
 
   auto leftType = resolveType(left);
   auto rightType = resolveType(right);
 
-  auto p = new Parameter(loc, "left", reqFunc);
+  auto p = new (_arena) Parameter(loc, "left", reqFunc);
   p->setType(leftType);
   reqFunc->params().push_back(p);
 
-  p = new Parameter(loc, "right", reqFunc);
+  p = new (_arena) Parameter(loc, "right", reqFunc);
   p->setType(rightType);
   reqFunc->params().push_back(p);
 
@@ -205,7 +204,7 @@ void ResolveRequirements::relationalOp(
 void ResolveRequirements::addTargetRequirement(RequiredFunction* req) {
   if (auto pg = dyn_cast<PossiblyGenericDefn*>(_subject.get())) {
     pg->requiredFunctions().push_back(req);
-    pg->requiredMethodScope()->addMember(req->method());
+    pg->requiredMethodScope(_arena)->addMember(req->method());
   } else {
     assert(false);
   }
@@ -284,7 +283,7 @@ bool ResolveRequirements::getFunctionParams(
     std::stringstream paramName;
     paramName << "_" << result.size();
     auto paramType = resolveType(param);
-    auto p = new Parameter(param->location(), paramName.str(), definedIn);
+    auto p = new (_arena) Parameter(param->location(), paramName.str(), definedIn);
     p->setType(paramType);
     result.push_back(p);
   }
@@ -298,7 +297,7 @@ void ResolveRequirements::getFunctionParams(
   for (auto paramType : ft->paramTypes()) {
     std::stringstream paramName;
     paramName << "_" << result.size();
-    auto p = new Parameter(definedIn->location(), paramName.str(), definedIn);
+    auto p = new (_arena) Parameter(definedIn->location(), paramName.str(), definedIn);
     p->setType(paramType);
     result.push_back(p);
   }
@@ -46,7 +46,7 @@ void BuildGraphPass::createMembers(
     memberScope->addMember(d);
 
     if (node->kind() == ast::Kind::OBJECT_DEFN) {
-      semgraph::ValueDefn* singleton = new semgraph::ValueDefn(
+      semgraph::ValueDefn* singleton = new (arena()) semgraph::ValueDefn(
           semgraph::Member::Kind::LET, ast->location(), ast->name(), parent);
       singleton->setType(static_cast<semgraph::TypeDefn*>(d)->type());
       singleton->setVisibility(astVisibility(ast));
@@ -90,14 +90,14 @@ semgraph::Defn* BuildGraphPass::createDefn(const ast::Node * node, semgraph::Mem
       const ast::ValueDefn* ast = static_cast<const ast::ValueDefn*>(node);
       semgraph::Member::Kind kind = node->kind() == ast::Kind::LET ?
           semgraph::Member::Kind::LET : semgraph::Member::Kind::VAR;
-      semgraph::ValueDefn* vd = new semgraph::ValueDefn(
+      semgraph::ValueDefn* vd = new (arena()) semgraph::ValueDefn(
           kind, ast->location(), ast->name(), parent);
       vd->setAst(ast);
       return vd;
     }
     case ast::Kind::ENUM_VALUE: {
       const ast::ValueDefn* ast = static_cast<const ast::ValueDefn*>(node);
-      semgraph::ValueDefn* vd = new semgraph::ValueDefn(
+      semgraph::ValueDefn* vd = new (arena()) semgraph::ValueDefn(
           semgraph::Member::Kind::ENUM_VAL, ast->location(), ast->name(), parent);
       vd->setAst(ast);
       return vd;
@@ -111,7 +111,7 @@ semgraph::Defn* BuildGraphPass::createDefn(const ast::Node * node, semgraph::Mem
       if (node->kind() == ast::Kind::OBJECT_DEFN) {
         typeName.append("#Class");
       }
-      semgraph::TypeDefn* td = new semgraph::TypeDefn(
+      semgraph::TypeDefn* td = new (arena()) semgraph::TypeDefn(
           semgraph::Member::Kind::TYPE, ast->location(), typeName, parent);
 
       semgraph::Type::Kind tk = semgraph::Type::Kind::CLASS;
@@ -125,13 +125,13 @@ semgraph::Defn* BuildGraphPass::createDefn(const ast::Node * node, semgraph::Mem
       cls->setDefn(td);
 
       createMembers(ast->members(), td, td->members(), td->memberScope());
-      createTypeParamList(ast->typeParams(), td, td->typeParams(), td->typeParamScope());
+      createTypeParamList(ast->typeParams(), td, td->typeParams(), td);
 //       decl.setRequiredMethodScope(StandardScope(decl, 'constraint'))
       return td;
     }
     case ast::Kind::ENUM_DEFN: {
       const ast::TypeDefn* ast = static_cast<const ast::TypeDefn*>(node);
-      semgraph::TypeDefn* td = new semgraph::TypeDefn(
+      semgraph::TypeDefn* td = new (arena()) semgraph::TypeDefn(
           semgraph::Member::Kind::TYPE, ast->location(), ast->name(), parent);
 
       semgraph::Composite* cls = new (arena()) semgraph::Composite(semgraph::Type::Kind::ENUM);
@@ -143,24 +143,30 @@ semgraph::Defn* BuildGraphPass::createDefn(const ast::Node * node, semgraph::Mem
     }
     case ast::Kind::FUNCTION: {
       const ast::Function* ast = static_cast<const ast::Function*>(node);
-      semgraph::Function* f = new semgraph::Function(ast->location(), ast->name(), parent);
-      createParamList(ast->params(), f, f->params(), f->paramScope());
-      createTypeParamList(ast->typeParams(), f, f->typeParams(), f->typeParamScope());
+      semgraph::Function* f = new (arena()) semgraph::Function(
+          ast->location(), ast->name(), parent);
+      if (!ast->params().empty()) {
+        createParamList(ast->params(), f, f->params(), f->paramScope(arena()));
+      }
+      createTypeParamList(ast->typeParams(), f, f->typeParams(), f);
       return f;
     }
     case ast::Kind::PROPERTY: {
       const ast::Property* ast = static_cast<const ast::Property*>(node);
-      semgraph::Property* prop = new semgraph::Property(ast->location(), ast->name(), parent);
-      createParamList(ast->params(), prop, prop->params(), prop->paramScope());
-      createTypeParamList(ast->typeParams(), prop, prop->typeParams(), prop->typeParamScope());
+      semgraph::Property* prop = new (arena()) semgraph::Property(
+          ast->location(), ast->name(), parent);
+      if (!ast->params().empty()) {
+        createParamList(ast->params(), prop, prop->params(), prop->paramScope(arena()));
+      }
+      createTypeParamList(ast->typeParams(), prop, prop->typeParams(), prop);
       if (ast->getter() != nullptr) {
-        semgraph::Function* getter = new semgraph::Function(
+        semgraph::Function* getter = new (arena()) semgraph::Function(
             ast->getter()->location(), ast->getter()->name(), prop);
         getter->setAst(ast->getter());
         prop->setGetter(getter);
       }
       if (ast->setter() != nullptr) {
-        semgraph::Function* setter = new semgraph::Function(
+        semgraph::Function* setter = new (arena()) semgraph::Function(
             ast->setter()->location(), ast->setter()->name(), prop);
         setter->setAst(ast->setter());
         prop->setSetter(setter);
@@ -183,7 +189,8 @@ void BuildGraphPass::createParamList(
   for (const ast::Node* node : paramAsts) {
     assert(node->kind() == ast::Kind::PARAMETER);
     const ast::Parameter* ast = static_cast<const ast::Parameter*>(node);
-    semgraph::Parameter* param = new semgraph::Parameter(ast->location(), ast->name(), parent);
+    semgraph::Parameter* param = new (arena()) semgraph::Parameter(
+        ast->location(), ast->name(), parent);
     param->setAst(ast);
     param->setKeywordOnly(ast->isKeywordOnly());
     param->setVariadic(ast->isVariadic());
@@ -200,13 +207,17 @@ void BuildGraphPass::createTypeParamList(
     const ast::NodeList& paramAsts,
     semgraph::Member* parent,
     std::vector<semgraph::TypeParameter*>& paramList,
-    scope::StandardScope* paramScope) {
+    semgraph::PossiblyGenericDefn* generic) {
 
+  if (paramAsts.empty()) {
+    return;
+  }
+  scope::StandardScope* paramScope = generic->typeParamScope(arena());
   paramList.reserve(paramAsts.size());
   for (const ast::Node* node : paramAsts) {
     assert(node->kind() == ast::Kind::TYPE_PARAMETER);
     const ast::TypeParameter* ast = static_cast<const ast::TypeParameter*>(node);
-    semgraph::TypeParameter* param = new semgraph::TypeParameter(
+    semgraph::TypeParameter* param = new (arena()) semgraph::TypeParameter(
         ast->location(), ast->name(), parent);
     param->setAst(ast);
     param->setVariadic(ast->isVariadic());
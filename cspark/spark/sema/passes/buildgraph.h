@@ -50,7 +50,7 @@ private:
       const ast::NodeList& paramAsts,
       semgraph::Member* parent,
       std::vector<semgraph::TypeParameter*>& paramList,
-      scope::StandardScope* paramScope);
+      semgraph::PossiblyGenericDefn* generic);
 
   support::Arena& arena();
   semgraph::Visibility astVisibility(const ast::Defn* d);
@@ -3,7 +3,10 @@
 #include "spark/ast/ident.h"
 #include "spark/ast/module.h"
 #include "spark/ast/oper.h"
+#include "spark/ast/structhash.h"
+#include "spark/collections/hashing.h"
 #include "spark/error/formatters.h"
+#include "spark/parse/parser.h"
 #include "spark/scope/modulepathscope.h"
 #include "spark/scope/scopestack.h"
 #include "spark/scope/specializedscope.h"
@@ -36,6 +39,9 @@ NameResolutionPass::NameResolutionPass(compiler::Context* context)
   , _globalScopes(new scope::ScopeStack())
   , _scopeStack(new scope::ScopeStack())
   , _selfType(nullptr)
+  , _typeMemo(nullptr)
+  , _typeMemoVersion(0)
+  , _currentStats(nullptr)
 {
 }
 
@@ -73,7 +79,7 @@ void NameResolutionPass::resolveImports(Module* mod) {
       reporter().error(imp->path()->location()) << "Imported name not found.";
       continue;
     }
-    StringRef name = members.front()->name();
+    Atom name = members.front()->name();
     if (!imp->alias().empty()) {
       name = imp->alias();
     }
@@ -189,9 +195,14 @@ void NameResolutionPass::visitFunction(Function* f) {
 
   processAttributes(f);
   processParamList(f, f->params());
-  if (fAst->body() != nullptr && fAst->body()->kind() != ast::Kind::ABSENT) {
+  const ast::Node* body = fAst->body();
+  if (body != nullptr && body->kind() == ast::Kind::DEFERRED_BODY) {
+    body = parse::Parser::parseDeferredBody(
+        reporter(), static_cast<const ast::DeferredBody*>(body));
+  }
+  if (body != nullptr && body->kind() != ast::Kind::ABSENT) {
     _scopeStack->push(f->paramScope());
-    f->setBody(resolveExpr(fAst->body()));
+    f->setBody(resolveExpr(body));
     _scopeStack->pop();
   }
 
@@ -250,7 +261,7 @@ void NameResolutionPass::visitProperty(Property* p) {
       auto valueParam = new (*_arena) Parameter(p->setter()->location(), "value", p);
       valueParam->setType(p->type());
       params.insert(params.begin(), valueParam);
-      p->setter()->paramScope()->addMember(valueParam);
+      p->setter()->paramScope(*_arena)->addMember(valueParam);
     }
     p->setter()->setType(
         _context->typeStore()->createFunctionType(&VoidType::VOID, p->setter()->params()));
@@ -585,14 +596,125 @@ Expr* NameResolutionPass::resolveExpr(const ast::Node* ast) {
 }
 
 Type* NameResolutionPass::resolveType(const ast::Node* ast) {
+  // Type expressions that were already resolved in the same context give the same type, so
+  // look for one before walking the scope stack. Expressions that aren't purely made of
+  // names and type operators are never memoized.
+  TypeExprKey key = { 0, ast };
+  TypeMemo* memo = nullptr;
+  if (ast::structuralHash(ast, key.hash)) {
+    memo = &currentTypeMemo();
+    auto it = memo->find(key);
+    if (it != memo->end()) {
+      ++_currentStats->hits;
+      return it->second;
+    }
+    ++_currentStats->misses;
+  }
+
+  // Whatever a failed resolution allocated is garbage, so give it back. That is only safe if
+  // nothing outside the arena still points into it afterwards. ResolveExprs and ResolveTypes
+  // link what they allocate only to each other, and never call back into this pass, so the
+  // scope stack and subject are left as they were (asserted below). They can intern types in
+  // the type store, whose keys may point into the arena, so keep everything if it grew. Also
+  // keep everything if a memo context or entry was added in the meantime: a context keyed by
+  // a freed stem could otherwise be matched by whatever is allocated at the same address next.
+  int errorCount = _context->reporter().errorCount();
+  support::ArenaCheckpoint checkpoint(*_arena);
+  size_t typeStoreBytes = _context->typeStore()->arena().bytesAllocated();
+  size_t typeMemoVersion = _typeMemoVersion;
+  size_t scopeDepth = _scopeStack->size();
+  Defn* subject = _subject.get();
+  (void) scopeDepth;
+  (void) subject;
   names::ResolveExprs re(
       _context->reporter(), _subject, _scopeStack.get(), _context->typeStore(), *_arena);
   Expr* expr = re.exec(ast);
-  if (Expr::isError(expr)) {
-    return &Type::ERROR;
-  }
   names::ResolveTypes rt(_context->reporter(), _context->typeStore(), *_arena);
-  return rt.exec(expr);
+  Type* result = Expr::isError(expr) ? &Type::ERROR : rt.exec(expr);
+  assert(_scopeStack->size() == scopeDepth);
+  assert(_subject.get() == subject);
+  if (!Type::isError(result) ||
+      _context->typeStore()->arena().bytesAllocated() != typeStoreBytes ||
+      _typeMemoVersion != typeMemoVersion) {
+    checkpoint.keep();
+  }
+
+  // Only remember successful results, so that errors are reported at every occurrence. The
+  // memo is still the one for this context, even if resolving class bases out of band
+  // switched to another context in the meantime.
+  if (memo != nullptr && !Type::isError(result) &&
+      _context->reporter().errorCount() == errorCount) {
+    (*memo)[key] = result;
+    ++_typeMemoVersion;
+  }
+  return result;
+}
+
+NameResolutionPass::TypeMemo& NameResolutionPass::currentTypeMemo() {
+  // Empty scopes can't affect the outcome of a lookup, and neither can which function or
+  // property the subject is, since anything they define lives in their own scopes.
+  Member* owner = _subject.get();
+  while (owner != nullptr &&
+      (owner->kind() == Member::Kind::FUNCTION || owner->kind() == Member::Kind::PROPERTY)) {
+    owner = owner->definedIn();
+  }
+  const std::vector<scope::ScopeStack::Entry>& entries = _scopeStack->entries();
+  bool changed = _typeMemo == nullptr || owner != _typeContext.owner;
+  size_t n = 0;
+  for (const scope::ScopeStack::Entry& entry : entries) {
+    if (entry.scope->empty()) {
+      continue;
+    }
+    if (n >= _typeContext.scopes.size() || !(_typeContext.scopes[n] == entry)) {
+      changed = true;
+      break;
+    }
+    ++n;
+  }
+  if (!changed && n == _typeContext.scopes.size()) {
+    return *_typeMemo;
+  }
+
+  _typeContext.owner = owner;
+  _typeContext.scopes.clear();
+  for (const scope::ScopeStack::Entry& entry : entries) {
+    if (!entry.scope->empty()) {
+      _typeContext.scopes.push_back(entry);
+    }
+  }
+  auto inserted = _typeMemos.emplace(_typeContext, TypeMemo());
+  if (inserted.second) {
+    ++_typeMemoVersion;
+  }
+  _typeMemo = &inserted.first->second;
+
+  // Count against the module that the subject is defined in, which needn't be the one this
+  // pass is running on if class bases are being resolved out of band.
+  Member* mod = owner;
+  while (mod != nullptr && mod->kind() != Member::Kind::MODULE) {
+    mod = mod->definedIn();
+  }
+  _currentStats = &_typeMemoStats[static_cast<Module*>(mod)];
+  return *_typeMemo;
+}
+
+TypeMemoStats NameResolutionPass::typeMemoStats(const Module* mod) const {
+  auto it = _typeMemoStats.find(mod);
+  return it != _typeMemoStats.end() ? it->second : TypeMemoStats();
+}
+
+std::size_t NameResolutionPass::TypeContextHash::operator()(const TypeContext& context) const {
+  std::size_t result = std::hash<Member*>()(context.owner);
+  for (const scope::ScopeStack::Entry& entry : context.scopes) {
+    std::hash_combine(result, std::hash<scope::SymbolScope*>()(entry.scope));
+    std::hash_combine(result, std::hash<Expr*>()(entry.stem));
+  }
+  return result;
+}
+
+bool NameResolutionPass::TypeExprEqual::operator()(
+    const TypeExprKey& a, const TypeExprKey& b) const {
+  return a.hash == b.hash && ast::structurallyEqual(a.ast, b.ast);
 }
 
 void NameResolutionPass::pushAncestorScopes(Member* m) {
@@ -665,13 +787,13 @@ Package* NameResolutionPass::findPackage(const StringRef& qname) {
       end = qname.size();
     }
     if (pos == 0) {
-      _context->modulePathScope()->lookupName(qname.substr(pos, end), members);
+      _context->modulePathScope()->lookupName(Atom::intern(qname.substr(pos, end)), members);
     } else {
       std::vector<Member*> nextMembers;
       for (Member* m : members) {
         assert(m->kind() == Member::Kind::PACKAGE);
         static_cast<const Package*>(m)->memberScope()->lookupName(
-            qname.substr(pos, end),
+            Atom::intern(qname.substr(pos, end)),
             nextMembers);
       }
       members.swap(nextMembers);
@@ -5,6 +5,10 @@
 #ifndef SPARK_SEMA_PASSES_NAMERESOLUTION_H
 #define SPARK_SEMA_PASSES_NAMERESOLUTION_H 1
 
+#ifndef SPARK_AST_NODE_H
+  #include "spark/ast/node.h"
+#endif
+
 #ifndef SPARK_SEMA_PASS_H
   #include "spark/sema/pass.h"
 #endif
@@ -33,20 +37,33 @@
   #include "spark/semgraph/defnvisitor.h"
 #endif
 
+#ifndef SPARK_SCOPE_SCOPESTACK_H
+  #include "spark/scope/scopestack.h"
+#endif
+
 #ifndef SPARK_SUPPORT_ARENA_H
   #include "spark/support/arena.h"
 #endif
 
+#if SPARK_HAVE_UNORDERED_MAP
+  #include <unordered_map>
+#endif
+
 namespace spark {
-namespace scope {
-class ScopeStack;
-}
 namespace sema {
 namespace names {
 class ResolveTypes;
 }
 namespace passes {
 
+/** How the type expressions in a module were resolved. */
+struct TypeMemoStats {
+  std::size_t hits;     /** Found already resolved in the type memo. */
+  std::size_t misses;   /** Not in the memo, so resolved from the scope stack. */
+
+  TypeMemoStats() : hits(0), misses(0) {}
+};
+
 /** Pass that resolves all symbol names. */
 class NameResolutionPass : public Pass, semgraph::DefnVisitor<void> {
 public:
@@ -62,7 +79,43 @@ public:
   void visitFunction(semgraph::Function* f);
   void visitProperty(semgraph::Property* p);
 
+  /** How the type expressions defined in 'mod' were resolved by this pass. */
+  TypeMemoStats typeMemoStats(const semgraph::Module* mod) const;
+
 private:
+  /** The context that a type expression is resolved in: the scopes on the stack that define
+      any names, and the nearest enclosing definition of the subject that is not a function
+      or property. Type expressions that are alike resolve to the same type in equal contexts. */
+  struct TypeContext {
+    std::vector<scope::ScopeStack::Entry> scopes;
+    semgraph::Member* owner;
+
+    bool operator==(const TypeContext& other) const {
+      return owner == other.owner && scopes == other.scopes;
+    }
+  };
+
+  struct TypeContextHash {
+    std::size_t operator()(const TypeContext& context) const;
+  };
+
+  /** A type expression, along with its structural hash. */
+  struct TypeExprKey {
+    std::size_t hash;
+    const ast::Node* ast;
+  };
+
+  struct TypeExprHash {
+    inline std::size_t operator()(const TypeExprKey& key) const { return key.hash; }
+  };
+
+  struct TypeExprEqual {
+    bool operator()(const TypeExprKey& a, const TypeExprKey& b) const;
+  };
+
+  /** Types that have already been resolved in a given context. */
+  typedef std::unordered_map<TypeExprKey, semgraph::Type*, TypeExprHash, TypeExprEqual> TypeMemo;
+
   void resolveImports(semgraph::Module* mod);
   void resolveClassBases(semgraph::Composite* cls);
   void resolveClassBasesOutOfBand(semgraph::Composite* cls);
@@ -78,6 +131,7 @@ private:
     std::vector<semgraph::RequiredFunction*>& requiredFunctions);
   semgraph::Expr* resolveExpr(const ast::Node* ast);
   semgraph::Type* resolveType(const ast::Node* ast);
+  TypeMemo& currentTypeMemo();
   void findAbsoluteSymbol(const ast::Node* node, std::vector<semgraph::Member*> &result);
   semgraph::Package* findPackage(const collections::StringRef& qname);
   void pushAncestorScopes(semgraph::Member* m);
@@ -88,6 +142,12 @@ private:
   std::auto_ptr<scope::ScopeStack> _globalScopes;
   std::auto_ptr<scope::ScopeStack> _scopeStack;
   semgraph::Type* _selfType;
+  std::unordered_map<TypeContext, TypeMemo, TypeContextHash> _typeMemos;
+  TypeContext _typeContext;
+  TypeMemo* _typeMemo;
+  std::size_t _typeMemoVersion; // Changes whenever a memo context or entry is added
+  std::unordered_map<const semgraph::Module*, TypeMemoStats> _typeMemoStats;
+  TypeMemoStats* _currentStats;
 
   support::Arena& arena();
 };
@@ -9,6 +9,7 @@
 namespace spark {
 namespace sema {
 namespace types {
+using collections::Atom;
 using collections::StringRef;
 using semgraph::Composite;
 using semgraph::Defn;
@@ -72,9 +73,12 @@ Member* Essentials::findAbsoluteSymbol(const StringRef& path) {
     if (end <= pos) {
       end = path.size();
     }
-    StringRef part = path.substr(pos, end);
+    // A name that was never interned can't be defined anywhere.
+    Atom part = Atom::find(path.substr(pos, end));
     std::vector<Member*> members;
-    scope->lookupName(part, members);
+    if (!part.isNull()) {
+      scope->lookupName(part, members);
+    }
     if (members.empty()) {
       _context->reporter().error() << "Essential name '" << path << "' not found.";
       return nullptr;
@@ -125,7 +125,7 @@ struct TypeOrdering {
         auto d0 = c0->defn();
         auto d1 = c1->defn();
         // See if names are different
-        int c = d0->name().compare(d1->name());
+        int c = d0->name().str().compare(d1->name());
         if (c != 0) {
           return c;
         }
@@ -281,7 +281,7 @@ struct TypeOrdering {
     if (m0 == m1) {
       return 0;
     }
-    int c = m0->name().compare(m1->name());
+    int c = m0->name().str().compare(m1->name());
     if (c != 0) {
       return c;
     }
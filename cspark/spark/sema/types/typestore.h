@@ -40,6 +40,7 @@ using semgraph::TypeKey;
 
 class TypeStore {
 public:
+  TypeStore() : _arena("types") {}
 //   TypeStore(support::Arena& arena) : _arena(arena) {}
 
   /** TypeStore has its own arena. */
@@ -31,21 +31,6 @@ void Defn::formatModifiers(std::ostream& out) const {
   }
 }
 
-PossiblyGenericDefn::~PossiblyGenericDefn() {
-  for (auto tparam : _typeParams) {
-    delete tparam;
-  }
-  for (auto iscope : _interceptScopes) {
-    delete iscope.second;
-  }
-}
-
-TypeDefn::~TypeDefn() {
-  for (Member* member : _members) {
-    delete member;
-  }
-}
-
 void TypeDefn::format(std::ostream& out) const {
   formatModifiers(out);
   switch (type()->kind()) {
@@ -80,29 +65,11 @@ void Parameter::format(std::ostream& out) const {
   out << "param " << name();
 }
 
-Function::~Function() {
-  for (Parameter* param : _params) {
-    delete param;
-  }
-}
-
 void Function::format(std::ostream& out) const {
   formatModifiers(out);
   out << "fn " << name();
 }
 
-Property::~Property() {
-  for (Parameter* param : _params) {
-    delete param;
-  }
-  if (_getter != nullptr) {
-    delete _getter;
-  }
-  if (_setter != nullptr) {
-    delete _setter;
-  }
-}
-
 void Property::format(std::ostream& out) const {
   formatModifiers(out);
   out << "fn " << name();
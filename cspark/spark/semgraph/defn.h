@@ -9,8 +9,8 @@
   #include "spark/config.h"
 #endif
 
-#ifndef SPARK_COLLECTIONS_STRINGREF_H
-  #include "spark/collections/stringref.h"
+#ifndef SPARK_COLLECTIONS_ATOM_H
+  #include "spark/collections/atom.h"
 #endif
 
 #ifndef SPARK_COLLECTIONS_ARRAYREF_H
@@ -33,6 +33,10 @@
   #include "spark/semgraph/env.h"
 #endif
 
+#ifndef SPARK_SUPPORT_ARENA_H
+  #include "spark/support/arena.h"
+#endif
+
 #if SPARK_HAVE_MEMORY
   #include <memory>
 #endif
@@ -45,6 +49,7 @@ class Node;
 }
 namespace semgraph {
 using collections::ArrayRef;
+using collections::Atom;
 using collections::StringRef;
 
 class Defn;
@@ -88,7 +93,7 @@ public:
 
   Member(Kind kind, const StringRef& name, Member* definedIn = nullptr)
     : _kind(kind)
-    , _name(name.begin(), name.end())
+    , _name(Atom::intern(name))
     , _definedIn(definedIn)
     , _ast(nullptr)
   {}
@@ -103,10 +108,11 @@ public:
   void setAst(const ast::Node* ast) { _ast = ast; }
 
   /** The name of this member. */
-  StringRef name() const { return _name; }
+  Atom name() const { return _name; }
 
   /** Return the definition enclosing this one. */
   Member* definedIn() const { return _definedIn; }
+  void setDefinedIn(Member* definedIn) { _definedIn = definedIn; }
 
   /** Downcast to a definition. */
   virtual Defn* asDefn() { return nullptr; }
@@ -134,7 +140,7 @@ public:
 
 protected:
   const Kind _kind;
-  const std::string _name;
+  const Atom _name;
   Member* _definedIn;
   const ast::Node* _ast;
 };
@@ -143,9 +149,17 @@ protected:
 typedef std::vector<Member*> MemberList;
 typedef ArrayRef<Member*> MemberArray;
 
-/** A definition, that is, any type or object that has a name. */
+/** A definition, that is, any type or object that has a name. Definitions are allocated in
+    the semantic graph arena of the module that contains them, and are never deleted; nor are
+    the scopes that they create lazily in the same arena. Their destructors don't run, so the
+    heap storage of their vectors, maps and scope tables is not freed either. That is accepted
+    because modules, and so their semantic graphs, are kept until the compiler exits. */
 class Defn : public Member {
 public:
+  void* operator new(size_t size, support::Arena& arena) {
+    return arena.allocate(size);
+  }
+
   Defn(Kind kind, const source::Location& location, const StringRef& name, Member* definedIn = nullptr)
     : Member(kind, name, definedIn)
     , _location(location)
@@ -222,26 +236,42 @@ public:
   PossiblyGenericDefn(
       Kind kind, const source::Location& location, const StringRef& name, Member* definedIn)
     : Defn(kind, location, name, definedIn)
-    , _typeParamScope(new scope::StandardScope(scope::SymbolScope::DEFAULT, this))
-    , _requiredMethodScope(new scope::StandardScope(scope::SymbolScope::DEFAULT, this))
+    , _typeParamScope(nullptr)
+    , _requiredMethodScope(nullptr)
   {
   }
 
-  ~PossiblyGenericDefn();
-
   /** List of template parameters. */
   std::vector<TypeParameter*>& typeParams() { return _typeParams; }
   const std::vector<TypeParameter*>& typeParams() const { return _typeParams; }
 
-  /** Scope containing all of the type parameters of this type. */
-  scope::StandardScope* typeParamScope() const { return _typeParamScope.get(); }
+  /** Scope containing all of the type parameters of this type. Null if there are none. */
+  scope::StandardScope* typeParamScope() const { return _typeParamScope; }
+
+  /** Scope containing all of the type parameters of this type, which is created in 'arena'
+      if it doesn't exist yet. */
+  scope::StandardScope* typeParamScope(support::Arena& arena) {
+    if (_typeParamScope == nullptr) {
+      _typeParamScope = new (arena) scope::StandardScope(scope::SymbolScope::DEFAULT, this);
+    }
+    return _typeParamScope;
+  }
 
   /** List of required functions. */
   std::vector<RequiredFunction*>& requiredFunctions() { return _requiredFunctions; }
   const std::vector<RequiredFunction*>& requiredFunctions() const { return _requiredFunctions; }
 
-  /** Scope containing all of the type parameters of this type. */
-  scope::StandardScope* requiredMethodScope() const { return _requiredMethodScope.get(); }
+  /** Scope containing all of the required functions of this type. Null if there are none. */
+  scope::StandardScope* requiredMethodScope() const { return _requiredMethodScope; }
+
+  /** Scope containing all of the required functions of this type, which is created in
+      'arena' if it doesn't exist yet. */
+  scope::StandardScope* requiredMethodScope(support::Arena& arena) {
+    if (_requiredMethodScope == nullptr) {
+      _requiredMethodScope = new (arena) scope::StandardScope(scope::SymbolScope::DEFAULT, this);
+    }
+    return _requiredMethodScope;
+  }
 
   /** Scopes searched when resolving a reference to a qualified name that is mentioned in a
       'where' clause. So for example, if a template has a constraint such as
@@ -263,8 +293,8 @@ public:
 private:
   std::vector<TypeParameter*> _typeParams;
   std::vector<RequiredFunction*> _requiredFunctions;
-  std::auto_ptr<scope::StandardScope> _typeParamScope;
-  std::auto_ptr<scope::StandardScope> _requiredMethodScope;
+  scope::StandardScope* _typeParamScope;
+  scope::StandardScope* _requiredMethodScope;
   std::unordered_map<Member*, scope::StandardScope*> _interceptScopes;
 };
 
@@ -273,13 +303,11 @@ class TypeDefn : public PossiblyGenericDefn {
 public:
   TypeDefn(Kind kind, const source::Location& location, const StringRef& name, Member* definedIn)
     : PossiblyGenericDefn(kind, location, name, definedIn)
-    , _memberScope(new scope::StandardScope(scope::SymbolScope::INSTANCE, this))
-    , _inheritedMemberScope(new scope::InheritedScope(_memberScope.get(), this))
+    , _memberScope(scope::SymbolScope::INSTANCE, this)
+    , _inheritedMemberScope(&_memberScope, this)
   {
   }
 
-  ~TypeDefn();
-
   /** The type defined by this type definition. */
   Type* type() const { return _type; }
   void setType(Type* type) { _type = type; }
@@ -289,11 +317,13 @@ public:
   const std::vector<Member*>& members() const { return _members; }
 
   /** Scope containing all of the members of this type. */
-  scope::StandardScope* memberScope() const { return _memberScope.get(); }
+  scope::StandardScope* memberScope() { return &_memberScope; }
+  const scope::StandardScope* memberScope() const { return &_memberScope; }
 
   /** Scope containing all of the members of this type, including inherited members (but
       only non-shadowed inherited members. */
-  scope::InheritedScope* inheritedMemberScope() const { return _inheritedMemberScope.get(); }
+  scope::InheritedScope* inheritedMemberScope() { return &_inheritedMemberScope; }
+  const scope::InheritedScope* inheritedMemberScope() const { return &_inheritedMemberScope; }
 
   void format(std::ostream& out) const;
 
@@ -304,8 +334,8 @@ public:
 private:
   Type* _type;
   std::vector<Member*> _members;
-  std::auto_ptr<scope::StandardScope> _memberScope;
-  std::auto_ptr<scope::InheritedScope> _inheritedMemberScope;
+  scope::StandardScope _memberScope;
+  scope::InheritedScope _inheritedMemberScope;
 
 //   # List of friend declarations for thibs class
 //   friends: list[Member] = 3;
@@ -491,7 +521,7 @@ public:
   Function(const source::Location& location, const StringRef& name, Member* definedIn = nullptr)
     : PossiblyGenericDefn(Kind::FUNCTION, location, name, definedIn)
     , _type(nullptr)
-    , _paramScope(new scope::StandardScope(scope::SymbolScope::DEFAULT, this))
+    , _paramScope(nullptr)
     , _selfType(nullptr)
     , _body(nullptr)
     , _constructor(false)
@@ -501,8 +531,6 @@ public:
     , _tempVarCount(0)
   {}
 
-  ~Function();
-
   /** Type of this function. */
   FunctionType* type() const { return _type; }
   void setType(FunctionType* type) { _type = type; }
@@ -511,8 +539,17 @@ public:
   std::vector<Parameter*>& params() { return _params; }
   const std::vector<Parameter*>& params() const { return _params; }
 
-  /** Scope containing all of the parameters of this function. */
-  scope::StandardScope* paramScope() const { return _paramScope.get(); }
+  /** Scope containing all of the parameters of this function. Null if there are none. */
+  scope::StandardScope* paramScope() const { return _paramScope; }
+
+  /** Scope containing all of the parameters of this function, which is created in 'arena' if
+      it doesn't exist yet. */
+  scope::StandardScope* paramScope(support::Arena& arena) {
+    if (_paramScope == nullptr) {
+      _paramScope = new (arena) scope::StandardScope(scope::SymbolScope::DEFAULT, this);
+    }
+    return _paramScope;
+  }
 
   /** The function body. nullptr if no body has been declared. */
   Type* selfType() const { return _selfType; }
@@ -557,7 +594,7 @@ public:
 private:
   FunctionType* _type;
   std::vector<Parameter*> _params;
-  std::auto_ptr<scope::StandardScope> _paramScope;
+  scope::StandardScope* _paramScope;
   std::vector<Defn*> _localDefns;
   Type* _selfType;
   Expr* _body;
@@ -576,14 +613,12 @@ public:
   Property(const source::Location& location, const StringRef& name, Member* definedIn = nullptr)
     : PossiblyGenericDefn(Kind::PROPERTY, location, name, definedIn)
     , _type(nullptr)
-    , _paramScope(new scope::StandardScope(scope::SymbolScope::DEFAULT, this))
+    , _paramScope(nullptr)
     , _selfType(nullptr)
     , _getter(nullptr)
     , _setter(nullptr)
   {}
 
-  ~Property();
-
   /** The type of the property value. */
   Type* type() const { return _type; }
   void setType(Type* type) { _type = type; }
@@ -592,8 +627,17 @@ public:
   std::vector<Parameter*>& params() { return _params; }
   const std::vector<Parameter*>& params() const { return _params; }
 
-  /** Scope containing all of the parameters of this function. */
-  scope::StandardScope* paramScope() const { return _paramScope.get(); }
+  /** Scope containing all of the parameters of this function. Null if there are none. */
+  scope::StandardScope* paramScope() const { return _paramScope; }
+
+  /** Scope containing all of the parameters of this function, which is created in 'arena' if
+      it doesn't exist yet. */
+  scope::StandardScope* paramScope(support::Arena& arena) {
+    if (_paramScope == nullptr) {
+      _paramScope = new (arena) scope::StandardScope(scope::SymbolScope::DEFAULT, this);
+    }
+    return _paramScope;
+  }
 
   /** The function body. nullptr if no body has been declared. */
   Type* selfType() const { return _selfType; }
@@ -616,7 +660,7 @@ public:
 private:
   Type* _type;
   std::vector<Parameter*> _params;
-  std::auto_ptr<scope::StandardScope> _paramScope;
+  scope::StandardScope* _paramScope;
   Type* _selfType;
   Function* _getter;
   Function* _setter;
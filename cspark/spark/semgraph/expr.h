@@ -795,8 +795,6 @@ public:
     : support::ArrayBuilder<Expr*>(arena, init) {}
   ExprArrayBuilder(support::Arena& arena, const std::vector<Expr*>& init)
     : support::ArrayBuilder<Expr*>(arena, init) {}
-  ExprArrayBuilder(support::Arena& arena, const std::vector<Expr*>&& init)
-    : support::ArrayBuilder<Expr*>(arena, init) {}
 
   /** Return a location which spans all of the expressions. */
   Location location() const {
@@ -29,6 +29,8 @@ public:
     , _memberScope(new scope::StandardScope(scope::SymbolScope::DEFAULT))
     , _importScope(new scope::StandardScope(scope::SymbolScope::DEFAULT))
     , _tempVarCount(0)
+    , _astArena("ast")
+    , _sgArena("semgraph")
   {}
 
   /** Source file of this module. */
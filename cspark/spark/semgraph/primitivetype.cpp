@@ -45,7 +45,7 @@ void IntegerType::createConstant(support::Arena& arena, const StringRef& name, i
   constVal->setType(this);
 //  graphtools.encodeInt(constVal, value)
 
-  auto v = new ValueDefn(Defn::Kind::LET, Location(), name, defn());
+  auto v = new (arena) ValueDefn(Defn::Kind::LET, Location(), name, defn());
   v->setStatic(true);
   v->setType(this);
   v->setInit(constVal);
@@ -13,82 +13,38 @@
   #include <algorithm>
 #endif
 
+#if SPARK_HAVE_STDINT_H
+  #include <stdint.h>
+#endif
+
 namespace spark {
 namespace source {
 
 class ProgramSource;
 
+/** A range of source text, as a pair of offsets into the global offset space maintained by
+    the SourceManager. 'end' is the offset one past the last character in the range. Line and
+    column numbers are not stored; they are decoded by the SourceManager when needed. An offset
+    of zero means that there is no location. */
 struct Location {
-  ProgramSource* source;
-  int32_t startLine;
-  int16_t startCol;
-  int32_t endLine;
-  int16_t endCol;
-
-  Location()
-    : source(NULL)
-    , startLine(0)
-    , startCol(0)
-    , endLine(0)
-    , endCol(0)
-  {
-  }
+  uint32_t begin;
+  uint32_t end;
 
-  Location(
-    ProgramSource* src,
-    int32_t startLn,
-    int16_t startCl,
-    int32_t endLn,
-    int16_t endCl)
-    : source(src)
-    , startLine(startLn)
-    , startCol(startCl)
-    , endLine(endLn)
-    , endCol(endCl)
-  {
-  }
+  Location() : begin(0), end(0) {}
+  Location(uint32_t b, uint32_t e) : begin(b), end(e) {}
 
-  Location(const Location& src)
-    : source(src.source)
-    , startLine(src.startLine)
-    , startCol(src.startCol)
-    , endLine(src.endLine)
-    , endCol(src.endCol)
-  {
-  }
+  /** True if this location refers to some source text. */
+  bool isValid() const { return begin != 0; }
 
+  /** Return the smallest range which encloses both locations. Both locations are expected to
+      be in the same file; an empty location is ignored. */
   inline friend Location operator|(const Location& left, const Location& right) {
-    if (left.source != right.source) {
-      if (left.source == NULL) {
-        return right;
-      } else {
-        return left;
-      }
-    } else {
-      Location result;
-      result.source = left.source;
-      if (left.startLine < right.startLine) {
-        result.startLine = left.startLine;
-        result.startCol = left.startCol;
-      } else if (left.startLine > right.startLine) {
-        result.startLine = right.startLine;
-        result.startCol = right.startCol;
-      } else {
-        result.startLine = left.startLine;
-        result.startCol = std::min(left.startCol, right.startCol);
-      }
-      if (left.endLine > right.endLine) {
-        result.endLine = left.endLine;
-        result.endCol = left.endCol;
-      } else if (left.endLine < right.endLine) {
-        result.endLine = right.endLine;
-        result.endCol = right.endCol;
-      } else {
-        result.endLine = left.endLine;
-        result.endCol = std::max(left.endCol, right.endCol);
-      }
-      return result;
+    if (left.begin == 0) {
+      return right;
+    } else if (right.begin == 0) {
+      return left;
     }
+    return Location(std::min(left.begin, right.begin), std::max(left.end, right.end));
   }
 
   Location& operator|=(const Location& right) {
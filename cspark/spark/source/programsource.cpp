@@ -0,0 +1,184 @@
+// ============================================================================
+// programsource.cpp: Loading of source files.
+// ============================================================================
+
+#include "spark/source/programsource.h"
+#include "spark/source/sourcemanager.h"
+
+#if SPARK_HAVE_ALGORITHM
+  #include <algorithm>
+#endif
+
+#if SPARK_HAVE_CSTRING
+  #include <cstring>
+#endif
+
+#if SPARK_HAVE_FCNTL_H
+  #include <fcntl.h>
+#endif
+
+#if SPARK_HAVE_SYS_MMAN_H
+  #include <sys/mman.h>
+#endif
+
+#if SPARK_HAVE_SYS_STAT_H
+  #include <sys/stat.h>
+#endif
+
+#if SPARK_HAVE_UNISTD_H
+  #include <unistd.h>
+#endif
+
+#if SPARK_HAVE_FSTREAM
+  #include <fstream>
+#endif
+
+#include <cerrno>
+
+namespace spark {
+namespace source {
+
+AbstractProgramSource::~AbstractProgramSource() {
+  if (_base != 0) {
+    SourceManager::get().remove(this);
+  }
+}
+
+uint32_t AbstractProgramSource::base() {
+  if (_base == 0) {
+    _base = SourceManager::get().add(this, content().size());
+  }
+  return _base;
+}
+
+bool AbstractProgramSource::getLine(uint32_t index, StringRef& result) {
+  if (!_linesScanned) {
+    scanLines();
+  }
+  if (index >= _lineStarts.size()) {
+    result = StringRef();
+    return false;
+  }
+  StringRef text = content();
+  uint32_t begin = _lineStarts[index];
+  uint32_t end = index + 1 < _lineStarts.size() ? _lineStarts[index + 1] : text.size();
+  if (end > begin && text[end - 1] == '\n') {
+    --end;
+  }
+  if (end > begin && text[end - 1] == '\r') {
+    --end;
+  }
+  result = StringRef(text.begin() + begin, end - begin);
+  return true;
+}
+
+uint32_t AbstractProgramSource::lineIndexOf(uint32_t offset) {
+  if (!_linesScanned) {
+    scanLines();
+  }
+  auto it = std::upper_bound(_lineStarts.begin(), _lineStarts.end(), offset);
+  return it == _lineStarts.begin() ? 0 : uint32_t(it - _lineStarts.begin() - 1);
+}
+
+void AbstractProgramSource::scanLines() {
+  StringRef text = content();
+  const char* begin = text.begin();
+  const char* end = begin + text.size();
+  const char* pos = begin;
+  _lineStarts.clear();
+  while (pos < end) {
+    _lineStarts.push_back(uint32_t(pos - begin));
+    const char* eol = static_cast<const char*>(::memchr(pos, '\n', end - pos));
+    const char* lineEnd = eol != nullptr ? eol : end;
+
+    // A carriage return that is not part of a CRLF pair also ends a line.
+    const char* cr = static_cast<const char*>(::memchr(pos, '\r', lineEnd - pos));
+    if (cr != nullptr && cr + 1 < lineEnd) {
+      pos = cr + 1;
+      continue;
+    }
+    if (eol == nullptr) {
+      break;
+    }
+    pos = eol + 1;
+  }
+  _linesScanned = true;
+}
+
+FileSource::FileSource(support::Path fullPath, StringRef path)
+  : AbstractProgramSource(path)
+  , _fullPath(fullPath)
+  , _data(nullptr)
+  , _size(0)
+  , _mapped(false)
+  , _valid(false)
+{
+  load();
+}
+
+FileSource::~FileSource() {
+#if SPARK_HAVE_SYS_MMAN_H
+  if (_mapped) {
+    ::munmap(const_cast<char*>(_data), _size);
+  }
+#endif
+}
+
+void FileSource::load() {
+#if SPARK_HAVE_FCNTL_H && SPARK_HAVE_UNISTD_H && SPARK_HAVE_SYS_STAT_H
+  int fd = ::open(_fullPath.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+
+  struct ::stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    return;
+  }
+
+  #if SPARK_HAVE_SYS_MMAN_H
+    // Regular, non-empty files are mapped directly.
+    if (S_ISREG(st.st_mode) && st.st_size > 0) {
+      void* addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr != MAP_FAILED) {
+        ::close(fd);
+        _data = static_cast<const char*>(addr);
+        _size = st.st_size;
+        _mapped = true;
+        _valid = true;
+        return;
+      }
+    }
+  #endif
+
+  // Pipes, empty files and anything else that can't be mapped are read into a buffer.
+  if (S_ISREG(st.st_mode)) {
+    _buffer.reserve(st.st_size);
+  }
+  char chunk[0x4000];
+  for (;;) {
+    ssize_t count = ::read(fd, chunk, sizeof(chunk));
+    if (count > 0) {
+      _buffer.append(chunk, count);
+    } else if (count == 0) {
+      break;
+    } else if (errno != EINTR) {
+      ::close(fd);
+      return;
+    }
+  }
+  ::close(fd);
+#else
+  std::ifstream strm(_fullPath.c_str(), std::ios::in | std::ios::binary);
+  if (!strm.good()) {
+    return;
+  }
+  _buffer.assign(std::istreambuf_iterator<char>(strm), std::istreambuf_iterator<char>());
+#endif
+  _data = _buffer.data();
+  _size = _buffer.size();
+  _valid = true;
+}
+
+}}
@@ -9,22 +9,14 @@
   #include "spark/config.h"
 #endif
 
-#if SPARK_HAVE_ISTREAM
-  #include <istream>
-#endif
-
-#if SPARK_HAVE_SSTREAM
-  #include <sstream>
-#endif
-
-#if SPARK_HAVE_FSTREAM
-  #include <fstream>
-#endif
-
 #if SPARK_HAVE_STRING
   #include <string>
 #endif
 
+#if SPARK_HAVE_VECTOR
+  #include <vector>
+#endif
+
 #ifndef SPARK_COLLECTIONS_STRINGREF_H
   #include "spark/collections/stringref.h"
 #endif
@@ -40,94 +32,90 @@ using spark::collections::StringRef;
 /** Interface for reading source code. */
 class ProgramSource {
 public:
-  /** Open the source file stream for reading. */
-  virtual std::istream& open() = 0;
-  
-  /** Close the stream. */
-  virtual void close() = 0;
+  virtual ~ProgramSource() {}
+
+  /** The complete text of the source file, as a single contiguous buffer. The buffer remains
+      valid for the lifetime of this object. */
+  virtual StringRef content() const = 0;
 
   /** The path of this file, used for error reporting. */
   virtual StringRef path() const = 0;
 
-  /** Returns true if the stream is good for reading. */
+  /** Returns true if the source text was loaded successfully. */
   virtual bool valid() const = 0;
 
-  /** Read a segment from the stream (for error reporting) */
-  virtual bool getLine(uint32_t index, std::string& result) = 0;
+  /** Return the text of the line with the given (zero-based) index, not including the line
+      terminator. The result is a slice of the source buffer. Used for error reporting. */
+  virtual bool getLine(uint32_t index, StringRef& result) = 0;
+
+  /** Return the (zero-based) index of the line containing the given byte offset. */
+  virtual uint32_t lineIndexOf(uint32_t offset) = 0;
+
+  /** The offset of the start of this file within the SourceManager's offset space. The range
+      is reserved the first time this is called. Zero means the offset space is full, and the
+      file can't be given locations. */
+  virtual uint32_t base() = 0;
 };
 
 /** Implements shared logic for ProgramSource implementations. */
 class AbstractProgramSource : public ProgramSource {
 public:
-  AbstractProgramSource(StringRef path) : _path(path.begin(), path.end()) {}
+  AbstractProgramSource(StringRef path)
+    : _path(path.begin(), path.end())
+    , _base(0)
+    , _linesScanned(false)
+  {}
+  ~AbstractProgramSource();
 
   StringRef path() const { return _path; }
 
-  bool getLine(uint32_t index, std::string& result) {
-    if (_lines.size() == 0) {
-      readLines(_lines);
-    }
-    if (index <= _lines.size()) {
-      result = _lines[index];
-      return true;
-    } else {
-      result.clear();
-      return false;
-    }
-  }
+  bool getLine(uint32_t index, StringRef& result);
+  uint32_t lineIndexOf(uint32_t offset);
+  uint32_t base();
 protected:
-  std::vector<std::string> _lines;
+  std::vector<uint32_t> _lineStarts;  /** Byte offset of the start of each line. */
   std::string _path;
+  uint32_t _base;                     /** Base offset, or zero if not yet assigned. */
+  bool _linesScanned;                 /** True once _lineStarts has been computed. */
 
-  virtual void readLines(std::vector<std::string>& lines) = 0;
+  void scanLines();
 };
 
+/** A source file whose text is held in memory, used mainly for testing. */
 class StringSource : public AbstractProgramSource {
 public:
   StringSource(StringRef path, StringRef source)
     : AbstractProgramSource(path)
     , _source(source.begin(), source.end())
-    , _strm(_source)
   {}
-  
-  std::istream& open() { return _strm; }
-  void close() {}
+
+  StringRef content() const { return _source; }
   bool valid() const { return true; }
-  
+
 private:
-  void readLines(std::vector<std::string>& lines) {
-    std::istringstream strm(_source);
-    std::string line;
-    while (std::getline(strm, line)) {
-      _lines.push_back(line);
-    }
-  }
   std::string _source;
-  std::istringstream _strm;
 };
 
+/** A source file on disk. The file is memory-mapped when possible, otherwise it is read into
+    memory in a single pass. Either way, the file is only read once. */
 class FileSource : public AbstractProgramSource {
 public:
-  FileSource(support::Path fullPath, StringRef path)
-    : AbstractProgramSource(path)
-    , _fullPath(fullPath)
-    , _strm(_fullPath.c_str())
-  {}
-  
-  std::istream& open() { return _strm; }
-  void close() { _strm.close(); }
-  bool valid() const { return _strm.good(); }
-  
+  FileSource(support::Path fullPath, StringRef path);
+  FileSource(const FileSource&) = delete;
+  ~FileSource();
+
+  StringRef content() const { return StringRef(_data, _size); }
+  bool valid() const { return _valid; }
+
 private:
-  void readLines(std::vector<std::string>& lines) {
-    std::ifstream strm(_fullPath.c_str());
-    std::string line;
-    while (std::getline(strm, line)) {
-      _lines.push_back(line);
-    }
-  }
   support::Path _fullPath;
-  std::ifstream _strm;
+  const char* _data;        /** Start of the source text. */
+  size_t _size;             /** Length of the source text in bytes. */
+  bool _mapped;             /** True if _data is a memory-mapped region of the file. */
+  bool _valid;              /** True if the file was loaded successfully. */
+  std::string _buffer;      /** Source text, for files that could not be mapped. */
+
+  void load();
 };
 
 }}
@@ -0,0 +1,102 @@
+// ============================================================================
+// sourcemanager.cpp: Maps source locations to files, lines and columns.
+// ============================================================================
+
+#include "spark/source/sourcemanager.h"
+#include "spark/source/programsource.h"
+
+#if SPARK_HAVE_ALGORITHM
+  #include <algorithm>
+#endif
+
+namespace spark {
+namespace source {
+
+namespace {
+  /** Compute the one-based line and column of a file-relative offset. */
+  void decodeOffset(ProgramSource* source, uint32_t offset, uint32_t& line, uint32_t& col) {
+    StringRef text = source->content();
+    uint32_t index = source->lineIndexOf(offset);
+    StringRef lineText;
+    if (!source->getLine(index, lineText)) {
+      line = index + 1;
+      col = 1;
+      return;
+    }
+    uint32_t lineStart = uint32_t(lineText.begin() - text.begin());
+    if (offset == text.size() && offset > 0 &&
+        (text[offset - 1] == '\n' || text[offset - 1] == '\r')) {
+      // End of a file that finishes with a line break: that is the start of the next line.
+      line = index + 2;
+      col = 1;
+    } else {
+      line = index + 1;
+      col = offset - lineStart + 1;
+    }
+  }
+}
+
+SourceManager& SourceManager::get() {
+  static SourceManager instance;
+  return instance;
+}
+
+uint32_t SourceManager::add(ProgramSource* source, size_t size) {
+  #if SPARK_HAVE_MUTEX
+    std::lock_guard<std::mutex> lock(_mutex);
+  #endif
+  if (size >= UINT32_MAX - _next) {
+    return 0;
+  }
+  Entry entry;
+  entry.base = _next;
+  entry.end = _next + size + 1;
+  entry.source = source;
+  _entries.push_back(entry);
+  _next = entry.end;
+  return entry.base;
+}
+
+void SourceManager::remove(ProgramSource* source) {
+  #if SPARK_HAVE_MUTEX
+    std::lock_guard<std::mutex> lock(_mutex);
+  #endif
+  for (auto it = _entries.begin(); it != _entries.end(); ++it) {
+    if (it->source == source) {
+      _entries.erase(it);
+      return;
+    }
+  }
+}
+
+ProgramSource* SourceManager::find(uint32_t offset, uint32_t& base) {
+  #if SPARK_HAVE_MUTEX
+    std::lock_guard<std::mutex> lock(_mutex);
+  #endif
+  auto it = std::upper_bound(_entries.begin(), _entries.end(), offset,
+      [](uint32_t value, const Entry& entry) { return value < entry.base; });
+  if (it == _entries.begin()) {
+    return nullptr;
+  }
+  --it;
+  if (offset >= it->end) {
+    return nullptr;
+  }
+  base = it->base;
+  return it->source;
+}
+
+bool SourceManager::decode(const Location& loc, DecodedLocation& result) {
+  uint32_t base = 0;
+  ProgramSource* source = loc.isValid() ? find(loc.begin, base) : nullptr;
+  if (source == nullptr) {
+    result = DecodedLocation();
+    return false;
+  }
+  result.source = source;
+  decodeOffset(source, loc.begin - base, result.startLine, result.startCol);
+  decodeOffset(source, std::max(loc.begin, loc.end) - base, result.endLine, result.endCol);
+  return true;
+}
+
+}}
@@ -0,0 +1,85 @@
+// ============================================================================
+// sourcemanager.h: Maps source locations to files, lines and columns.
+// ============================================================================
+
+#ifndef SPARK_SOURCE_SOURCEMANAGER_H
+#define SPARK_SOURCE_SOURCEMANAGER_H 1
+
+#ifndef SPARK_SOURCE_LOCATION_H
+  #include "spark/source/location.h"
+#endif
+
+#if SPARK_HAVE_MUTEX
+  #include <mutex>
+#endif
+
+#if SPARK_HAVE_VECTOR
+  #include <vector>
+#endif
+
+namespace spark {
+namespace source {
+
+/** A location expanded into a file and line / column numbers. Lines and columns are
+    one-based, and endCol is the column one past the last character. */
+struct DecodedLocation {
+  ProgramSource* source;
+  uint32_t startLine;
+  uint32_t startCol;
+  uint32_t endLine;
+  uint32_t endCol;
+
+  DecodedLocation()
+    : source(nullptr)
+    , startLine(0)
+    , startCol(0)
+    , endLine(0)
+    , endCol(0)
+  {}
+};
+
+/** Assigns each source file a range of offsets within a single 32-bit offset space, so that a
+    location can be stored as a pair of offsets and still identify its file. Offset ranges are
+    never reused, so a stale location can only fail to decode. */
+class SourceManager {
+public:
+  /** The process-wide source manager. */
+  static SourceManager& get();
+
+  /** Reserve a range of offsets for 'source' and return the first. Each file gets one offset
+      past its end, so that the end-of-file position has a location. Returns zero, and reserves
+      nothing, if there isn't room for the file in the offset space. */
+  uint32_t add(ProgramSource* source, size_t size);
+
+  /** Release the range of 'source', which is being destroyed. */
+  void remove(ProgramSource* source);
+
+  /** Return the file containing 'offset', and its base offset; or nullptr if none. */
+  ProgramSource* find(uint32_t offset, uint32_t& base);
+
+  /** Compute the file, line and column of 'loc'. Returns false if the location is empty or
+      its file no longer exists. */
+  bool decode(const Location& loc, DecodedLocation& result);
+
+  /** Number of offsets that have been handed out. */
+  uint32_t size() const { return _next; }
+
+private:
+  struct Entry {
+    uint32_t base;
+    uint32_t end;
+    ProgramSource* source;
+  };
+
+  SourceManager() : _next(1) {}
+
+  #if SPARK_HAVE_MUTEX
+    std::mutex _mutex;
+  #endif
+  std::vector<Entry> _entries;  /** Live files, in order of base offset. */
+  uint32_t _next;               /** Next offset to hand out; zero means 'no location'. */
+};
+
+}}
+
+#endif
@@ -0,0 +1,140 @@
+// ============================================================================
+// arena.cpp: Memory allocation pools.
+// ============================================================================
+
+#include "spark/support/arena.h"
+
+#if SPARK_HAVE_CASSERT
+  #include <cassert>
+#endif
+
+#if SPARK_HAVE_MUTEX
+  #include <mutex>
+#endif
+
+namespace spark {
+namespace support {
+
+namespace {
+  /** Standard-size blocks released by arenas, which any arena on any thread can reuse. Only
+      a limited number are kept; the rest go back to the heap. */
+  class BlockPool {
+  public:
+    static const std::size_t MAX_BLOCKS = 64;
+
+    BlockPool() : _head(nullptr), _count(0) {}
+
+    /** Take a block from the pool, or return null if there are none. */
+    uint8_t* take() {
+      std::lock_guard<std::mutex> lock(_lock);
+      FreeBlock* blk = _head;
+      if (blk != nullptr) {
+        _head = blk->next;
+        --_count;
+      }
+      return reinterpret_cast<uint8_t*>(blk);
+    }
+
+    /** Put a block in the pool. Returns false if the pool is full. */
+    bool give(uint8_t* mem) {
+      std::lock_guard<std::mutex> lock(_lock);
+      if (_count >= MAX_BLOCKS) {
+        return false;
+      }
+      FreeBlock* blk = reinterpret_cast<FreeBlock*>(mem);
+      blk->next = _head;
+      _head = blk;
+      ++_count;
+      return true;
+    }
+
+  private:
+    struct FreeBlock {
+      FreeBlock* next;
+    };
+
+    std::mutex _lock;
+    FreeBlock* _head;
+    std::size_t _count;
+  };
+
+  /** The pool is never destroyed, so that arenas can be cleared during static destruction. */
+  BlockPool& blockPool() {
+    static BlockPool* pool = new BlockPool();
+    return *pool;
+  }
+}
+
+Arena::value_type* Arena::allocateSlow(std::size_t n, std::size_t align) {
+  // Large allocations get a block of their own, which goes on a separate list so that the
+  // space left in the current block can still be used.
+  std::size_t alignPad = align > MIN_ALIGNMENT ? align - MIN_ALIGNMENT : 0;
+  if (n + alignPad > _blockSize / 4) {
+    std::size_t blkSize = BLOCK_HEADER_SIZE + n + alignPad;
+    uint8_t* blk = new uint8_t[blkSize];
+    reinterpret_cast<Block*>(blk)->_next = _large;
+    _large = reinterpret_cast<Block*>(blk);
+    ++_stats.blocks;
+    ++_stats.oversized;
+    _stats.reserved += blkSize;
+    uint8_t* data = blk + BLOCK_HEADER_SIZE;
+    return data + (-reinterpret_cast<uintptr_t>(data) & (align - 1));
+  }
+
+  // Start a new standard block, abandoning what is left of the current one.
+  _stats.wasted += _end - _pos;
+  uint8_t* blk = nullptr;
+  if (_blockSize == DEFAULT_BLOCK_SIZE) {
+    blk = blockPool().take();
+    if (blk != nullptr) {
+      ++_stats.recycled;
+    }
+  }
+  if (blk == nullptr) {
+    blk = new uint8_t[_blockSize];
+  }
+  ++_stats.blocks;
+  _stats.reserved += _blockSize;
+  reinterpret_cast<Block*>(blk)->_next = _head;
+  _head = reinterpret_cast<Block*>(blk);
+  _end = blk + _blockSize;
+
+  uint8_t* data = blk + BLOCK_HEADER_SIZE;
+  uint8_t* result = data + (-reinterpret_cast<uintptr_t>(data) & (align - 1));
+  _pos = result + n;
+  assert(_pos <= _end);
+  return result;
+}
+
+void Arena::clear() {
+  releaseBlocks(_head, nullptr, _blockSize == DEFAULT_BLOCK_SIZE);
+  releaseBlocks(_large, nullptr, false);
+  _head = nullptr;
+  _large = nullptr;
+  _pos = nullptr;
+  _end = nullptr;
+  _stats = ArenaStats();
+}
+
+void Arena::rollback(const Mark& m) {
+  releaseBlocks(_head, m.head, _blockSize == DEFAULT_BLOCK_SIZE);
+  releaseBlocks(_large, m.large, false);
+  _head = m.head;
+  _large = m.large;
+  _pos = m.pos;
+  _end = m.end;
+  _stats = m.stats;
+}
+
+void Arena::releaseBlocks(Block* head, Block* until, bool recycle) {
+  while (head != until) {
+    assert(head != nullptr && "Arena mark is not in this arena.");
+    Block* blk = head;
+    head = head->_next;
+    if (!recycle || !blockPool().give(reinterpret_cast<uint8_t*>(blk))) {
+      delete [] reinterpret_cast<uint8_t*>(blk);
+    }
+  }
+}
+
+}}
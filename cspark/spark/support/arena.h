@@ -17,6 +17,10 @@
   #include <new>
 #endif
 
+#if SPARK_HAVE_STDINT_H
+  #include <stdint.h>
+#endif
+
 #if SPARK_HAVE_VECTOR
   #include <vector>
 #endif
@@ -24,6 +28,52 @@
 namespace spark {
 namespace support {
 
+/** Counts of the memory used by an arena. */
+struct ArenaStats {
+  ArenaStats()
+    : requested(0)
+    , allocated(0)
+    , reserved(0)
+    , blocks(0)
+    , recycled(0)
+    , oversized(0)
+    , wasted(0)
+  {}
+
+  /** Bytes asked for by callers. */
+  std::size_t requested;
+
+  /** Bytes handed out, which is the bytes requested rounded up for alignment. */
+  std::size_t allocated;
+
+  /** Bytes held in blocks, including block headers. */
+  std::size_t reserved;
+
+  /** Number of blocks, including those for large allocations. */
+  std::size_t blocks;
+
+  /** Number of standard blocks that were reused from the shared pool rather than the heap. */
+  std::size_t recycled;
+
+  /** Number of allocations large enough to be given a block of their own, apart from the
+      standard blocks. */
+  std::size_t oversized;
+
+  /** Free space left at the end of blocks that were abandoned for a new block. */
+  std::size_t wasted;
+
+  ArenaStats& operator+=(const ArenaStats& other) {
+    requested += other.requested;
+    allocated += other.allocated;
+    reserved += other.reserved;
+    blocks += other.blocks;
+    recycled += other.recycled;
+    oversized += other.oversized;
+    wasted += other.wasted;
+    return *this;
+  }
+};
+
 /** Memory arena. */
 class Arena {
 private:
@@ -37,11 +87,26 @@ public:
   /** Default block size. */
   static const std::size_t DEFAULT_BLOCK_SIZE = 0x10000 - BLOCK_HEADER_SIZE; // 64K
 
+  /** Alignment of allocations that don't ask for more. */
+  static const std::size_t MIN_ALIGNMENT = 8;
+
   Arena(std::size_t blockSize = DEFAULT_BLOCK_SIZE)
     : _head(nullptr)
+    , _large(nullptr)
     , _pos(nullptr)
     , _end(nullptr)
     , _blockSize(blockSize)
+    , _name("")
+  {}
+
+  /** Construct an arena with a name, which identifies it in memory reports. */
+  Arena(const char* name, std::size_t blockSize = DEFAULT_BLOCK_SIZE)
+    : _head(nullptr)
+    , _large(nullptr)
+    , _pos(nullptr)
+    , _end(nullptr)
+    , _blockSize(blockSize)
+    , _name(name)
   {}
   Arena(const Arena&) = delete;
 
@@ -51,42 +116,65 @@ public:
 
   Arena& operator=(const Arena& a) = delete;
 
-  /** Allocate a block of at least size `size`. */
-  value_type* allocate(std::size_t n) {
+  /** Allocate a block of at least size `size`, aligned to 'align' bytes, which must be a power
+      of two. Allocations are always aligned to at least 8 bytes. */
+  value_type* allocate(std::size_t n, std::size_t align = MIN_ALIGNMENT) {
+    assert((align & (align - 1)) == 0);
+    _stats.requested += n;
     n = (n + 7) & ~7; // Round up to nearest 8.
-    size_t freeSpace = _end - _pos;
-    assert(freeSpace < _blockSize);
-    if (freeSpace < n) {
-      // TODO: In cases where the new block will be fuller than the previous block, we could
-      // play games with keeping the previous block at the head of the list.
-      size_t blkSize = std::max(n + BLOCK_HEADER_SIZE, _blockSize);
-      uint8_t* blk = new uint8_t[blkSize];
-      _pos = &blk[BLOCK_HEADER_SIZE];
-      _end = &blk[blkSize];
-      reinterpret_cast<Block*>(blk)->_next = _head;
-      _head = reinterpret_cast<Block*>(blk);
+    _stats.allocated += n;
+    std::size_t pad = -reinterpret_cast<uintptr_t>(_pos) & (align - 1);
+    if (n + pad > std::size_t(_end - _pos)) {
+      return allocateSlow(n, align);
     }
-    uint8_t* result = _pos;
-    _pos += n;
-    assert(_pos <= _end);
-    assert((_end - _pos) < _blockSize);
+    uint8_t* result = _pos + pad;
+    _pos = result + n;
     return result;
   }
 
   /** Deallocate does nothing. */
   void deallocate(value_type* p, std::size_t n) {}
 
-  /** Free all memory. */
-  void clear() {
-    while (_head) {
-      Block* blk = _head;
-      _head = _head->_next;
-      delete [] reinterpret_cast<uint8_t*>(blk);
-    }
-    _pos = nullptr;
-    _end = nullptr;
+  /** Free all memory. Standard-size blocks are kept in a pool shared by all arenas, to be
+      reused by the next arena that needs a block. */
+  void clear();
+
+  /** A point in an arena's allocation history, which the arena can be rolled back to. */
+  class Mark {
+  private:
+    friend class Arena;
+    Block* head;
+    Block* large;
+    value_type* pos;
+    value_type* end;
+    ArenaStats stats;
+  };
+
+  /** Return the current allocation point. */
+  Mark mark() const {
+    Mark m;
+    m.head = _head;
+    m.large = _large;
+    m.pos = _pos;
+    m.end = _end;
+    m.stats = _stats;
+    return m;
   }
 
+  /** Free everything allocated since 'm' was taken, including any blocks. Marks must be
+      rolled back in the reverse order that they were taken, and nothing allocated since the
+      mark may be used afterwards. */
+  void rollback(const Mark& m);
+
+  /** The name of this arena, or the empty string if it has none. */
+  const char* name() const { return _name; }
+
+  /** Counts of the memory used by this arena since it was created or last cleared. */
+  const ArenaStats& stats() const { return _stats; }
+
+  /** Total number of bytes handed out by this arena since it was created or last cleared. */
+  std::size_t bytesAllocated() const { return _stats.allocated; }
+
   /** Make a long-lived copy of this StringRef. */
   collections::StringRef copyOf(const collections::StringRef& str) {
     assert(str.size() < 0x100000);
@@ -113,10 +201,45 @@ public:
 //     assert(_pos <= _end);
 //   }
 private:
-  Block* _head;
+  Block* _head;       // Standard blocks, the one being allocated from first.
+  Block* _large;      // Blocks holding a single large allocation each.
   value_type *_pos;
   value_type *_end;
   size_t _blockSize;
+  const char* _name;
+  ArenaStats _stats;
+
+  value_type* allocateSlow(std::size_t n, std::size_t align);
+  void releaseBlocks(Block* head, Block* until, bool recycle);
+};
+
+/** Scoped checkpoint for speculative allocations: when the checkpoint goes out of scope, the
+    arena is rolled back to where it was when the checkpoint was created, unless keep() has
+    been called. */
+class ArenaCheckpoint {
+public:
+  ArenaCheckpoint(Arena& arena) : _arena(&arena), _mark(arena.mark()) {}
+  ArenaCheckpoint(const ArenaCheckpoint&) = delete;
+  ArenaCheckpoint& operator=(const ArenaCheckpoint&) = delete;
+
+  ~ArenaCheckpoint() {
+    rollback();
+  }
+
+  /** Keep everything allocated since the checkpoint. */
+  void keep() { _arena = nullptr; }
+
+  /** Roll back now rather than at the end of the scope. */
+  void rollback() {
+    if (_arena != nullptr) {
+      _arena->rollback(_mark);
+      _arena = nullptr;
+    }
+  }
+
+private:
+  Arena* _arena;
+  Arena::Mark _mark;
 };
 
 /** Allocator compatible with C++ std containers. */
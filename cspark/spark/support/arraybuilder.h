@@ -9,69 +9,102 @@
   #include "spark/support/arena.h"
 #endif
 
+#ifndef SPARK_SUPPORT_SCRATCHSTACK_H
+  #include "spark/support/scratchstack.h"
+#endif
+
 #ifndef SPARK_COLLECTIONS_ARRAYREF_H
   #include "spark/collections/arrayref.h"
 #endif
 
+#if SPARK_HAVE_TYPE_TRAITS
+  #include <type_traits>
+#endif
+
 namespace spark {
 namespace support {
 
-/** Helper for building arrays in an arena. */
+/** Helper for building arrays in an arena. Elements are accumulated on the thread's scratch
+    stack, and copied into the arena by build(). */
 template<class T>
 class ArrayBuilder {
 public:
   typedef T value_type;
+  typedef const T* const_iterator;
 
-  ArrayBuilder(support::Arena& arena) : _arena(arena) {}
+  ArrayBuilder(support::Arena& arena) : _arena(arena), _size(0) {}
   ArrayBuilder(support::Arena& arena, const collections::ArrayRef<T>& init)
     : _arena(arena)
-    , _elements(init.begin(), init.end())
-  {}
+    , _size(0)
+  {
+    append(init.begin(), init.end());
+  }
   ArrayBuilder(support::Arena& arena, const std::vector<value_type>& init)
     : _arena(arena)
-    , _elements(init)
-  {}
-  ArrayBuilder(support::Arena& arena, const std::vector<value_type>&& init)
-    : _arena(arena)
-    , _elements(init)
-  {}
+    , _size(0)
+  {
+    append(init.data(), init.data() + init.size());
+  }
   ArrayBuilder(support::Arena& arena, std::initializer_list<T> il)
     : _arena(arena)
-    , _elements(il)
-  {}
+    , _size(0)
+  {
+    append(il.begin(), il.end());
+  }
+  ArrayBuilder(const ArrayBuilder&) = delete;
+
+  ArrayBuilder& operator=(const ArrayBuilder&) = delete;
 
   /** Append an element to the array. */
   ArrayBuilder& append(const T& elt) {
-    _elements.push_back(elt);
+    if ((_size + 1) * sizeof(T) > _buffer.capacity()) {
+      _buffer.reserve(_size * sizeof(T), (_size + 1) * sizeof(T));
+    }
+    data()[_size++] = elt;
+    return *this;
+  }
+
+  /** Append the elements in the range [first, last). */
+  ArrayBuilder& append(const T* first, const T* last) {
+    size_t count = last - first;
+    _buffer.reserve(_size * sizeof(T), (_size + count) * sizeof(T));
+    std::copy(first, last, data() + _size);
+    _size += count;
     return *this;
   }
 
   /** The number of elements in the array. */
   size_t size() const {
-    return _elements.size();
+    return _size;
   }
 
   const T& operator[](int index) const {
-    return _elements[index];
+    return data()[index];
   }
 
   /** Iterate over the collection. */
-  typename std::vector<value_type>::const_iterator begin() const { return _elements.begin(); }
-  typename std::vector<value_type>::const_iterator end() const { return _elements.end(); }
+  const_iterator begin() const { return data(); }
+  const_iterator end() const { return data() + _size; }
 
   /** Allocate an array in the arena and return a reference to it. */
   collections::ArrayRef<T> build() const {
-    if (_elements.empty()) {
+    if (_size == 0) {
       return collections::ArrayRef<value_type>();
     }
-    T* data = reinterpret_cast<T*>(_arena.allocate(sizeof(T) * _elements.size()));
-    collections::ArrayRef<value_type> result(data, _elements.size());
-    std::copy(_elements.begin(), _elements.end(), data);
-    return result;
+    T* result = reinterpret_cast<T*>(_arena.allocate(sizeof(T) * _size));
+    std::copy(begin(), end(), result);
+    return collections::ArrayRef<value_type>(result, _size);
   }
 private:
+  static_assert(alignof(T) <= 8, "Scratch buffers are only 8-byte aligned.");
+  static_assert(std::is_trivially_copyable<T>::value,
+      "Elements are copied as raw bytes and never destroyed.");
+
   support::Arena& _arena;
-  std::vector<value_type> _elements;
+  ScratchBuffer _buffer;
+  size_t _size;
+
+  T* data() const { return reinterpret_cast<T*>(_buffer.data()); }
 };
 
 }}
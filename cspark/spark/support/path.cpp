@@ -44,6 +44,21 @@ bool Path::isFile() const {
   return _status == ST_OK && S_ISREG(_mode);
 }
 
+bool Path::makeDirs() const {
+  if (isDir()) {
+    return true;
+  }
+  Path dirParent = parent();
+  if (!dirParent.empty() && !dirParent.makeDirs()) {
+    return false;
+  }
+  if (::mkdir(_path.c_str(), 0777) != 0 && errno != EEXIST) {
+    return false;
+  }
+  _status = ST_UNSET;
+  return isDir();
+}
+
 // bool Path::isReadable() {
 //   return _status == ST_OK && S_ISDIR(_mode);
 // }
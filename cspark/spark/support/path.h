@@ -69,6 +69,10 @@ public:
   bool isDir() const;
   bool isFile() const;
 
+  /** Create this directory, along with any missing parent directories. Returns true if the
+      directory exists afterwards. */
+  bool makeDirs() const;
+
   /** Equality operator. */
   bool operator==(const Path& src) const {
     return StringRef(src._path) == StringRef(_path);
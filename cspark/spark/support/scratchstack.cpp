@@ -0,0 +1,138 @@
+// ============================================================================
+// scratchstack.cpp: Per-thread stack of temporary buffers.
+// ============================================================================
+
+#include "spark/support/scratchstack.h"
+
+#if SPARK_HAVE_ALGORITHM
+  #include <algorithm>
+#endif
+
+#if SPARK_HAVE_CSTRING
+  #include <cstring>
+#endif
+
+namespace spark {
+namespace support {
+
+namespace {
+  inline std::size_t roundUp(std::size_t n) {
+    return (n + 7) & ~std::size_t(7);
+  }
+}
+
+ScratchStack::ScratchStack()
+  : _chunkIndex(0)
+  , _newest(nullptr)
+{
+  Chunk chunk;
+  chunk.begin = new uint8_t[CHUNK_SIZE];
+  chunk.end = chunk.begin + CHUNK_SIZE;
+  _chunks.push_back(chunk);
+  _top = chunk.begin;
+}
+
+ScratchStack::~ScratchStack() {
+  assert(_newest == nullptr && "Scratch stack destroyed while in use.");
+  for (Chunk& chunk : _chunks) {
+    delete [] chunk.begin;
+  }
+}
+
+ScratchStack& ScratchStack::current() {
+  static thread_local ScratchStack stack;
+  return stack;
+}
+
+std::size_t ScratchStack::used() const {
+  std::size_t result = _top - _chunks[_chunkIndex].begin;
+  for (std::size_t i = 0; i < _chunkIndex; ++i) {
+    result += _chunks[i].end - _chunks[i].begin;
+  }
+  return result;
+}
+
+std::size_t ScratchStack::capacity() const {
+  std::size_t result = 0;
+  for (const Chunk& chunk : _chunks) {
+    result += chunk.end - chunk.begin;
+  }
+  return result;
+}
+
+uint8_t* ScratchStack::allocate(std::size_t size) {
+  size = roundUp(size);
+  if (std::size_t(_chunks[_chunkIndex].end - _top) < size) {
+    // Move on to the next chunk. Chunks above the top are unused, so one that is too small
+    // can simply be replaced.
+    std::size_t next = _chunkIndex + 1;
+    if (next == _chunks.size() || std::size_t(_chunks[next].end - _chunks[next].begin) < size) {
+      std::size_t chunkSize = std::max(size, std::size_t(CHUNK_SIZE));
+      Chunk chunk;
+      chunk.begin = new uint8_t[chunkSize];
+      chunk.end = chunk.begin + chunkSize;
+      if (next == _chunks.size()) {
+        _chunks.push_back(chunk);
+      } else {
+        delete [] _chunks[next].begin;
+        _chunks[next] = chunk;
+      }
+    }
+    _chunkIndex = next;
+    _top = _chunks[next].begin;
+  }
+  uint8_t* result = _top;
+  _top += size;
+  return result;
+}
+
+bool ScratchStack::extend(uint8_t* end, std::size_t size) {
+  size = roundUp(size);
+  if (end == _top && std::size_t(_chunks[_chunkIndex].end - _top) >= size) {
+    _top += size;
+    return true;
+  }
+  return false;
+}
+
+ScratchBuffer::ScratchBuffer()
+  : _stack(ScratchStack::current())
+  , _prev(_stack._newest)
+  , _next(nullptr)
+  , _mark(_stack.mark())
+  , _data(nullptr)
+  , _capacity(0)
+{
+  if (_prev != nullptr) {
+    _prev->_next = this;
+  }
+  _stack._newest = this;
+}
+
+ScratchBuffer::~ScratchBuffer() {
+  assert(_stack._newest == this && "Scratch buffers must be released in reverse order.");
+  _stack._newest = _prev;
+  if (_prev != nullptr) {
+    _prev->_next = nullptr;
+  }
+  _stack.release(_mark);
+}
+
+void ScratchBuffer::grow(std::size_t used, std::size_t size) {
+  std::size_t capacity = roundUp(std::max(size, std::max(_capacity * 2, std::size_t(64))));
+  if (_data == nullptr || !_stack.extend(_data + _capacity, capacity - _capacity)) {
+    uint8_t* data = _stack.allocate(capacity);
+    if (used > 0) {
+      std::memcpy(data, _data, used);
+    }
+    _data = data;
+  }
+  _capacity = capacity;
+
+  // Buffers created after this one must not release its new space.
+  for (ScratchBuffer* b = _next; b != nullptr; b = b->_next) {
+    b->_mark = _stack.mark();
+  }
+}
+
+}}
@@ -0,0 +1,137 @@
+// ============================================================================
+// scratchstack.h: Per-thread stack of temporary buffers.
+// ============================================================================
+
+#ifndef SPARK_SUPPORT_SCRATCHSTACK_H
+#define SPARK_SUPPORT_SCRATCHSTACK_H 1
+
+#ifndef SPARK_CONFIG_H
+  #include "spark/config.h"
+#endif
+
+#if SPARK_HAVE_CASSERT
+  #include <cassert>
+#endif
+
+#if SPARK_HAVE_STDINT_H
+  #include <stdint.h>
+#endif
+
+#if SPARK_HAVE_VECTOR
+  #include <vector>
+#endif
+
+namespace spark {
+namespace support {
+
+class ScratchBuffer;
+
+/** A stack of memory used for short-lived buffers, such as the lists that are built up while
+    parsing. Space is allocated by bumping a pointer, and is released when the buffer that
+    allocated it goes away; buffers are released in the reverse order of their creation. The
+    stack's memory is kept for reuse, so once it has grown to the size needed there are no
+    further calls to the heap.
+
+    Each thread has its own stack, so buffers must be used only on the thread that created them.
+ */
+class ScratchStack {
+public:
+  /** Default size of each chunk of memory. */
+  static const std::size_t CHUNK_SIZE = 0x10000; // 64K
+
+  ScratchStack();
+  ScratchStack(const ScratchStack&) = delete;
+  ~ScratchStack();
+
+  ScratchStack& operator=(const ScratchStack&) = delete;
+
+  /** The stack for the current thread. */
+  static ScratchStack& current();
+
+  /** Number of bytes currently allocated, including space that is waiting to be released. */
+  std::size_t used() const;
+
+  /** Number of bytes of memory owned by the stack. */
+  std::size_t capacity() const;
+
+private:
+  friend class ScratchBuffer;
+
+  struct Chunk {
+    uint8_t* begin;
+    uint8_t* end;
+  };
+
+  /** A position on the stack. */
+  struct Mark {
+    std::size_t chunk;
+    uint8_t* pos;
+  };
+
+  std::vector<Chunk> _chunks;
+  std::size_t _chunkIndex;  /** Index of the chunk that 'top' is in. */
+  uint8_t* _top;            /** Next free byte. */
+  ScratchBuffer* _newest;   /** Most recently created live buffer. */
+
+  Mark mark() const {
+    Mark m;
+    m.chunk = _chunkIndex;
+    m.pos = _top;
+    return m;
+  }
+
+  void release(const Mark& m) {
+    _chunkIndex = m.chunk;
+    _top = m.pos;
+  }
+
+  /** Allocate 'size' contiguous bytes on top of the stack. */
+  uint8_t* allocate(std::size_t size);
+
+  /** If 'end' is the top of the stack, and there is room, allocate another 'size' bytes
+      after it and return true. */
+  bool extend(uint8_t* end, std::size_t size);
+};
+
+/** A growable block of memory on the current thread's scratch stack. This is the storage used
+    by list builders; the memory is released when the buffer is destroyed, so buffers should
+    always be local variables.
+
+    A buffer grows in place when it is at the top of the stack. If it isn't (because a buffer
+    created later has allocated space since), its contents are moved to the top of the stack;
+    the old space is not reused until the enclosing buffers are released. */
+class ScratchBuffer {
+public:
+  ScratchBuffer();
+  ScratchBuffer(const ScratchBuffer&) = delete;
+  ~ScratchBuffer();
+
+  ScratchBuffer& operator=(const ScratchBuffer&) = delete;
+
+  /** Start of the buffer. Any growth may move the buffer. */
+  uint8_t* data() const { return _data; }
+
+  /** Size of the buffer in bytes. */
+  std::size_t capacity() const { return _capacity; }
+
+  /** Make the buffer at least 'size' bytes, keeping the first 'used' bytes of the contents. */
+  void reserve(std::size_t used, std::size_t size) {
+    if (size > _capacity) {
+      grow(used, size);
+    }
+  }
+
+private:
+  ScratchStack& _stack;
+  ScratchBuffer* _prev;         /** Next older live buffer. */
+  ScratchBuffer* _next;         /** Next newer live buffer. */
+  ScratchStack::Mark _mark;     /** Stack position to return to when this buffer is released. */
+  uint8_t* _data;
+  std::size_t _capacity;
+
+  void grow(std::size_t used, std::size_t size);
+};
+
+}}
+
+#endif
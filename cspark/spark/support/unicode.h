@@ -0,0 +1,35 @@
+// ============================================================================
+// unicode.h: UTF-8 decoding and Unicode character properties.
+// ============================================================================
+
+#ifndef SPARK_SUPPORT_UNICODE_H
+#define SPARK_SUPPORT_UNICODE_H 1
+
+#ifndef SPARK_CONFIG_H
+  #include "spark/config.h"
+#endif
+
+#if SPARK_HAVE_STDINT_H
+  #include <stdint.h>
+#endif
+
+namespace spark {
+namespace support {
+
+/** Value returned by decodeUtf8() for a malformed sequence. */
+static const char32_t INVALID_CODE_POINT = 0xffffffff;
+
+/** Decode one UTF-8 encoded code point starting at 'pos', reading no further than 'end', and
+    store the length of the sequence in 'length'. Overlong encodings, surrogates and values
+    above U+10FFFF are rejected, returning INVALID_CODE_POINT with a length of 1. */
+char32_t decodeUtf8(const char* pos, const char* end, unsigned& length);
+
+/** True if 'ch' has the Unicode XID_Start property (can begin an identifier). */
+bool isXIDStart(char32_t ch);
+
+/** True if 'ch' has the Unicode XID_Continue property (can appear within an identifier). */
+bool isXIDContinue(char32_t ch);
+
+}}
+
+#endif
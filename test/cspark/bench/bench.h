@@ -0,0 +1,150 @@
+/* ================================================================== *
+ * Shared harness for Spark benchmarks.
+ * ================================================================== */
+
+#ifndef SPARK_BENCH_BENCH_H
+#define SPARK_BENCH_BENCH_H 1
+
+#include "spark/support/path.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace spark {
+namespace bench {
+
+/** Summary of a series of timed runs, in seconds per run. */
+struct Timing {
+  double min;
+  double median;
+  double p95;
+};
+
+/** Summarize a series of run times, in seconds. */
+inline Timing summarize(std::vector<double> samples) {
+  std::sort(samples.begin(), samples.end());
+  Timing result;
+  result.min = samples.front();
+  result.median = samples[samples.size() / 2];
+  result.p95 = samples[std::min(samples.size() - 1, samples.size() * 95 / 100)];
+  return result;
+}
+
+/** Call 'fn' 'warmup' times without timing it, then 'runs' times with timing. */
+template<class Fn>
+Timing measure(Fn fn, unsigned warmup, unsigned runs) {
+  typedef std::chrono::steady_clock Clock;
+  for (unsigned i = 0; i < warmup; ++i) {
+    fn();
+  }
+  std::vector<double> samples;
+  samples.reserve(runs);
+  for (unsigned i = 0; i < runs; ++i) {
+    Clock::time_point start = Clock::now();
+    fn();
+    samples.push_back(std::chrono::duration<double>(Clock::now() - start).count());
+  }
+  return summarize(samples);
+}
+
+/** Keep the optimizer from discarding a value that the benchmark computes. */
+template<class T>
+inline void keep(const T& value) {
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+/** Print one line of results, with times scaled to nanoseconds per item. */
+inline void report(const char* name, const Timing& t, double itemsPerRun, const char* item) {
+  std::printf("%-24s %10.2f ns/%s (min %.2f, p95 %.2f)\n", name,
+      t.median * 1e9 / itemsPerRun, item, t.min * 1e9 / itemsPerRun, t.p95 * 1e9 / itemsPerRun);
+}
+
+/** Print one line of throughput results: megabytes and millions of items per second, at the
+    median and at the 95th percentile run time. */
+inline void reportRate(const char* name, const Timing& t, double bytesPerRun, double itemsPerRun,
+    const char* item) {
+  std::printf("%-24s %9.1f MB/s %9.2f M%s/s (p95 %.1f MB/s, %.2f M%s/s)\n", name,
+      bytesPerRun / t.median * 1e-6, itemsPerRun / t.median * 1e-6, item,
+      bytesPerRun / t.p95 * 1e-6, itemsPerRun / t.p95 * 1e-6, item);
+}
+
+/** Accumulates results and writes them as a JSON document, for tracking between releases. */
+class JsonResults {
+public:
+  JsonResults(const char* benchmark) : _benchmark(benchmark) {}
+
+  /** Record the timing of one case, which processes 'bytes' and 'items' per run. */
+  void add(const std::string& name, const Timing& t, double bytes, double items) {
+    Entry e = { name, t, bytes, items };
+    _entries.push_back(e);
+  }
+
+  /** Write the results to 'out'. */
+  void write(std::FILE* out) const {
+    std::fprintf(out, "{\n  \"benchmark\": \"%s\",\n  \"results\": [", _benchmark);
+    for (size_t i = 0; i < _entries.size(); ++i) {
+      const Entry& e = _entries[i];
+      std::fprintf(out, "%s\n    {\"name\": \"%s\", \"bytes\": %.0f, \"items\": %.0f, "
+          "\"min_s\": %.9f, \"median_s\": %.9f, \"p95_s\": %.9f}", i > 0 ? "," : "",
+          e.name.c_str(), e.bytes, e.items, e.t.min, e.t.median, e.t.p95);
+    }
+    std::fprintf(out, "\n  ]\n}\n");
+  }
+
+  /** Write the results to the file at 'path', or to stdout if 'path' is "-". */
+  bool write(const char* path) const {
+    if (std::strcmp(path, "-") == 0) {
+      write(stdout);
+      return true;
+    }
+    std::FILE* out = std::fopen(path, "w");
+    if (out == nullptr) {
+      std::perror(path);
+      return false;
+    }
+    write(out);
+    std::fclose(out);
+    return true;
+  }
+
+private:
+  struct Entry {
+    std::string name;
+    Timing t;
+    double bytes;
+    double items;
+  };
+
+  const char* _benchmark;
+  std::vector<Entry> _entries;
+};
+
+/** Recursively collect the paths of Spark source files in 'path'. */
+inline void collectSources(const support::Path& path, std::vector<support::Path>& result) {
+  if (path.isDir()) {
+    std::vector<support::Path> entries;
+    support::StringRef name;
+    support::PathIterator it = path.iterate();
+    while (it.next(name)) {
+      if (name != "." && name != "..") {
+        entries.push_back(support::Path(path, name));
+      }
+    }
+    std::sort(entries.begin(), entries.end(),
+        [](const support::Path& a, const support::Path& b) {
+          return std::strcmp(a.c_str(), b.c_str()) < 0;
+        });
+    for (const support::Path& entry : entries) {
+      collectSources(entry, result);
+    }
+  } else if (path.isFile() && path.suffix() == ".sp") {
+    result.push_back(path);
+  }
+}
+
+}}
+
+#endif
@@ -0,0 +1,236 @@
+/* ================================================================== *
+ * Benchmark for expression parsing: measures parser throughput, not
+ * counting tokenization, over generated inputs that are dense in
+ * operators and calls, and over the library sources for comparison.
+ *
+ * Usage: exprbench [--runs N] [--warmup N] [--json FILE] [paths...]
+ *   paths      Source trees to parse as the real corpus (default: lib/spark).
+ *   --json     Also write the results as JSON to FILE ('-' for stdout).
+ * ================================================================== */
+
+#include "bench.h"
+#include "spark/ast/module.h"
+#include "spark/error/reporter.h"
+#include "spark/parse/lexer.h"
+#include "spark/parse/parser.h"
+#include "spark/source/programsource.h"
+#include "spark/support/arena.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace spark;
+
+namespace {
+  typedef std::vector<std::unique_ptr<source::ProgramSource>> SourceList;
+
+  /** A set of sources that are parsed together. */
+  struct Corpus {
+    std::string name;
+    SourceList sources;
+    size_t bytes;
+    size_t tokens;
+  };
+
+  /** Parse every source in 'corpus', returning the number of errors. */
+  int parseAll(const Corpus& corpus) {
+    error::BufferedReporter reporter;
+    for (const auto& src : corpus.sources) {
+      support::Arena arena;
+      parse::Parser parser(reporter, src.get(), arena);
+      bench::keep(parser.module());
+    }
+    return reporter.errorCount();
+  }
+
+  /** Time parsing of every source in 'corpus'. The parsers are created, which tokenizes the
+      sources, before the clock starts, so that only the parsing itself is measured. */
+  bench::Timing timeParse(const Corpus& corpus, unsigned warmup, unsigned runs) {
+    typedef std::chrono::steady_clock Clock;
+    std::vector<double> samples;
+    for (unsigned i = 0; i < warmup + runs; ++i) {
+      error::BufferedReporter reporter;
+      support::Arena arena;
+      std::vector<std::unique_ptr<parse::Parser>> parsers;
+      for (const auto& src : corpus.sources) {
+        parsers.emplace_back(new parse::Parser(reporter, src.get(), arena));
+      }
+      Clock::time_point start = Clock::now();
+      for (const auto& parser : parsers) {
+        bench::keep(parser->module());
+      }
+      if (i >= warmup) {
+        samples.push_back(std::chrono::duration<double>(Clock::now() - start).count());
+      }
+    }
+    return bench::summarize(samples);
+  }
+
+  size_t countTokens(const Corpus& corpus) {
+    size_t count = 0;
+    for (const auto& src : corpus.sources) {
+      parse::Lexer lex(src.get());
+      while (lex.next() != parse::TOKEN_END) {
+        ++count;
+      }
+    }
+    return count;
+  }
+
+  void addSource(Corpus& corpus, const std::string& text) {
+    corpus.sources.emplace_back(new source::StringSource(corpus.name, text));
+    corpus.bytes += text.size();
+  }
+
+  /** Functions whose bodies are arithmetic expressions of a few hundred terms, mixing operators
+      of every precedence level. */
+  void genArithmeticChains(Corpus& corpus) {
+    static const char* const ops[] = { " + ", " * ", " - ", " << ", " / ", " & ", " % ", " | " };
+    std::string text;
+    char buf[64];
+    for (unsigned i = 0; i < 500; ++i) {
+      std::snprintf(buf, sizeof buf, "def chain%u(a: i32, b: i32) -> i32 => a", i);
+      text += buf;
+      for (unsigned j = 0; j < 300; ++j) {
+        text += ops[(i + j) % 8];
+        text += (j % 3 == 0) ? "b" : (j % 3 == 1) ? "(a - 1)" : "7";
+      }
+      text += ";\n";
+    }
+    addSource(corpus, text);
+  }
+
+  /** Calls nested a few levels deep, with arithmetic in the arguments. */
+  void genNestedCalls(Corpus& corpus) {
+    std::string text;
+    char buf[64];
+    for (unsigned i = 0; i < 2000; ++i) {
+      std::snprintf(buf, sizeof buf, "def g%u(a: i32, b: i32) -> i32 => ", i);
+      text += buf;
+      for (unsigned depth = 0; depth < 12; ++depth) {
+        text += (depth % 2) ? "h(a * 2, " : "k(b + 1, a, ";
+      }
+      text += "a - b";
+      text.append(12, ')');
+      text += ";\n";
+    }
+    addSource(corpus, text);
+  }
+
+  /** Conditions built from comparisons and logical operators, including the two-token and
+      type-operand forms. */
+  void genConditions(Corpus& corpus) {
+    std::string text;
+    char buf[64];
+    for (unsigned i = 0; i < 2000; ++i) {
+      std::snprintf(buf, sizeof buf, "def c%u() -> bool => ", i);
+      text += buf;
+      for (unsigned j = 0; j < 20; ++j) {
+        if (j > 0) {
+          text += (j % 2) ? " and " : " or ";
+        }
+        switch (j % 4) {
+          case 0: text += "a < b + 1"; break;
+          case 1: text += "x not in y"; break;
+          case 2: text += "z is not i32"; break;
+          case 3: text += "a >= b == c != d"; break;
+        }
+      }
+      text += ";\n";
+    }
+    addSource(corpus, text);
+  }
+
+  /** Statements whose expressions are single operands, which should cost no more than the
+      operand itself. */
+  void genSingleOperands(Corpus& corpus) {
+    std::string text;
+    char buf[64];
+    for (unsigned i = 0; i < 2000; ++i) {
+      std::snprintf(buf, sizeof buf, "def s%u() {\n", i);
+      text += buf;
+      for (unsigned j = 0; j < 20; ++j) {
+        text += (j % 2) ? "  let x = 1;\n" : "  f(a, b, c);\n";
+      }
+      text += "  return x;\n}\n";
+    }
+    addSource(corpus, text);
+  }
+
+  void usage() {
+    std::cerr << "Usage: exprbench [--runs N] [--warmup N] [--json FILE] [paths...]\n";
+    std::exit(1);
+  }
+}
+
+int main(int argc, char** argv) {
+  unsigned runs = 10;
+  unsigned warmup = 2;
+  const char* jsonPath = nullptr;
+  std::vector<support::Path> files;
+  bool hasPaths = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    if (arg == "--runs" && i + 1 < argc) {
+      runs = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--warmup" && i + 1 < argc) {
+      warmup = std::atoi(argv[++i]);
+    } else if (arg == "--json" && i + 1 < argc) {
+      jsonPath = argv[++i];
+    } else if (!arg.empty() && arg[0] == '-') {
+      usage();
+    } else {
+      bench::collectSources(support::Path(argv[i]), files);
+      hasPaths = true;
+    }
+  }
+  if (!hasPaths) {
+    bench::collectSources(support::Path("lib/spark"), files);
+  }
+
+  std::vector<std::unique_ptr<Corpus>> corpora;
+  typedef void (*Generator)(Corpus&);
+  static const struct { const char* name; Generator gen; } synthetic[] = {
+    { "arithmetic-chains", genArithmeticChains },
+    { "nested-calls", genNestedCalls },
+    { "conditions", genConditions },
+    { "single-operands", genSingleOperands },
+  };
+  for (const auto& s : synthetic) {
+    Corpus* corpus = new Corpus { s.name, SourceList(), 0, 0 };
+    s.gen(*corpus);
+    corpora.emplace_back(corpus);
+  }
+
+  Corpus* lib = new Corpus { "lib", SourceList(), 0, 0 };
+  for (const support::Path& path : files) {
+    source::FileSource* src = new source::FileSource(path, path.str());
+    lib->sources.emplace_back(src);
+    lib->bytes += src->content().size();
+  }
+  corpora.emplace_back(lib);
+
+  std::printf("%zu library files; %u runs after %u warmup runs\n", files.size(), runs, warmup);
+  bench::JsonResults json("exprbench");
+  for (const auto& corpus : corpora) {
+    if (corpus->bytes == 0) {
+      continue;
+    }
+    if (parseAll(*corpus) != 0) {
+      std::cerr << "Errors parsing " << corpus->name << ".\n";
+      return 1;
+    }
+    corpus->tokens = countTokens(*corpus);
+    bench::Timing t = timeParse(*corpus, warmup, runs);
+    bench::reportRate(corpus->name.c_str(), t, corpus->bytes, corpus->tokens, "tok");
+    json.add(corpus->name, t, corpus->bytes, corpus->tokens);
+  }
+
+  if (jsonPath != nullptr && !json.write(jsonPath)) {
+    return 1;
+  }
+  return 0;
+}
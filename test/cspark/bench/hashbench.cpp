@@ -0,0 +1,160 @@
+/* ================================================================== *
+ * Benchmark for string hashing: compares hashBytes, which backs
+ * std::hash<StringRef> and atom interning, with the byte-at-a-time
+ * hashes it replaced, on identifiers and on longer strings.
+ *
+ * Usage: hashbench [--runs N] [--warmup N] [--json FILE] [paths...]
+ *   paths      Source trees to take identifiers from (default: lib/spark).
+ *   --json     Also write the results as JSON to FILE ('-' for stdout).
+ * ================================================================== */
+
+#include "bench.h"
+#include "spark/collections/hashing.h"
+#include "spark/parse/lexer.h"
+#include "spark/source/programsource.h"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace spark;
+using collections::StringRef;
+
+namespace {
+  /** The hash that std::hash<StringRef> used to compute. */
+  std::size_t combineHash(const StringRef& text) {
+    std::size_t seed = 0;
+    for (char c : text) {
+      std::hash_combine(seed, std::hash<char>()(c));
+    }
+    return seed;
+  }
+
+  /** The hash that atoms used to be interned with (FNV-1a). */
+  std::size_t fnvHash(const StringRef& text) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (char ch : text) {
+      h = (h ^ uint8_t(ch)) * 0x100000001b3ull;
+    }
+    return std::size_t(h ^ (h >> 32));
+  }
+
+  std::size_t newHash(const StringRef& text) {
+    return std::size_t(collections::hashBytes(text.begin(), text.size()));
+  }
+
+  struct Hasher {
+    const char* name;
+    std::size_t (*fn)(const StringRef& text);
+  };
+
+  const Hasher hashers[] = {
+    { "hash_combine", combineHash },
+    { "fnv-1a", fnvHash },
+    { "hashBytes", newHash },
+  };
+
+  /** Strings hashed together in one timed run. */
+  struct Corpus {
+    std::string name;
+    std::vector<std::string> strings;
+    size_t bytes;
+  };
+
+  /** Collect every identifier in the sources, including repeats, as the compiler sees them. */
+  void collectIdentifiers(const std::vector<support::Path>& files, Corpus& corpus) {
+    for (const support::Path& path : files) {
+      source::FileSource src(path, path.str());
+      parse::Lexer lex(&src);
+      for (parse::TokenType tok = lex.next(); tok != parse::TOKEN_END; tok = lex.next()) {
+        if (tok == parse::TOKEN_ID) {
+          StringRef text = lex.tokenValue();
+          corpus.strings.push_back(std::string(text.begin(), text.end()));
+          corpus.bytes += text.size();
+        }
+      }
+    }
+  }
+
+  /** 'count' strings of 'length' bytes each. */
+  void generateStrings(size_t length, size_t count, Corpus& corpus) {
+    for (size_t i = 0; i < count; ++i) {
+      std::string s(length, 'a');
+      for (size_t j = 0; j < length; ++j) {
+        s[j] = char('a' + (i * 7 + j * 13 + (i >> j % 16)) % 26);
+      }
+      corpus.strings.push_back(s);
+      corpus.bytes += length;
+    }
+  }
+
+  void usage() {
+    std::cerr << "Usage: hashbench [--runs N] [--warmup N] [--json FILE] [paths...]\n";
+    std::exit(1);
+  }
+}
+
+int main(int argc, char** argv) {
+  unsigned runs = 20;
+  unsigned warmup = 3;
+  const char* jsonPath = nullptr;
+  std::vector<support::Path> files;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    if (arg == "--runs" && i + 1 < argc) {
+      runs = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--warmup" && i + 1 < argc) {
+      warmup = std::atoi(argv[++i]);
+    } else if (arg == "--json" && i + 1 < argc) {
+      jsonPath = argv[++i];
+    } else if (!arg.empty() && arg[0] == '-') {
+      usage();
+    } else {
+      bench::collectSources(support::Path(argv[i]), files);
+    }
+  }
+  if (files.empty()) {
+    bench::collectSources(support::Path("lib/spark"), files);
+  }
+
+  std::vector<Corpus> corpora(1);
+  corpora[0].name = "identifiers";
+  corpora[0].bytes = 0;
+  collectIdentifiers(files, corpora[0]);
+  if (corpora[0].strings.empty()) {
+    std::cerr << "No identifiers found.\n";
+    return 1;
+  }
+  for (size_t length : { 8, 16, 32, 64, 256 }) {
+    corpora.push_back(Corpus());
+    corpora.back().name = "length " + std::to_string(length);
+    corpora.back().bytes = 0;
+    generateStrings(length, (1u << 20) / length, corpora.back());
+  }
+
+  std::printf("%zu files, %zu identifiers; %u runs after %u warmup runs\n", files.size(),
+      corpora[0].strings.size(), runs, warmup);
+  bench::JsonResults json("hashbench");
+  for (const Corpus& corpus : corpora) {
+    std::vector<StringRef> refs(corpus.strings.begin(), corpus.strings.end());
+    std::printf("\n%s (%zu strings, %zu bytes):\n", corpus.name.c_str(), refs.size(),
+        corpus.bytes);
+    for (const Hasher& hasher : hashers) {
+      bench::Timing t = bench::measure([&]() {
+        std::size_t sum = 0;
+        for (const StringRef& s : refs) {
+          sum += hasher.fn(s);
+        }
+        bench::keep(sum);
+      }, warmup, runs);
+      std::string name = std::string("  ") + hasher.name;
+      bench::reportRate(name.c_str(), t, corpus.bytes, refs.size(), "str");
+      json.add(corpus.name + "/" + hasher.name, t, corpus.bytes, refs.size());
+    }
+  }
+
+  if (jsonPath != nullptr && !json.write(jsonPath)) {
+    return 1;
+  }
+  return 0;
+}
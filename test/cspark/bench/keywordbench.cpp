@@ -0,0 +1,114 @@
+/* ================================================================== *
+ * Benchmark for keyword recognition: compares the perfect hash used
+ * by the lexer with the std::unordered_map lookup it replaced.
+ *
+ * Usage: keywordbench [paths...]    (default: lib/spark)
+ * ================================================================== */
+
+#include "bench.h"
+#include "spark/collections/hashing.h"
+#include "spark/parse/keywords.h"
+#include "spark/source/programsource.h"
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace spark;
+using collections::StringRef;
+using parse::TokenType;
+
+namespace {
+  typedef std::unordered_map<StringRef, TokenType> KeywordMap;
+
+  TokenType mapLookup(const KeywordMap& map, const StringRef& text) {
+    KeywordMap::const_iterator it = map.find(text);
+    return it != map.end() ? it->second : parse::TOKEN_ID;
+  }
+
+  bool isNameStart(char ch) {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '_';
+  }
+
+  bool isName(char ch) {
+    return isNameStart(ch) || (ch >= '0' && ch <= '9');
+  }
+
+  /** Collect every identifier-like word in 'text'. */
+  void collectWords(StringRef text, std::vector<std::string>& words) {
+    const char* pos = text.begin();
+    while (pos < text.end()) {
+      if (isNameStart(*pos)) {
+        const char* start = pos;
+        while (pos < text.end() && isName(*pos)) {
+          ++pos;
+        }
+        words.push_back(std::string(start, pos));
+      } else {
+        ++pos;
+      }
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  std::vector<support::Path> files;
+  if (argc > 1) {
+    for (int i = 1; i < argc; ++i) {
+      bench::collectSources(support::Path(argv[i]), files);
+    }
+  } else {
+    bench::collectSources(support::Path("lib/spark"), files);
+  }
+
+  std::vector<std::string> words;
+  for (const support::Path& path : files) {
+    source::FileSource src(path, path.str());
+    collectWords(src.content(), words);
+  }
+  if (words.empty()) {
+    std::cerr << "No input words found.\n";
+    return 1;
+  }
+  std::vector<StringRef> refs(words.begin(), words.end());
+
+  KeywordMap map;
+  for (const parse::Keyword& kw : parse::keywords()) {
+    map[StringRef(kw.text, kw.length)] = kw.token;
+  }
+
+  size_t keywordCount = 0;
+  for (const StringRef& word : refs) {
+    TokenType expected = mapLookup(map, word);
+    if (parse::lookupKeyword(word) != expected) {
+      std::cerr << "Mismatch for '" << word << "'\n";
+      return 1;
+    }
+    if (expected != parse::TOKEN_ID) {
+      ++keywordCount;
+    }
+  }
+
+  std::printf("%zu files, %zu words, %zu keywords\n", files.size(), refs.size(), keywordCount);
+
+  bench::Timing mapTime = bench::measure([&]() {
+    unsigned sum = 0;
+    for (const StringRef& word : refs) {
+      sum += mapLookup(map, word);
+    }
+    bench::keep(sum);
+  }, 5, 50);
+
+  bench::Timing hashTime = bench::measure([&]() {
+    unsigned sum = 0;
+    for (const StringRef& word : refs) {
+      sum += parse::lookupKeyword(word);
+    }
+    bench::keep(sum);
+  }, 5, 50);
+
+  bench::report("unordered_map", mapTime, refs.size(), "word");
+  bench::report("perfect hash", hashTime, refs.size(), "word");
+  std::printf("speedup: %.2fx\n", mapTime.median / hashTime.median);
+  return 0;
+}
@@ -0,0 +1,178 @@
+/* ================================================================== *
+ * Benchmark for the lexer: measures throughput over the library
+ * sources and over generated inputs that stress particular paths.
+ *
+ * Usage: lexbench [--runs N] [--warmup N] [--json FILE] [paths...]
+ *   paths      Source trees to lex as the real corpus (default: lib/spark).
+ *   --json     Also write the results as JSON to FILE ('-' for stdout).
+ * ================================================================== */
+
+#include "bench.h"
+#include "spark/parse/lexer.h"
+#include "spark/source/programsource.h"
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace spark;
+using parse::Lexer;
+using parse::TokenType;
+
+namespace {
+  typedef std::vector<std::unique_ptr<source::ProgramSource>> SourceList;
+
+  /** A set of sources that are lexed together. */
+  struct Corpus {
+    std::string name;
+    SourceList sources;
+    size_t bytes;
+    size_t tokens;
+  };
+
+  /** Lex every source in 'corpus', returning the number of tokens. */
+  size_t lexAll(const Corpus& corpus) {
+    size_t count = 0;
+    for (const auto& src : corpus.sources) {
+      Lexer lex(src.get());
+      while (lex.next() != parse::TOKEN_END) {
+        ++count;
+      }
+    }
+    return count;
+  }
+
+  void addSource(Corpus& corpus, const std::string& text) {
+    corpus.sources.emplace_back(new source::StringSource(corpus.name, text));
+    corpus.bytes += text.size();
+  }
+
+  /** Identifiers thousands of characters long. */
+  void genLongIdentifiers(Corpus& corpus) {
+    std::string text;
+    for (unsigned i = 0; i < 2000; ++i) {
+      text.push_back('a' + i % 26);
+      for (unsigned j = 1; j < 2000; ++j) {
+        text.push_back("abcdefghijklmnopqrstuvwxyz_0123456789"[(i + j) % 37]);
+      }
+      text += " ";
+    }
+    addSource(corpus, text);
+  }
+
+  /** Block comments spanning many lines, with comment openers inside them. Block comments don't
+      nest in Spark, so the inner openers are skipped as comment text. */
+  void genBlockComments(Corpus& corpus) {
+    std::string text;
+    for (unsigned i = 0; i < 200; ++i) {
+      text += "/*";
+      for (unsigned j = 0; j < 1000; ++j) {
+        text += " /* nested ";
+        text += (j % 2) ? "*\n" : "\t/\r\n";
+      }
+      text += "*/ x\n";
+    }
+    addSource(corpus, text);
+  }
+
+  /** String literals a megabyte long, with and without escape sequences. */
+  void genHugeStrings(Corpus& corpus) {
+    std::string text;
+    for (unsigned i = 0; i < 8; ++i) {
+      text += "\"";
+      for (unsigned j = 0; j < (1 << 20) / 64; ++j) {
+        text += "the quick brown fox jumps over the lazy dog 0123456789 ABCDEF";
+        text += (i % 2) ? "\\n\\t" : "..";
+      }
+      text += "\";\n";
+    }
+    addSource(corpus, text);
+  }
+
+  /** A million numeric literals in assorted forms. */
+  void genNumbers(Corpus& corpus) {
+    static const char* const forms[] = { "%u", "0x%X", "%u.25", "%ue3", "%uu", "%u.5e-2" };
+    std::string text;
+    char buf[32];
+    for (unsigned i = 0; i < 1000000; ++i) {
+      std::snprintf(buf, sizeof buf, forms[i % 6], i);
+      text += buf;
+      text += (i % 16 == 15) ? ",\n" : ", ";
+    }
+    addSource(corpus, text);
+  }
+
+  void usage() {
+    std::cerr << "Usage: lexbench [--runs N] [--warmup N] [--json FILE] [paths...]\n";
+    std::exit(1);
+  }
+}
+
+int main(int argc, char** argv) {
+  unsigned runs = 10;
+  unsigned warmup = 2;
+  const char* jsonPath = nullptr;
+  std::vector<support::Path> files;
+  bool hasPaths = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    if (arg == "--runs" && i + 1 < argc) {
+      runs = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--warmup" && i + 1 < argc) {
+      warmup = std::atoi(argv[++i]);
+    } else if (arg == "--json" && i + 1 < argc) {
+      jsonPath = argv[++i];
+    } else if (!arg.empty() && arg[0] == '-') {
+      usage();
+    } else {
+      bench::collectSources(support::Path(argv[i]), files);
+      hasPaths = true;
+    }
+  }
+  if (!hasPaths) {
+    bench::collectSources(support::Path("lib/spark"), files);
+  }
+
+  std::vector<std::unique_ptr<Corpus>> corpora;
+  Corpus* lib = new Corpus { "lib", SourceList(), 0, 0 };
+  corpora.emplace_back(lib);
+  for (const support::Path& path : files) {
+    source::FileSource* src = new source::FileSource(path, path.str());
+    lib->sources.emplace_back(src);
+    lib->bytes += src->content().size();
+  }
+  if (lib->bytes == 0) {
+    std::cerr << "No input files found.\n";
+    return 1;
+  }
+
+  typedef void (*Generator)(Corpus&);
+  static const struct { const char* name; Generator gen; } synthetic[] = {
+    { "long-identifiers", genLongIdentifiers },
+    { "block-comments", genBlockComments },
+    { "huge-strings", genHugeStrings },
+    { "numbers", genNumbers },
+  };
+  for (const auto& s : synthetic) {
+    Corpus* corpus = new Corpus { s.name, SourceList(), 0, 0 };
+    s.gen(*corpus);
+    corpora.emplace_back(corpus);
+  }
+
+  std::printf("%zu library files; %u runs after %u warmup runs\n", files.size(), runs, warmup);
+  bench::JsonResults json("lexbench");
+  for (const auto& corpus : corpora) {
+    corpus->tokens = lexAll(*corpus);
+    bench::Timing t = bench::measure([&]() {
+      bench::keep(lexAll(*corpus));
+    }, warmup, runs);
+    bench::reportRate(corpus->name.c_str(), t, corpus->bytes, corpus->tokens, "tok");
+    json.add(corpus->name, t, corpus->bytes, corpus->tokens);
+  }
+
+  if (jsonPath != nullptr && !json.write(jsonPath)) {
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,157 @@
+/* ================================================================== *
+ * Benchmark for parser scaling: parses synthetic modules over a sweep
+ * of sizes, and reports time and arena bytes per input size. Sweeps
+ * whose time or memory grows faster than linearly are flagged.
+ *
+ * Usage: parsebench [--runs N] [--warmup N] [--threshold X] [--json FILE]
+ *                   [workloads...]
+ *   workloads    Names of the workloads to sweep (default: all).
+ *   --threshold  Largest acceptable growth exponent (default: 1.2).
+ *   --json       Also write the results as JSON to FILE ('-' for stdout).
+ * The exit status is 2 if any sweep grows faster than the threshold.
+ * ================================================================== */
+
+#include "bench.h"
+#include "workload.h"
+#include "spark/ast/module.h"
+#include "spark/error/reporter.h"
+#include "spark/parse/parser.h"
+#include "spark/source/programsource.h"
+#include "spark/support/arena.h"
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace spark;
+
+namespace {
+  /** Measurements for one size of a workload. */
+  struct Point {
+    unsigned size;
+    size_t bytes;
+    bench::Timing t;
+    size_t arenaBytes;
+  };
+
+  /** Parse 'src' once, returning the number of errors and the bytes used by the AST. */
+  int parseOnce(source::ProgramSource* src, size_t& arenaBytes) {
+    error::BufferedReporter reporter;
+    support::Arena arena;
+    parse::Parser parser(reporter, src, arena);
+    bench::keep(parser.module());
+    arenaBytes = arena.bytesAllocated();
+    return reporter.errorCount();
+  }
+
+  /** Exponent of the least-squares fit of y = a * x^k over the points. */
+  template<class Fn>
+  double growth(const std::vector<Point>& points, Fn y) {
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (const Point& p : points) {
+      double lx = std::log(double(p.bytes));
+      double ly = std::log(y(p));
+      sx += lx;
+      sy += ly;
+      sxx += lx * lx;
+      sxy += lx * ly;
+    }
+    double n = points.size();
+    return (n * sxy - sx * sy) / (n * sxx - sx * sx);
+  }
+
+  void usage() {
+    std::cerr << "Usage: parsebench [--runs N] [--warmup N] [--threshold X] [--json FILE] "
+        "[workloads...]\n";
+    std::exit(1);
+  }
+}
+
+int main(int argc, char** argv) {
+  unsigned runs = 5;
+  unsigned warmup = 1;
+  double threshold = 1.2;
+  const char* jsonPath = nullptr;
+  std::vector<const bench::Workload*> selected;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    if (arg == "--runs" && i + 1 < argc) {
+      runs = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--warmup" && i + 1 < argc) {
+      warmup = std::atoi(argv[++i]);
+    } else if (arg == "--threshold" && i + 1 < argc) {
+      threshold = std::atof(argv[++i]);
+    } else if (arg == "--json" && i + 1 < argc) {
+      jsonPath = argv[++i];
+    } else if (!arg.empty() && arg[0] == '-') {
+      usage();
+    } else {
+      const bench::Workload* workload = bench::findWorkload(argv[i]);
+      if (workload == nullptr) {
+        std::cerr << "Unknown workload: " << argv[i] << "\n";
+        return 1;
+      }
+      selected.push_back(workload);
+    }
+  }
+  if (selected.empty()) {
+    size_t count;
+    const bench::Workload* all = bench::workloads(count);
+    for (size_t i = 0; i < count; ++i) {
+      selected.push_back(&all[i]);
+    }
+  }
+
+  std::printf("%u runs after %u warmup runs; growth threshold %.2f\n", runs, warmup, threshold);
+  std::printf("%-16s %8s %10s %10s %9s %12s %10s\n",
+      "workload", "N", "bytes", "median ms", "ns/byte", "arena bytes", "arena/byte");
+  bench::JsonResults json("parsebench");
+  std::vector<std::string> flagged;
+  for (const bench::Workload* workload : selected) {
+    std::vector<Point> points;
+    for (unsigned size : workload->sizes) {
+      std::string text;
+      workload->generate(text, size);
+      source::StringSource src(workload->name, text);
+      Point p = { size, text.size(), bench::Timing(), 0 };
+      if (parseOnce(&src, p.arenaBytes) != 0) {
+        std::cerr << "Errors parsing " << workload->name << " at size " << size << ".\n";
+        return 1;
+      }
+      p.t = bench::measure([&src]() {
+        error::BufferedReporter reporter;
+        support::Arena arena;
+        parse::Parser parser(reporter, &src, arena);
+        bench::keep(parser.module());
+      }, warmup, runs);
+      std::printf("%-16s %8u %10zu %10.3f %9.2f %12zu %10.2f\n", workload->name, size, p.bytes,
+          p.t.median * 1e3, p.t.median * 1e9 / p.bytes, p.arenaBytes,
+          double(p.arenaBytes) / p.bytes);
+      json.add(std::string(workload->name) + "/" + std::to_string(size), p.t, p.bytes, size);
+      points.push_back(p);
+    }
+
+    double timeGrowth = growth(points, [](const Point& p) { return p.t.median; });
+    double memGrowth = growth(points, [](const Point& p) { return double(p.arenaBytes); });
+    bool superLinear = timeGrowth > threshold || memGrowth > threshold;
+    std::printf("%-16s growth: time ~ n^%.2f, arena ~ n^%.2f%s\n\n", workload->name,
+        timeGrowth, memGrowth, superLinear ? "  ** SUPER-LINEAR **" : "");
+    if (superLinear) {
+      flagged.push_back(workload->name);
+    }
+  }
+
+  if (jsonPath != nullptr && !json.write(jsonPath)) {
+    return 1;
+  }
+  if (!flagged.empty()) {
+    std::printf("Super-linear growth in:");
+    for (const std::string& name : flagged) {
+      std::printf(" %s", name.c_str());
+    }
+    std::printf("\n");
+    return 2;
+  }
+  return 0;
+}
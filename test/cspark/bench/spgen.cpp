@@ -0,0 +1,81 @@
+/* ================================================================== *
+ * Generator for synthetic Spark modules, for reproducing parser
+ * performance problems outside of the benchmarks.
+ *
+ * Usage: spgen [-o FILE] WORKLOAD SIZE
+ *        spgen --list
+ *   WORKLOAD   Shape of module to generate (see --list).
+ *   SIZE       Size parameter N for the workload.
+ *   -o         Write the module to FILE instead of stdout.
+ * ================================================================== */
+
+#include "workload.h"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace spark;
+
+namespace {
+  void usage() {
+    std::cerr << "Usage: spgen [-o FILE] WORKLOAD SIZE\n";
+    std::cerr << "       spgen --list\n";
+    std::exit(1);
+  }
+
+  void list() {
+    size_t count;
+    const bench::Workload* all = bench::workloads(count);
+    for (size_t i = 0; i < count; ++i) {
+      std::printf("%-16s %s\n", all[i].name, all[i].description);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  const char* outPath = nullptr;
+  const char* name = nullptr;
+  const char* size = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    if (arg == "--list") {
+      list();
+      return 0;
+    } else if (arg == "-o" && i + 1 < argc) {
+      outPath = argv[++i];
+    } else if (!arg.empty() && arg[0] == '-') {
+      usage();
+    } else if (name == nullptr) {
+      name = argv[i];
+    } else if (size == nullptr) {
+      size = argv[i];
+    } else {
+      usage();
+    }
+  }
+  if (name == nullptr || size == nullptr) {
+    usage();
+  }
+
+  const bench::Workload* workload = bench::findWorkload(name);
+  if (workload == nullptr) {
+    std::cerr << "Unknown workload: " << name << "\n";
+    return 1;
+  }
+  std::string text;
+  workload->generate(text, std::strtoul(size, nullptr, 10));
+
+  std::FILE* out = stdout;
+  if (outPath != nullptr) {
+    out = std::fopen(outPath, "w");
+    if (out == nullptr) {
+      std::perror(outPath);
+      return 1;
+    }
+  }
+  std::fwrite(text.data(), 1, text.size(), out);
+  if (out != stdout) {
+    std::fclose(out);
+  }
+  return 0;
+}
@@ -0,0 +1,123 @@
+/* ================================================================== *
+ * Synthetic Spark workloads: generators for modules of a given shape
+ * and size, of the kind that machine-generated code tends to produce.
+ * ================================================================== */
+
+#ifndef SPARK_BENCH_WORKLOAD_H
+#define SPARK_BENCH_WORKLOAD_H 1
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace spark {
+namespace bench {
+
+/** Append 'level' levels of indentation. Indentation stops growing past a few levels, so
+    that deeply nested inputs don't grow quadratically in size. */
+inline void indent(std::string& out, unsigned level) {
+  out.append(2 * std::min(level, 8u), ' ');
+}
+
+/** An enum with 'size' values, some with initializers. */
+inline void genEnumValues(std::string& out, unsigned size) {
+  char buf[64];
+  out += "enum Generated {\n";
+  for (unsigned i = 0; i < size; ++i) {
+    if (i % 4 == 0) {
+      std::snprintf(buf, sizeof buf, "  VALUE_%u = %u,\n", i, i * 2);
+    } else {
+      std::snprintf(buf, sizeof buf, "  VALUE_%u,\n", i);
+    }
+    out += buf;
+  }
+  out += "}\n";
+}
+
+/** 'size' overloads of the same function, differing in their parameter types. */
+inline void genOverloads(std::string& out, unsigned size) {
+  static const char* const types[] = {
+    "i32", "i64", "u8", "bool", "String", "Array[i32]", "HashMap[String, i32]",
+    "fn (i32) -> bool", "const String", "Object?",
+  };
+  const unsigned numTypes = sizeof types / sizeof types[0];
+  char buf[128];
+  for (unsigned i = 0; i < size; ++i) {
+    std::snprintf(buf, sizeof buf, "def convert(a: %s, b: %s, c: i32) -> i32 => c + %u;\n",
+        types[i % numTypes], types[(i / numTypes) % numTypes], i);
+    out += buf;
+  }
+}
+
+/** A hundred functions whose bodies are 'if' statements nested 'size' levels deep. */
+inline void genNestedBlocks(std::string& out, unsigned size) {
+  char buf[64];
+  for (unsigned f = 0; f < 100; ++f) {
+    std::snprintf(buf, sizeof buf, "def nested%u(x: i32) -> i32 {\n", f);
+    out += buf;
+    for (unsigned level = 1; level <= size; ++level) {
+      indent(out, level);
+      std::snprintf(buf, sizeof buf, "if x > %u {\n", level);
+      out += buf;
+    }
+    indent(out, size + 1);
+    out += "return x;\n";
+    for (unsigned level = size; level >= 1; --level) {
+      indent(out, level);
+      out += "}\n";
+    }
+    out += "  return 0;\n}\n";
+  }
+}
+
+/** A function returning a literal list of 'size' elements. The language has no array
+    literal syntax yet, so this is a tuple, which the parser builds the same way. */
+inline void genLongList(std::string& out, unsigned size) {
+  char buf[32];
+  out += "def table() {\n  return (";
+  for (unsigned i = 0; i < size; ++i) {
+    std::snprintf(buf, sizeof buf, i % 16 == 15 ? "%u,\n    " : "%u, ", i * 7 % 1000);
+    out += buf;
+  }
+  out += "0);\n}\n";
+}
+
+/** A kind of synthetic module, and the sizes to generate it at by default. */
+struct Workload {
+  const char* name;
+  const char* description;
+  void (*generate)(std::string& out, unsigned size);
+  unsigned sizes[5];
+};
+
+/** All of the synthetic workloads. */
+inline const Workload* workloads(size_t& count) {
+  static const Workload all[] = {
+    { "enum-values", "enum with N values", genEnumValues, { 1000, 2000, 4000, 8000, 16000 } },
+    { "overloads", "N overloads of one function", genOverloads,
+        { 500, 1000, 2000, 4000, 8000 } },
+    { "nested-blocks", "100 functions with 'if' nested N deep", genNestedBlocks,
+        { 25, 50, 100, 200, 400 } },
+    { "long-list", "list literal with N elements", genLongList,
+        { 2500, 5000, 10000, 20000, 40000 } },
+  };
+  count = sizeof all / sizeof all[0];
+  return all;
+}
+
+/** Look up a workload by name, or return null if there is none. */
+inline const Workload* findWorkload(const char* name) {
+  size_t count;
+  const Workload* all = workloads(count);
+  for (size_t i = 0; i < count; ++i) {
+    if (std::strcmp(all[i].name, name) == 0) {
+      return &all[i];
+    }
+  }
+  return nullptr;
+}
+
+}}
+
+#endif
@@ -0,0 +1,132 @@
+/* ================================================================== *
+ * Unit test for spark::support::Arena
+ * ================================================================== */
+
+#include "gtest/gtest.h"
+#include "spark/support/arena.h"
+
+namespace spark {
+namespace support {
+
+TEST(ArenaTest, Stats) {
+  Arena arena("test", 1024);
+  EXPECT_STREQ("test", arena.name());
+  EXPECT_EQ(0u, arena.stats().blocks);
+
+  arena.allocate(5);
+  EXPECT_EQ(5u, arena.stats().requested);
+  EXPECT_EQ(8u, arena.stats().allocated);
+  EXPECT_EQ(1u, arena.stats().blocks);
+  EXPECT_EQ(1024u, arena.stats().reserved);
+  EXPECT_EQ(0u, arena.stats().wasted);
+
+  // Doesn't fit in what is left of the first block, so that space is abandoned.
+  size_t left = 1024 - 8 - 8;
+  arena.allocate(left - 104);
+  arena.allocate(200);
+  EXPECT_EQ(2u, arena.stats().blocks);
+  EXPECT_EQ(104u, arena.stats().wasted);
+  EXPECT_EQ(0u, arena.stats().oversized);
+
+  // Too large for a standard block.
+  arena.allocate(4000);
+  EXPECT_EQ(3u, arena.stats().blocks);
+  EXPECT_EQ(1u, arena.stats().oversized);
+  EXPECT_EQ(1024u * 2 + 4000 + 8, arena.stats().reserved);
+  EXPECT_EQ(5u + (left - 104) + 200 + 4000, arena.stats().requested);
+
+  arena.clear();
+  EXPECT_EQ(0u, arena.stats().blocks);
+  EXPECT_EQ(0u, arena.stats().requested);
+}
+
+TEST(ArenaTest, Alignment) {
+  Arena arena;
+  arena.allocate(8);
+  for (std::size_t align : { 16u, 64u, 4096u }) {
+    uint8_t* p = arena.allocate(24, align);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(p) % align) << align;
+    uint8_t* q = arena.allocate(1);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(q) % 8) << align;
+  }
+
+  // Alignment larger than a block can hold goes to a block of its own.
+  Arena other;
+  uint8_t* big = other.allocate(64, 0x10000);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(big) % 0x10000);
+  EXPECT_EQ(1u, other.stats().oversized);
+}
+
+TEST(ArenaTest, LargeAllocations) {
+  Arena arena("test", 1024);
+  uint8_t* a = arena.allocate(16);
+
+  // A large allocation doesn't displace the current block, so the next small allocation
+  // follows on from the last one.
+  arena.allocate(2000);
+  uint8_t* b = arena.allocate(16);
+  EXPECT_EQ(a + 16, b);
+  EXPECT_EQ(0u, arena.stats().wasted);
+  EXPECT_EQ(1u, arena.stats().oversized);
+  EXPECT_EQ(2u, arena.stats().blocks);
+}
+
+TEST(ArenaTest, RecycleBlocks) {
+  {
+    Arena arena;
+    arena.allocate(100);
+  }
+  // The block freed above is reused.
+  Arena arena;
+  arena.allocate(100);
+  EXPECT_EQ(1u, arena.stats().blocks);
+  EXPECT_EQ(1u, arena.stats().recycled);
+
+  // Arenas with other block sizes don't share blocks.
+  Arena small(1024);
+  small.allocate(100);
+  EXPECT_EQ(0u, small.stats().recycled);
+}
+
+TEST(ArenaTest, Rollback) {
+  Arena arena("test", 1024);
+  uint8_t* a = arena.allocate(16);
+  Arena::Mark m = arena.mark();
+  arena.allocate(16);
+  arena.allocate(2000);
+  for (int i = 0; i < 5; ++i) {
+    arena.allocate(200);
+  }
+  EXPECT_EQ(3u, arena.stats().blocks);
+  arena.rollback(m);
+
+  // Everything since the mark is freed, and allocation carries on from the mark.
+  EXPECT_EQ(1u, arena.stats().blocks);
+  EXPECT_EQ(16u, arena.stats().requested);
+  EXPECT_EQ(0u, arena.stats().oversized);
+  EXPECT_EQ(a + 16, arena.allocate(8));
+}
+
+TEST(ArenaTest, Checkpoint) {
+  Arena arena;
+  arena.allocate(8);
+  {
+    ArenaCheckpoint checkpoint(arena);
+    arena.allocate(100);
+  }
+  EXPECT_EQ(8u, arena.bytesAllocated());
+  {
+    ArenaCheckpoint outer(arena);
+    arena.allocate(100);
+    {
+      ArenaCheckpoint inner(arena);
+      arena.allocate(100);
+      inner.keep();
+    }
+    EXPECT_EQ(216u, arena.bytesAllocated());
+    outer.keep();
+  }
+  EXPECT_EQ(216u, arena.bytesAllocated());
+}
+
+}}
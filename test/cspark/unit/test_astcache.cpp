@@ -0,0 +1,215 @@
+/* ================================================================== *
+ * Unit test for spark::compiler::AstCache
+ * ================================================================== */
+
+#include "gtest/gtest.h"
+#include "spark/ast/defn.h"
+#include "spark/ast/module.h"
+#include "spark/compiler/astcache.h"
+#include "spark/parse/parser.h"
+#include "spark/source/sourcemanager.h"
+#include "mocks.h"
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+
+namespace spark {
+namespace compiler {
+using spark::error::MockReporter;
+
+static const char* const SOURCE =
+    "import spark.core.Object;\n"
+    "\n"
+    "class Point {\n"
+    "  var x: i32 = 0;\n"
+    "  let name: String = \"point\";\n"
+    "  def length[T](scale: f64, args: T...) -> f64 {\n"
+    "    if x > 0 and x != 3 { return 1.5 * scale; }\n"
+    "    match scale {\n"
+    "      n: i32 => { return 1.0; }\n"
+    "      else => { return 0.0; }\n"
+    "    }\n"
+    "    let c = 'c';\n"
+    "    while x < 10 { x += 2; }\n"
+    "    return -(f(x, a = 1) + 0x10u);\n"
+    "  }\n"
+    "}\n";
+
+class AstCacheTest : public testing::Test {
+protected:
+  virtual void SetUp() {
+    char dir[] = "/tmp/astcacheXXXXXX";
+    ASSERT_TRUE(::mkdtemp(dir) != nullptr);
+    _dir = dir;
+  }
+
+  virtual void TearDown() {
+    support::PathIterator iter = _dir.iterate();
+    collections::StringRef name;
+    std::vector<support::Path> entries;
+    while (iter.next(name)) {
+      if (name != "." && name != "..") {
+        entries.push_back(support::Path(_dir, name));
+      }
+    }
+    for (const support::Path& entry : entries) {
+      ::unlink(entry.c_str());
+    }
+    ::rmdir(_dir.c_str());
+  }
+
+  support::Path _dir;
+  support::Arena _arena;
+  MockReporter _reporter;
+  std::vector<std::unique_ptr<source::StringSource>> _sources;
+
+  source::StringSource* addSource(const char* text) {
+    _sources.emplace_back(new source::StringSource("test.sp", text));
+    return _sources.back().get();
+  }
+
+  const ast::Module* parse(source::StringSource* src, bool deferBodies = false) {
+    parse::Parser parser(_reporter, src, _arena);
+    parser.setDeferBodies(deferBodies);
+    return parser.module();
+  }
+
+  std::string readFile(const support::Path& path) {
+    std::ifstream strm(path.c_str(), std::ios::in | std::ios::binary);
+    std::stringstream contents;
+    contents << strm.rdbuf();
+    return contents.str();
+  }
+};
+
+TEST_F(AstCacheTest, RoundTrip) {
+  AstCache cache(_dir);
+  source::StringSource* src = addSource(SOURCE);
+  const ast::Module* mod = parse(src);
+  ASSERT_TRUE(mod != nullptr);
+  ASSERT_TRUE(cache.store(src, false, mod));
+  std::string entry = readFile(cache.entryPath(src, false));
+  EXPECT_FALSE(entry.empty());
+
+  // Load the entry for a second copy of the same text, which is placed elsewhere in the
+  // source manager's offset space.
+  source::StringSource* copy = addSource(SOURCE);
+  support::Arena arena;
+  const ast::Module* loaded = cache.load(copy, false, arena);
+  ASSERT_TRUE(loaded != nullptr);
+  ASSERT_EQ(1u, loaded->imports().size());
+  ASSERT_EQ(1u, loaded->members().size());
+  auto cls = static_cast<const ast::TypeDefn*>(loaded->members()[0]);
+  EXPECT_EQ(ast::Kind::CLASS_DEFN, cls->kind());
+  EXPECT_TRUE(cls->name() == "Point");
+  ASSERT_EQ(3u, cls->members().size());
+  auto fn = static_cast<const ast::Function*>(cls->members()[2]);
+  ASSERT_EQ(ast::Kind::FUNCTION, fn->kind());
+  EXPECT_EQ(2u, fn->params().size());
+  EXPECT_EQ(1u, fn->typeParams().size());
+  EXPECT_EQ(ast::Kind::BLOCK, fn->body()->kind());
+
+  // Locations are relative to the new copy, and decode to the same place.
+  EXPECT_NE(fn->location().begin, static_cast<const ast::TypeDefn*>(
+      mod->members()[0])->members()[2]->location().begin);
+  source::DecodedLocation dloc;
+  ASSERT_TRUE(source::SourceManager::get().decode(fn->location(), dloc));
+  EXPECT_EQ(6u, dloc.startLine);
+
+  // Storing the loaded tree produces an identical entry.
+  ASSERT_TRUE(cache.store(copy, false, loaded));
+  EXPECT_EQ(entry, readFile(cache.entryPath(copy, false)));
+}
+
+TEST_F(AstCacheTest, Validation) {
+  AstCache cache(_dir);
+  source::StringSource* src = addSource(SOURCE);
+  ASSERT_TRUE(cache.store(src, false, parse(src)));
+
+  // Entries with and without function bodies are separate.
+  EXPECT_TRUE(cache.load(src, true, _arena) == nullptr);
+  ASSERT_TRUE(cache.store(src, true, parse(src, true)));
+  auto mod = cache.load(src, true, _arena);
+  ASSERT_TRUE(mod != nullptr);
+  auto cls = static_cast<const ast::TypeDefn*>(mod->members()[0]);
+  auto fn = static_cast<const ast::Function*>(cls->members()[2]);
+  EXPECT_EQ(ast::Kind::DEFERRED_BODY, fn->body()->kind());
+
+  // Different text has a different entry.
+  std::string changed(SOURCE);
+  changed[changed.find("1.5")] = '2';
+  EXPECT_TRUE(cache.load(addSource(changed.c_str()), false, _arena) == nullptr);
+
+  // A damaged entry is ignored.
+  support::Path path = cache.entryPath(src, false);
+  std::string entry = readFile(path);
+  {
+    std::ofstream out(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    out.write(entry.data(), entry.size() - 8);
+  }
+  EXPECT_TRUE(cache.load(src, false, _arena) == nullptr);
+
+  // Damage in the middle may or may not be detected, but must not crash.
+  {
+    entry[entry.size() / 2] ^= 0x55;
+    entry[entry.size() / 2 + 4] ^= 0x55;
+    std::ofstream out(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    out.write(entry.data(), entry.size());
+  }
+  cache.load(src, false, _arena);
+}
+
+TEST_F(AstCacheTest, LocationsInRange) {
+  // An empty string is stored with no text after its length.
+  AstCache cache(_dir);
+  source::StringSource* src = addSource("let a: String = \"\";\nlet b: i32 = 1;\n");
+  ASSERT_TRUE(cache.store(src, false, parse(src)));
+  ASSERT_TRUE(cache.load(src, false, _arena) != nullptr);
+
+  support::Path path = cache.entryPath(src, false);
+  std::string entry = readFile(path);
+  ASSERT_EQ(0u, entry.size() % 4);
+  std::vector<uint32_t> original(entry.size() / 4);
+  std::memcpy(original.data(), entry.data(), entry.size());
+  auto loadWith = [&](const std::vector<uint32_t>& words) {
+    std::ofstream out(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(words.data()), words.size() * 4);
+    out.close();
+    return cache.load(src, false, _arena);
+  };
+
+  // The entry is an 11-word header, then the strings, then the node records. Each node record
+  // starts with its kind, its offset plus one, and its length.
+  const uint32_t size = uint32_t(src->content().size());
+  size_t pos = 11;
+  for (uint32_t i = 0; i < original[8]; ++i) {
+    pos += 1 + (original[pos] + 3) / 4;
+  }
+  ASSERT_LT(pos + 2, original.size());
+  ASSERT_NE(0u, original[pos + 1]);
+  // Nothing is left behind in the arena by entries that are rejected.
+  std::size_t used = _arena.bytesAllocated();
+  std::vector<uint32_t> words = original;
+  words[pos + 1] = size + 2;
+  EXPECT_TRUE(loadWith(words) == nullptr);
+  EXPECT_EQ(used, _arena.bytesAllocated());
+  words = original;
+  words[pos + 2] = size - original[pos + 1] + 2;
+  EXPECT_TRUE(loadWith(words) == nullptr);
+
+  // The module comes last, and ends with the spans of its members.
+  words = original;
+  words.back() = size + 1;
+  EXPECT_TRUE(loadWith(words) == nullptr);
+  words.back() = words[words.size() - 2] - 1;
+  EXPECT_TRUE(loadWith(words) == nullptr);
+  EXPECT_EQ(used, _arena.bytesAllocated());
+  EXPECT_TRUE(loadWith(original) != nullptr);
+  EXPECT_LT(used, _arena.bytesAllocated());
+}
+
+}}
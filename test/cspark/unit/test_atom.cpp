@@ -0,0 +1,71 @@
+/* ================================================================== *
+ * Unit test for spark::collections::Atom
+ * ================================================================== */
+
+#include "gtest/gtest.h"
+#include "spark/collections/atom.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace spark {
+namespace collections {
+
+TEST(AtomTest, Intern) {
+  std::string text("atomTestIntern");
+  Atom a0 = Atom::intern("atomTestIntern");
+  Atom a1 = Atom::intern(text);
+  EXPECT_EQ(a0, a1);
+  EXPECT_EQ(a0.c_str(), a1.c_str());
+  EXPECT_EQ(a0.hash(), a1.hash());
+  EXPECT_EQ(14u, a0.size());
+  EXPECT_EQ(StringRef("atomTestIntern"), a0.str());
+  EXPECT_TRUE(a0 == StringRef("atomTestIntern"));
+  EXPECT_NE(a0, Atom::intern("atomTestIntern2"));
+}
+
+TEST(AtomTest, Empty) {
+  Atom a;
+  EXPECT_TRUE(a.isNull());
+  EXPECT_TRUE(a.empty());
+  EXPECT_EQ(a, Atom::intern(""));
+  EXPECT_STREQ("", a.c_str());
+}
+
+TEST(AtomTest, Find) {
+  // Atoms are never freed, so use a new name each time the test is repeated.
+  static int runs = 0;
+  std::string name = "atomTestFind" + std::to_string(runs++);
+  EXPECT_TRUE(Atom::find(name).isNull());
+  Atom a = Atom::intern(name);
+  EXPECT_EQ(a, Atom::find(name));
+}
+
+TEST(AtomTest, Threads) {
+  // Intern overlapping sets of names from several threads, enough to force the table to grow.
+  static const unsigned NUM_THREADS = 4;
+  static const unsigned NUM_NAMES = 5000;
+  std::vector<std::vector<Atom>> results(NUM_THREADS);
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < NUM_THREADS; ++t) {
+    threads.push_back(std::thread([t, &results]() {
+      for (unsigned i = 0; i < NUM_NAMES; ++i) {
+        results[t].push_back(Atom::intern("atomThread" + std::to_string(i)));
+      }
+    }));
+  }
+  for (std::thread& th : threads) {
+    th.join();
+  }
+  for (unsigned i = 0; i < NUM_NAMES; ++i) {
+    std::string name = "atomThread" + std::to_string(i);
+    Atom expected = Atom::find(name);
+    ASSERT_FALSE(expected.isNull());
+    EXPECT_EQ(StringRef(name), expected.str());
+    for (unsigned t = 0; t < NUM_THREADS; ++t) {
+      EXPECT_EQ(expected, results[t][i]);
+    }
+  }
+}
+
+}}
@@ -0,0 +1,139 @@
+/* ================================================================== *
+ * Unit test for spark::compiler::Compiler
+ * ================================================================== */
+
+#include "gtest/gtest.h"
+#include "spark/ast/defn.h"
+#include "spark/ast/module.h"
+#include "spark/compiler/compiler.h"
+#include "spark/semgraph/module.h"
+#include "spark/source/programsource.h"
+#include "spark/source/sourcemanager.h"
+#include <cstdio>
+#include <fstream>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace spark {
+namespace compiler {
+
+namespace {
+  /** Reporter that keeps each message along with the file position it refers to. */
+  class RecordingReporter : public error::IndentingReporter {
+  public:
+    RecordingReporter() : _errorCount(0) {}
+
+    void report(error::Severity sev, source::Location loc, StringRef msg) {
+      if (sev == error::ERROR || sev == error::FATAL) {
+        _errorCount += 1;
+      }
+      // Decode now, since the file may not outlive the compiler.
+      std::string text = std::to_string(int(sev)) + " ";
+      source::DecodedLocation dloc;
+      if (source::SourceManager::get().decode(loc, dloc)) {
+        text += dloc.source->path().str() + ":" + std::to_string(dloc.startLine) + ":" +
+            std::to_string(dloc.startCol) + " ";
+      }
+      text.append(msg.begin(), msg.end());
+      messages.push_back(text);
+    }
+
+    int errorCount() const { return _errorCount; }
+
+    std::vector<std::string> messages;
+
+  private:
+    int _errorCount;
+  };
+
+  /** What a compilation produced. */
+  struct Result {
+    std::vector<std::string> messages;
+    std::vector<std::string> modules;
+  };
+}
+
+class CompilerTest : public testing::Test {
+protected:
+  virtual void SetUp() {
+    char dir[] = "/tmp/compilerXXXXXX";
+    ASSERT_TRUE(::mkdtemp(dir) != nullptr);
+    _dir = dir;
+  }
+
+  virtual void TearDown() {
+    for (auto it = _files.rbegin(); it != _files.rend(); ++it) {
+      ::unlink(it->c_str());
+    }
+    for (auto it = _dirs.rbegin(); it != _dirs.rend(); ++it) {
+      ::rmdir(it->c_str());
+    }
+    ::rmdir(_dir.c_str());
+  }
+
+  std::string _dir;
+  std::vector<std::string> _files;
+  std::vector<std::string> _dirs;
+
+  void addDir(const std::string& name) {
+    _dirs.push_back(_dir + "/" + name);
+    ASSERT_EQ(0, ::mkdir(_dirs.back().c_str(), 0755));
+  }
+
+  void addFile(const std::string& name, const std::string& text) {
+    _files.push_back(_dir + "/" + name);
+    std::ofstream out(_files.back().c_str());
+    out << text;
+  }
+
+  Result compile(unsigned jobs) {
+    RecordingReporter reporter;
+    Compiler compiler(reporter);
+    compiler.setSourceRoot(_dir);
+    compiler.addSource(_dir);
+    compiler.setJobs(jobs);
+    compiler.compile();
+
+    Result result;
+    result.messages = reporter.messages;
+    for (const semgraph::Module* mod : compiler.sourceModules()) {
+      std::string text = mod->qualifiedName();
+      for (const ast::Node* member : static_cast<const ast::Module*>(mod->ast())->members()) {
+        text += " ";
+        text += static_cast<const ast::Defn*>(member)->name().c_str();
+      }
+      result.modules.push_back(text);
+    }
+    return result;
+  }
+};
+
+TEST_F(CompilerTest, JobsMatchSerial) {
+  // Enough bad files that compilation stops partway through the list.
+  addDir("a");
+  addDir("b");
+  char name[32];
+  for (int i = 0; i < 30; ++i) {
+    std::snprintf(name, sizeof name, "%s/m%02d.sp", i % 3 == 0 ? "a" : "b", i);
+    if (i % 2 == 0) {
+      addFile(name, "class C" + std::to_string(i) + " {\n  var x: i32 = " +
+          std::to_string(i) + ";\n}\n");
+    } else {
+      addFile(name, "class D {\n  def f() -> i32 { return " + std::to_string(i) + " +; }\n}\n");
+    }
+  }
+
+  Result serial = compile(1);
+  ASSERT_GT(serial.messages.size(), 10u);
+  EXPECT_LT(serial.messages.size(), 15u);
+  EXPECT_FALSE(serial.modules.empty());
+
+  Result parallel = compile(4);
+  EXPECT_EQ(serial.messages, parallel.messages);
+  EXPECT_EQ(serial.modules, parallel.modules);
+}
+
+}}
@@ -0,0 +1,79 @@
+/* ================================================================== *
+ * Unit test for spark::semgraph::Defn lazy scopes
+ * ================================================================== */
+
+#include "gtest/gtest.h"
+#include "spark/scope/scopestack.h"
+#include "spark/scope/stdscope.h"
+#include "spark/semgraph/defn.h"
+#include "spark/support/arena.h"
+
+namespace spark {
+namespace semgraph {
+
+namespace {
+  /** Counts the names passed to it. */
+  class CountNames : public scope::NameFunctor {
+  public:
+    CountNames() : count(0) {}
+    void operator()(const StringRef& name) { ++count; }
+    int count;
+  };
+}
+
+TEST(DefnTest, NoScopesUntilNeeded) {
+  support::Arena arena("semgraph");
+  Function* fn = new (arena) Function(source::Location(), "f");
+  std::size_t size = arena.bytesAllocated();
+  EXPECT_GE(size, sizeof(Function));
+
+  // A function without parameters or type parameters has no scopes at all.
+  EXPECT_TRUE(fn->paramScope() == nullptr);
+  EXPECT_TRUE(fn->typeParamScope() == nullptr);
+  EXPECT_TRUE(fn->requiredMethodScope() == nullptr);
+  EXPECT_EQ(size, arena.bytesAllocated());
+
+  // Pushing them stands in the empty scope, which finds nothing.
+  scope::ScopeStack stack;
+  stack.push(fn->typeParamScope());
+  stack.push(fn->paramScope());
+  ASSERT_EQ(2u, stack.size());
+  EXPECT_EQ(scope::EmptyScope::get(), stack.entries()[0].scope);
+  EXPECT_EQ(scope::EmptyScope::get(), stack.entries()[1].scope);
+  EXPECT_TRUE(stack.find(collections::Atom::intern("f")).members.empty());
+  CountNames names;
+  stack.forAllNames(names);
+  EXPECT_EQ(0, names.count);
+}
+
+TEST(DefnTest, LazyScopeCreatedOnce) {
+  support::Arena arena("semgraph");
+  support::Arena other("other");
+  Function* fn = new (arena) Function(source::Location(), "f");
+  Property* prop = new (arena) Property(source::Location(), "p");
+  std::size_t size = arena.bytesAllocated();
+
+  // The first call creates the scope in the given arena; later calls return the same one.
+  scope::StandardScope* params = fn->paramScope(arena);
+  ASSERT_TRUE(params != nullptr);
+  EXPECT_EQ(params, fn->paramScope());
+  std::size_t afterParams = arena.bytesAllocated();
+  EXPECT_GE(afterParams - size, sizeof(scope::StandardScope));
+  EXPECT_EQ(params, fn->paramScope(other));
+  EXPECT_EQ(params, fn->paramScope(arena));
+  EXPECT_EQ(afterParams, arena.bytesAllocated());
+  EXPECT_EQ(0u, other.bytesAllocated());
+
+  // Each kind of scope is separate.
+  scope::StandardScope* typeParams = fn->typeParamScope(arena);
+  EXPECT_NE(params, typeParams);
+  EXPECT_EQ(typeParams, fn->typeParamScope(arena));
+  EXPECT_TRUE(fn->requiredMethodScope() == nullptr);
+  EXPECT_TRUE(prop->paramScope() == nullptr);
+  scope::StandardScope* propParams = prop->paramScope(arena);
+  EXPECT_EQ(propParams, prop->paramScope(arena));
+  EXPECT_NE(params, propParams);
+  EXPECT_EQ(0u, other.bytesAllocated());
+}
+
+}}
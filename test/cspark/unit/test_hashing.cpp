@@ -0,0 +1,124 @@
+/* ================================================================== *
+ * Unit test for spark::collections::hashBytes
+ * ================================================================== */
+
+#include "gtest/gtest.h"
+#include "spark/collections/hashing.h"
+#include "spark/parse/lexer.h"
+#include "spark/source/programsource.h"
+#include "spark/support/path.h"
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#ifndef SPARK_SOURCE_DIR
+  #define SPARK_SOURCE_DIR "."
+#endif
+
+namespace spark {
+namespace collections {
+
+namespace {
+  /** Recursively collect the distinct identifiers in the Spark sources under 'path'. */
+  void collectIdentifiers(const support::Path& path, std::unordered_set<std::string>& result) {
+    if (path.isDir()) {
+      StringRef name;
+      support::PathIterator it = path.iterate();
+      while (it.next(name)) {
+        if (name != "." && name != "..") {
+          collectIdentifiers(support::Path(path, name), result);
+        }
+      }
+    } else if (path.isFile() && path.suffix() == ".sp") {
+      source::FileSource src(path, path.str());
+      parse::Lexer lex(&src);
+      for (parse::TokenType tok = lex.next(); tok != parse::TOKEN_END; tok = lex.next()) {
+        if (tok == parse::TOKEN_ID) {
+          result.insert(std::string(lex.tokenValue().begin(), lex.tokenValue().end()));
+        }
+      }
+    }
+  }
+
+  /** Check that the hashes of 'keys' look like random numbers: no two are equal, and the
+      number of pairs sharing the same low bits is about what a random function would give. */
+  void checkCollisions(const std::vector<std::string>& keys, uint64_t seed) {
+    std::unordered_map<uint64_t, const std::string*> seen;
+    for (const std::string& key : keys) {
+      uint64_t h = hashBytes(key.data(), key.size(), seed);
+      auto result = seen.insert(std::make_pair(h, &key));
+      EXPECT_TRUE(result.second) << "'" << key << "' and '" << *result.first->second <<
+          "' have the same hash.";
+    }
+
+    // Low bits are what hash tables use to pick a bucket.
+    for (unsigned bits : { 8u, 12u, 16u }) {
+      std::vector<uint32_t> buckets(size_t(1) << bits);
+      for (const std::string& key : keys) {
+        ++buckets[hashBytes(key.data(), key.size(), seed) & (buckets.size() - 1)];
+      }
+      double pairs = 0;
+      for (uint32_t count : buckets) {
+        pairs += double(count) * (count - 1) / 2;
+      }
+      double n = keys.size();
+      double expected = n * (n - 1) / 2 / buckets.size();
+      EXPECT_LT(pairs, expected * 1.25 + 10) << bits << " bits, seed " << seed;
+      EXPECT_GT(pairs, expected * 0.75 - 10) << bits << " bits, seed " << seed;
+    }
+  }
+}
+
+TEST(HashingTest, Deterministic) {
+  std::string text("hashingTestDeterministic");
+  EXPECT_EQ(hashBytes(text.data(), text.size()), hashBytes(text.data(), text.size()));
+  EXPECT_EQ(std::hash<StringRef>()(StringRef(text)),
+      std::hash<StringRef>()(StringRef("hashingTestDeterministic")));
+  EXPECT_NE(hashBytes(text.data(), text.size(), 0), hashBytes(text.data(), text.size(), 1));
+  EXPECT_NE(hashBytes("", 0), hashBytes("a", 1));
+}
+
+TEST(HashingTest, EveryByteMatters) {
+  // Flipping any bit of any byte changes the hash, for every length that takes a different
+  // path through the function.
+  uint8_t buf[100];
+  for (size_t i = 0; i < sizeof buf; ++i) {
+    buf[i] = uint8_t(i * 37 + 11);
+  }
+  for (size_t len = 1; len <= sizeof buf; ++len) {
+    uint64_t h = hashBytes(buf, len);
+    for (size_t i = 0; i < len; ++i) {
+      for (unsigned bit = 0; bit < 8; ++bit) {
+        buf[i] ^= 1 << bit;
+        EXPECT_NE(h, hashBytes(buf, len)) << "length " << len << ", byte " << i;
+        buf[i] ^= 1 << bit;
+      }
+    }
+  }
+}
+
+TEST(HashingTest, LibraryIdentifiers) {
+  std::unordered_set<std::string> identifiers;
+  collectIdentifiers(support::Path(SPARK_SOURCE_DIR "/lib/spark"), identifiers);
+  ASSERT_GT(identifiers.size(), 100u) << "Spark library sources not found.";
+  std::vector<std::string> keys(identifiers.begin(), identifiers.end());
+  checkCollisions(keys, 0);
+  checkCollisions(keys, 0x5eed);
+}
+
+TEST(HashingTest, GeneratedIdentifiers) {
+  // Machine-generated names differ in only a few characters, often at the end.
+  std::vector<std::string> keys;
+  char buf[32];
+  for (unsigned i = 0; i < 50000; ++i) {
+    std::snprintf(buf, sizeof buf, "VALUE_%u", i);
+    keys.push_back(buf);
+    std::snprintf(buf, sizeof buf, "x%u", i);
+    keys.push_back(buf);
+  }
+  checkCollisions(keys, 0);
+}
+
+}}
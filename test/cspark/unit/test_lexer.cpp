@@ -5,7 +5,10 @@
 #include "gtest/gtest.h"
 #include "spark/source/location.h"
 #include "spark/source/programsource.h"
+#include "spark/source/sourcemanager.h"
+#include "spark/parse/keywords.h"
 #include "spark/parse/lexer.h"
+#include "spark/parse/tokenbuffer.h"
 
 namespace spark {
 namespace parse {
@@ -34,6 +37,13 @@ protected:
       return result;
   }
 
+  /** Expand a location into line and column numbers. */
+  source::DecodedLocation decode(const source::Location& loc) {
+    source::DecodedLocation result;
+    EXPECT_TRUE(source::SourceManager::get().decode(loc, result));
+    return result;
+  }
+
   /** A function that scans a single token and returns an error. */
   TokenType LexTokenError(const char* srcText) {
       source::StringSource  src("test.txt", srcText);
@@ -202,6 +212,63 @@ TEST_F(LexerTest, SingleTokens) {
   EXPECT_EQ(TOKEN_ERROR, LexTokenError("#"));
 }
 
+TEST_F(LexerTest, UnicodeIdentifiers) {
+  EXPECT_EQ(TOKEN_ID, LexToken("caf\xc3\xa9"));                    // café
+  EXPECT_EQ(TOKEN_ID, LexToken("\xcf\x80" "2"));                   // π2
+  EXPECT_EQ(TOKEN_ID, LexToken(" \xe6\x97\xa5\xe6\x9c\xac "));     // 日本
+  EXPECT_EQ(TOKEN_ID, LexToken("\xf0\x90\x80\x80"));               // U+10000
+
+  TestSource  src("a\xc3\xa9" "b+x");
+  Lexer       lex(&src);
+  EXPECT_EQ(TOKEN_ID, lex.next());
+  EXPECT_EQ("a\xc3\xa9" "b", lex.tokenValue());
+  EXPECT_EQ(TOKEN_PLUS, lex.next());
+  EXPECT_EQ(TOKEN_ID, lex.next());
+
+  // Not an identifier character (euro sign).
+  EXPECT_EQ(TOKEN_ERROR, LexTokenError("\xe2\x82\xac"));
+  EXPECT_EQ(TOKEN_ERROR, LexTokenError("\xe2\x82"));
+  EXPECT_EQ(TOKEN_ERROR, LexTokenError("\xc0\x80"));
+  EXPECT_EQ(TOKEN_ERROR, LexTokenError("\xed\xa0\x80"));
+}
+
+TEST_F(LexerTest, KeywordLookup) {
+  for (const Keyword& kw : keywords()) {
+    EXPECT_EQ(kw.token, lookupKeyword(collections::StringRef(kw.text, kw.length))) << kw.text;
+  }
+
+  EXPECT_EQ(TOKEN_ID, lookupKeyword(""));
+  EXPECT_EQ(TOKEN_ID, lookupKeyword("x"));
+  EXPECT_EQ(TOKEN_ID, lookupKeyword("wher"));
+  EXPECT_EQ(TOKEN_ID, lookupKeyword("whene"));
+  EXPECT_EQ(TOKEN_ID, lookupKeyword("whiles"));
+  EXPECT_EQ(TOKEN_ID, lookupKeyword("i128"));
+  EXPECT_EQ(TOKEN_ID, lookupKeyword("a_very_long_identifier_name_that_exceeds_any_keyword"));
+}
+
+TEST_F(LexerTest, TokenSets) {
+  constexpr TokenSet empty;
+  constexpr TokenSet set(TOKEN_END, TOKEN_LBRACE, TOKEN_RPAREN);
+  static_assert(set.contains(TOKEN_RPAREN), "Token sets are constexpr.");
+  for (int i = 0; i < TOKEN_LAST; ++i) {
+    TokenType tok = TokenType(i);
+    EXPECT_FALSE(empty.contains(tok));
+    EXPECT_EQ(tok == TOKEN_END || tok == TOKEN_LBRACE || tok == TOKEN_RPAREN, set.contains(tok))
+        << tok;
+  }
+  TokenSet both = set | DEFN_START_TOKENS;
+  EXPECT_TRUE(both.contains(TOKEN_LBRACE));
+  EXPECT_TRUE(both.contains(TOKEN_CLASS));
+  EXPECT_FALSE(both.contains(TOKEN_IF));
+
+  // Every keyword token has a name, and the names and spellings match.
+  for (const Keyword& kw : keywords()) {
+    EXPECT_STRNE("<Invalid Token>", GetTokenName(kw.token));
+  }
+  EXPECT_STREQ("NULL", GetTokenName(TOKEN_NULL));
+  EXPECT_EQ(TOKEN_NULL, lookupKeyword("null"));
+}
+
 TEST_F(LexerTest, StringLiterals) {
   SCOPED_TRACE("StringLiterals");
 
@@ -210,7 +277,7 @@ TEST_F(LexerTest, StringLiterals) {
     Lexer       lex(&src);
 
     EXPECT_EQ(TOKEN_STRING_LIT, lex.next());
-    EXPECT_EQ((size_t)0, lex.tokenValue().length());
+    EXPECT_EQ((size_t)0, lex.tokenValue().size());
   }
 
   {
@@ -261,6 +328,34 @@ TEST_F(LexerTest, StringLiterals) {
 #endif
 }
 
+TEST_F(LexerTest, TokenSlices) {
+  TestSource  src("name \"plain\" \"esc\\n\" 'c' 1_000");
+  Lexer       lex(&src);
+  collections::StringRef text = src.content();
+
+  EXPECT_EQ(TOKEN_ID, lex.next());
+  EXPECT_FALSE(lex.tokenDecoded());
+  EXPECT_EQ(text.begin(), lex.tokenValue().begin());
+  EXPECT_EQ("name", lex.tokenValue());
+
+  EXPECT_EQ(TOKEN_STRING_LIT, lex.next());
+  EXPECT_FALSE(lex.tokenDecoded());
+  EXPECT_EQ(text.begin() + 6, lex.tokenValue().begin());
+  EXPECT_EQ("plain", lex.tokenValue());
+
+  EXPECT_EQ(TOKEN_STRING_LIT, lex.next());
+  EXPECT_TRUE(lex.tokenDecoded());
+  EXPECT_EQ("esc\n", lex.tokenValue());
+
+  EXPECT_EQ(TOKEN_CHAR_LIT, lex.next());
+  EXPECT_FALSE(lex.tokenDecoded());
+  EXPECT_EQ("c", lex.tokenValue());
+
+  EXPECT_EQ(TOKEN_DEC_INT_LIT, lex.next());
+  EXPECT_TRUE(lex.tokenDecoded());
+  EXPECT_EQ("1000", lex.tokenValue());
+}
+
 TEST_F(LexerTest, CharLiterals) {
   SCOPED_TRACE("CharLiterals");
 
@@ -269,7 +364,7 @@ TEST_F(LexerTest, CharLiterals) {
     Lexer       lex(&src);
 
     EXPECT_EQ(TOKEN_CHAR_LIT, lex.next());
-    EXPECT_EQ((size_t)1, lex.tokenValue().length());
+    EXPECT_EQ((size_t)1, lex.tokenValue().size());
   }
 
   {
@@ -338,6 +433,35 @@ TEST_F(LexerTest, Comments) {
   EXPECT_EQ(TOKEN_ERROR, LexTokenError("/* comment"));
 }
 
+TEST_F(LexerTest, IntegerRange) {
+  TestSource  src("1..2 3...");
+  Lexer       lex(&src);
+
+  EXPECT_EQ(TOKEN_DEC_INT_LIT, lex.next());
+  EXPECT_EQ("1", lex.tokenValue());
+  EXPECT_EQ(TOKEN_RANGE, lex.next());
+  EXPECT_EQ(2u, decode(lex.tokenLocation()).startCol);
+  EXPECT_EQ(TOKEN_DEC_INT_LIT, lex.next());
+  EXPECT_EQ("2", lex.tokenValue());
+  EXPECT_EQ(TOKEN_DEC_INT_LIT, lex.next());
+  EXPECT_EQ(TOKEN_ELLIPSIS, lex.next());
+  EXPECT_EQ(TOKEN_END, lex.next());
+}
+
+TEST_F(LexerTest, CommentLocation) {
+  TestSource  src("  // comment\r\n/* a\n\n b */    x/*\r\r\n*/  y /* z");
+  Lexer       lex(&src);
+
+  EXPECT_EQ(TOKEN_ID, lex.next());
+  EXPECT_EQ(4u, decode(lex.tokenLocation()).startLine);
+  EXPECT_EQ(10u, decode(lex.tokenLocation()).startCol);
+  EXPECT_EQ(TOKEN_ID, lex.next());
+  EXPECT_EQ(6u, decode(lex.tokenLocation()).startLine);
+  EXPECT_EQ(5u, decode(lex.tokenLocation()).startCol);
+  EXPECT_EQ(TOKEN_ERROR, lex.next());
+  EXPECT_EQ(Lexer::UNTERMINATED_COMMENT, lex.errorCode());
+}
+
 TEST_F(LexerTest, Location) {
 
   TestSource  src("\n\n   aaaaa    ");
@@ -345,14 +469,107 @@ TEST_F(LexerTest, Location) {
 
   EXPECT_EQ(TOKEN_ID, lex.next());
 
-  EXPECT_EQ(3u, lex.tokenLocation().startLine);
-  EXPECT_EQ(4u, lex.tokenLocation().startCol);
-  EXPECT_EQ(3u, lex.tokenLocation().endLine);
-  EXPECT_EQ(9u, lex.tokenLocation().endCol);
+  EXPECT_EQ(3u, decode(lex.tokenLocation()).startLine);
+  EXPECT_EQ(4u, decode(lex.tokenLocation()).startCol);
+  EXPECT_EQ(3u, decode(lex.tokenLocation()).endLine);
+  EXPECT_EQ(9u, decode(lex.tokenLocation()).endCol);
 
-  std::string line;
+  collections::StringRef line;
   EXPECT_TRUE(src.getLine(2, line));
   EXPECT_EQ("   aaaaa    ", line);
+  EXPECT_FALSE(src.getLine(3, line));
+}
+
+TEST_F(LexerTest, LineIndex) {
+  TestSource  src("ab\r\n\ncd\n");
+
+  collections::StringRef line;
+  EXPECT_TRUE(src.getLine(0, line));
+  EXPECT_EQ("ab", line);
+  EXPECT_TRUE(src.getLine(1, line));
+  EXPECT_EQ("", line);
+  EXPECT_TRUE(src.getLine(2, line));
+  EXPECT_EQ("cd", line);
+  EXPECT_FALSE(src.getLine(3, line));
+
+  EXPECT_EQ(0u, src.lineIndexOf(0));
+  EXPECT_EQ(0u, src.lineIndexOf(3));
+  EXPECT_EQ(1u, src.lineIndexOf(4));
+  EXPECT_EQ(2u, src.lineIndexOf(5));
+  EXPECT_EQ(2u, src.lineIndexOf(8));
+}
+
+TEST_F(LexerTest, TokenBuffer) {
+  TestSource  src("let x = \"a\\n\";\n  f(12u) // c\n");
+  TokenBuffer tokens;
+  tokens.tokenize(&src);
+
+  ASSERT_EQ(10u, tokens.size());
+  EXPECT_EQ(TOKEN_LET, tokens.kind(0));
+  EXPECT_EQ(TOKEN_ID, tokens.kind(1));
+  EXPECT_EQ(TOKEN_ASSIGN, tokens.kind(2));
+  EXPECT_EQ(TOKEN_STRING_LIT, tokens.kind(3));
+  EXPECT_EQ(TOKEN_SEMI, tokens.kind(4));
+  EXPECT_EQ(TOKEN_ID, tokens.kind(5));
+  EXPECT_EQ(TOKEN_LPAREN, tokens.kind(6));
+  EXPECT_EQ(TOKEN_DEC_INT_LIT, tokens.kind(7));
+  EXPECT_EQ(TOKEN_RPAREN, tokens.kind(8));
+  EXPECT_EQ(TOKEN_END, tokens.kind(9));
+
+  // Text, values and atoms.
+  EXPECT_EQ("let", tokens.text(0));
+  EXPECT_EQ("let", tokens.value(0));
+  EXPECT_EQ("x", tokens.value(1));
+  EXPECT_EQ(collections::Atom::intern("x"), tokens.atom(1));
+  EXPECT_EQ("\"a\\n\"", tokens.text(3));
+  EXPECT_EQ("a\n", tokens.value(3));
+  EXPECT_NE(0, tokens.flags(3) & TokenBuffer::DECODED);
+  EXPECT_EQ("", tokens.value(4));
+  EXPECT_EQ("12", tokens.value(7));
+  EXPECT_EQ("u", tokens.suffix(7));
+
+  // Flags.
+  EXPECT_NE(0, tokens.flags(0) & TokenBuffer::LINE_START);
+  EXPECT_EQ(0, tokens.flags(0) & TokenBuffer::SPACE_BEFORE);
+  EXPECT_NE(0, tokens.flags(1) & TokenBuffer::SPACE_BEFORE);
+  EXPECT_EQ(0, tokens.flags(1) & TokenBuffer::LINE_START);
+  EXPECT_EQ(0, tokens.flags(4) & TokenBuffer::SPACE_BEFORE);
+  EXPECT_NE(0, tokens.flags(5) & TokenBuffer::LINE_START);
+
+  // Locations.
+  source::DecodedLocation loc = decode(tokens.location(5));
+  EXPECT_EQ(2u, loc.startLine);
+  EXPECT_EQ(3u, loc.startCol);
+  EXPECT_EQ(4u, loc.endCol);
+  EXPECT_EQ(src.base() + src.content().size(), tokens.begin(tokens.size() - 1));
+}
+
+TEST_F(LexerTest, IllegalCharsSkipped) {
+  // Each bad character or sequence is one error token, and the lexer moves past it.
+  TestSource  src("a # b \xc2\xa9 c \xff d \xe2\x82\xac");
+  Lexer       lex(&src);
+  EXPECT_EQ(TOKEN_ID, lex.next());
+  EXPECT_EQ(TOKEN_ERROR, lex.next());
+  EXPECT_EQ(Lexer::ILLEGAL_CHAR, lex.errorCode());
+  EXPECT_EQ(TOKEN_ID, lex.next());
+  EXPECT_EQ(TOKEN_ERROR, lex.next());
+  EXPECT_EQ("\xc2\xa9", lex.tokenValue());
+  EXPECT_EQ(TOKEN_ID, lex.next());
+  EXPECT_EQ(TOKEN_ERROR, lex.next());
+  EXPECT_EQ(Lexer::INVALID_UNICODE_CHAR, lex.errorCode());
+  EXPECT_EQ(TOKEN_ID, lex.next());
+  EXPECT_EQ("d", lex.tokenValue());
+  EXPECT_EQ(TOKEN_ERROR, lex.next());
+  EXPECT_EQ(TOKEN_END, lex.next());
+
+  TokenBuffer tokens;
+  tokens.tokenize(&src);
+  ASSERT_EQ(9u, tokens.size());
+  EXPECT_EQ(TOKEN_ERROR, tokens.kind(1));
+  EXPECT_EQ("#", tokens.text(1));
+  EXPECT_EQ("\xc2\xa9", tokens.text(3));
+  EXPECT_EQ("\xff", tokens.text(5));
+  EXPECT_EQ(TOKEN_END, tokens.kind(8));
 }
 
 }}
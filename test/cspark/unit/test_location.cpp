@@ -4,52 +4,101 @@
 
 #include "gtest/gtest.h"
 #include "spark/source/location.h"
+#include "spark/source/programsource.h"
+#include "spark/source/sourcemanager.h"
 
 namespace spark {
 namespace source {
 
 TEST(LocationTest, UnionTest) {
-  Location S0(NULL, 1, 10, 1, 15);
-  Location S1(NULL, 1, 20, 1, 25);
-  Location S3(NULL, 2, 10, 2, 11);
-  Location S4(NULL, 1, 5, 3, 22);
-  
+  Location S0(10, 15);
+  Location S1(20, 25);
+  Location S3(110, 111);
+  Location S4(5, 322);
+
   Location R0 = S0 | S1;
-  EXPECT_EQ(1, R0.startLine);
-  EXPECT_EQ(10, R0.startCol);
-  EXPECT_EQ(1, R0.endLine);
-  EXPECT_EQ(25, R0.endCol);
+  EXPECT_EQ(10u, R0.begin);
+  EXPECT_EQ(25u, R0.end);
 
   R0 = S1 | S0;
-  EXPECT_EQ(1, R0.startLine);
-  EXPECT_EQ(10, R0.startCol);
-  EXPECT_EQ(1, R0.endLine);
-  EXPECT_EQ(25, R0.endCol);
+  EXPECT_EQ(10u, R0.begin);
+  EXPECT_EQ(25u, R0.end);
 
   R0 = S0 | S3;
-  EXPECT_EQ(1, R0.startLine);
-  EXPECT_EQ(10, R0.startCol);
-  EXPECT_EQ(2, R0.endLine);
-  EXPECT_EQ(11, R0.endCol);
+  EXPECT_EQ(10u, R0.begin);
+  EXPECT_EQ(111u, R0.end);
 
   R0 = S3 | S0;
-  EXPECT_EQ(1, R0.startLine);
-  EXPECT_EQ(10, R0.startCol);
-  EXPECT_EQ(2, R0.endLine);
-  EXPECT_EQ(11, R0.endCol);
+  EXPECT_EQ(10u, R0.begin);
+  EXPECT_EQ(111u, R0.end);
 
   R0 = S0 | S4;
-  EXPECT_EQ(1, R0.startLine);
-  EXPECT_EQ(5, R0.startCol);
-  EXPECT_EQ(3, R0.endLine);
-  EXPECT_EQ(22, R0.endCol);
+  EXPECT_EQ(5u, R0.begin);
+  EXPECT_EQ(322u, R0.end);
 
   R0 = S4 | S0;
-  EXPECT_EQ(1, R0.startLine);
-  EXPECT_EQ(5, R0.startCol);
-  EXPECT_EQ(3, R0.endLine);
-  EXPECT_EQ(22, R0.endCol);
+  EXPECT_EQ(5u, R0.begin);
+  EXPECT_EQ(322u, R0.end);
+
+  R0 = Location() | S0;
+  EXPECT_EQ(10u, R0.begin);
+  EXPECT_EQ(15u, R0.end);
+
+  R0 = S0 | Location();
+  EXPECT_EQ(10u, R0.begin);
+  EXPECT_EQ(15u, R0.end);
 }
 
-}}
+TEST(LocationTest, Decode) {
+  SourceManager& sm = SourceManager::get();
+  DecodedLocation dloc;
+  EXPECT_FALSE(sm.decode(Location(), dloc));
+
+  Location loc;
+  {
+    StringSource s0("a.sp", "ab\ncd\n");
+    StringSource s1("b.sp", "x\r\n  yz");
+    uint32_t b0 = s0.base();
+    uint32_t b1 = s1.base();
+    EXPECT_NE(0u, b0);
+    EXPECT_GT(b1, b0 + 6);
+
+    ASSERT_TRUE(sm.decode(Location(b0 + 3, b0 + 5), dloc));
+    EXPECT_EQ(&s0, dloc.source);
+    EXPECT_EQ(2u, dloc.startLine);
+    EXPECT_EQ(1u, dloc.startCol);
+    EXPECT_EQ(2u, dloc.endLine);
+    EXPECT_EQ(3u, dloc.endCol);
+
+    ASSERT_TRUE(sm.decode(Location(b0 + 1, b0 + 6), dloc));
+    EXPECT_EQ(1u, dloc.startLine);
+    EXPECT_EQ(2u, dloc.startCol);
+    EXPECT_EQ(3u, dloc.endLine);
+    EXPECT_EQ(1u, dloc.endCol);
 
+    loc = Location(b1 + 5, b1 + 7);
+    ASSERT_TRUE(sm.decode(loc, dloc));
+    EXPECT_EQ(&s1, dloc.source);
+    EXPECT_EQ(2u, dloc.startLine);
+    EXPECT_EQ(3u, dloc.startCol);
+    EXPECT_EQ(2u, dloc.endLine);
+    EXPECT_EQ(5u, dloc.endCol);
+  }
+
+  // Locations in a file that no longer exists can't be decoded.
+  EXPECT_FALSE(sm.decode(loc, dloc));
+}
+
+TEST(LocationTest, OffsetSpaceFull) {
+  SourceManager& sm = SourceManager::get();
+  StringSource s0("a.sp", "ab\ncd\n");
+  uint32_t size = sm.size();
+
+  // A file that doesn't fit is refused, and takes up no room.
+  EXPECT_EQ(0u, sm.add(&s0, UINT32_MAX - size));
+  EXPECT_EQ(0u, sm.add(&s0, size_t(UINT32_MAX) * 2));
+  EXPECT_EQ(size, sm.size());
+  EXPECT_EQ(size, s0.base());
+}
+
+}}
@@ -0,0 +1,172 @@
+/* ================================================================== *
+ * Unit test for spark::sema::passes::NameResolutionPass
+ * ================================================================== */
+
+#include "gtest/gtest.h"
+#include "spark/compiler/compiler.h"
+#include "spark/sema/passes/nameresolution.h"
+#include "spark/semgraph/module.h"
+#include <climits>
+#include <fstream>
+#include <stdlib.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef SPARK_SOURCE_DIR
+  #define SPARK_SOURCE_DIR "."
+#endif
+
+namespace spark {
+namespace sema {
+namespace passes {
+
+namespace {
+  /** Reporter that counts errors. */
+  class CountingReporter : public error::IndentingReporter {
+  public:
+    CountingReporter() : errors(0) {}
+
+    void report(error::Severity sev, source::Location loc, collections::StringRef msg) {
+      if (sev == error::ERROR || sev == error::FATAL) {
+        errors += 1;
+      }
+    }
+
+    int errorCount() const { return errors; }
+
+    int errors;
+  };
+
+  /** What resolving the test module did to the type memo. */
+  struct MemoCounts {
+    std::size_t hits;
+    std::size_t misses;
+    int errors;
+  };
+}
+
+/** Compiles the Spark library along with a test module, and counts how the types in the test
+    module were resolved. */
+class NameResolutionTest : public testing::Test {
+protected:
+  virtual void SetUp() {
+    char dir[] = "/tmp/nameresXXXXXX";
+    ASSERT_TRUE(::mkdtemp(dir) != nullptr);
+    _dir = dir;
+    // The link is followed from the temporary directory, so it needs an absolute path.
+    char lib[PATH_MAX];
+    ASSERT_TRUE(::realpath(SPARK_SOURCE_DIR "/lib/spark", lib) != nullptr) <<
+        "Spark library sources not found.";
+    ASSERT_EQ(0, ::symlink(lib, (_dir + "/spark").c_str()));
+    ASSERT_EQ(0, ::mkdir((_dir + "/memo").c_str(), 0755));
+  }
+
+  virtual void TearDown() {
+    ::unlink((_dir + "/memo/memo.sp").c_str());
+    ::rmdir((_dir + "/memo").c_str());
+    ::unlink((_dir + "/spark").c_str());
+    ::rmdir(_dir.c_str());
+  }
+
+  std::string _dir;
+
+  MemoCounts compile(const std::string& text) {
+    {
+      std::ofstream out((_dir + "/memo/memo.sp").c_str());
+      out << text;
+    }
+    CountingReporter reporter;
+    compiler::Compiler compiler(reporter);
+    compiler.setSourceRoot(_dir);
+    compiler.addSource(_dir);
+    compiler.compile();
+    MemoCounts result = { 0, 0, reporter.errors };
+    bool found = false;
+    for (const semgraph::Module* mod : compiler.sourceModules()) {
+      if (mod->qualifiedName() == "memo.memo") {
+        TypeMemoStats stats = compiler.typeMemoStats(mod);
+        result.hits = stats.hits;
+        result.misses = stats.misses;
+        found = true;
+      }
+    }
+    EXPECT_TRUE(found) << "Test module not compiled.";
+    return result;
+  }
+
+  /** Check that resolving 'text' took the given number of memo hits and misses. */
+  void expectCounts(const std::string& text, std::size_t hits, std::size_t misses) {
+    MemoCounts counts = compile(text);
+    EXPECT_EQ(0, counts.errors) << text;
+    EXPECT_EQ(hits, counts.hits) << text;
+    EXPECT_EQ(misses, counts.misses) << text;
+  }
+};
+
+TEST_F(NameResolutionTest, SameContextHitsMemo) {
+  expectCounts(
+      "class A {\n"
+      "  var x: f64?;\n"
+      "  var y: f64 ?;\n"
+      "  var z: f64?;\n"
+      "}\n"
+      "class B {}\n", 2, 1);
+
+  // A function without type parameters adds no scopes, so it shares its class's memo.
+  expectCounts(
+      "class A {\n"
+      "  var x: f64?;\n"
+      "  def f() -> f64?;\n"
+      "}\n"
+      "class B {}\n", 1, 1);
+}
+
+TEST_F(NameResolutionTest, DifferentContextMisses) {
+  // A different owner.
+  expectCounts(
+      "class A {\n"
+      "  var x: f64?;\n"
+      "}\n"
+      "class B {\n"
+      "  var x: f64?;\n"
+      "}\n", 0, 2);
+
+  // A different scope: the function's type parameters could change what the names mean.
+  expectCounts(
+      "class A {\n"
+      "  var x: f64?;\n"
+      "  def f[T]() -> f64?;\n"
+      "}\n"
+      "class B {}\n", 0, 2);
+}
+
+TEST_F(NameResolutionTest, ErrorsNotMemoized) {
+  // Each occurrence of a type that fails to resolve is resolved, and reported, again.
+  MemoCounts counts = compile(
+      "class A {\n"
+      "  var x: Unknown;\n"
+      "  var y: Unknown;\n"
+      "}\n"
+      "class B {}\n");
+  EXPECT_EQ(2, counts.errors);
+  EXPECT_EQ(0u, counts.hits);
+  EXPECT_EQ(2u, counts.misses);
+}
+
+TEST_F(NameResolutionTest, FailureThenNewScope) {
+  // A type that fails to resolve, then resolves once a scope defines its name, must not
+  // leave behind a memo entry or context that matches the failing occurrences.
+  MemoCounts counts = compile(
+      "class A {\n"
+      "  var x: T?;\n"
+      "  def f[T]() -> T?;\n"
+      "  var y: T?;\n"
+      "}\n"
+      "class B {}\n");
+  EXPECT_EQ(2, counts.errors);
+  EXPECT_EQ(0u, counts.hits);
+  EXPECT_EQ(3u, counts.misses);
+}
+
+}}}
@@ -6,8 +6,13 @@
 #include "spark/ast/node.h"
 #include "spark/ast/ident.h"
 #include "spark/ast/literal.h"
+#include "spark/ast/module.h"
+#include "spark/ast/oper.h"
 #include "spark/parse/parser.h"
+#include "spark/source/sourcemanager.h"
 #include "mocks.h"
+#include <memory>
+#include <vector>
 
 namespace spark {
 namespace parse {
@@ -23,6 +28,7 @@ protected:
 
   support::Arena    _arena;
   MockReporter      _reporter;
+  std::vector<std::unique_ptr<source::StringSource>> _sources;
 
   template <class T>
   T* parse(T* (Parser::*parseFunc)(), const char* srctext, int expectedErrors) {
@@ -30,8 +36,9 @@ protected:
 //       diag.setMinSeverity(error::Off);
 //     }
 
-    source::StringSource src("test.txt", srctext);
-    Parser parser(_reporter, &src, _arena);
+    // The AST may refer to the source text, so keep the source alive as long as the arena.
+    _sources.emplace_back(new source::StringSource("test.txt", srctext));
+    Parser parser(_reporter, _sources.back().get(), _arena);
     T* result = (parser.*parseFunc)();
 //     if (!expectedErrors) {
 //       EXPECT_TRUE(result != NULL) << "[src = " << srctext << "]";
@@ -46,6 +53,13 @@ protected:
     return result;
   }
 
+  /** Expand a location into line and column numbers. */
+  source::DecodedLocation decode(const source::Location& loc) {
+    source::DecodedLocation result;
+    EXPECT_TRUE(source::SourceManager::get().decode(loc, result));
+    return result;
+  }
+
   Node* parseExpression(const char* srctext, int expectedErrors = 0) {
     return parse(&Parser::expression, srctext, expectedErrors);
   }
@@ -69,63 +83,63 @@ TEST_F(ParserTest, Terminals) {
   // true
   n = parseExpression("true");
   ASSERT_EQ(ast::Kind::BOOLEAN_TRUE, n->kind());
-  ASSERT_EQ(1, n->location().startLine);
-  ASSERT_EQ(1, n->location().startCol);
-  ASSERT_EQ(1, n->location().endLine);
-  ASSERT_EQ(5, n->location().endCol);
+  ASSERT_EQ(1, decode(n->location()).startLine);
+  ASSERT_EQ(1, decode(n->location()).startCol);
+  ASSERT_EQ(1, decode(n->location()).endLine);
+  ASSERT_EQ(5, decode(n->location()).endCol);
 
   // true
   n = parseExpression("false");
   ASSERT_EQ(ast::Kind::BOOLEAN_FALSE, n->kind());
-  ASSERT_EQ(1, n->location().startLine);
-  ASSERT_EQ(1, n->location().startCol);
-  ASSERT_EQ(1, n->location().endLine);
-  ASSERT_EQ(6, n->location().endCol);
+  ASSERT_EQ(1, decode(n->location()).startLine);
+  ASSERT_EQ(1, decode(n->location()).startCol);
+  ASSERT_EQ(1, decode(n->location()).endLine);
+  ASSERT_EQ(6, decode(n->location()).endCol);
 
   // super
   n = parseExpression("super");
   ASSERT_TRUE(n != NULL);
   ASSERT_EQ(ast::Kind::SUPER, n->kind());
-  ASSERT_EQ(1, n->location().startLine);
-  ASSERT_EQ(1, n->location().startCol);
-  ASSERT_EQ(1, n->location().endLine);
-  ASSERT_EQ(6, n->location().endCol);
+  ASSERT_EQ(1, decode(n->location()).startLine);
+  ASSERT_EQ(1, decode(n->location()).startCol);
+  ASSERT_EQ(1, decode(n->location()).endLine);
+  ASSERT_EQ(6, decode(n->location()).endCol);
 
   // true
   n = parseExpression("self");
   ASSERT_EQ(ast::Kind::SELF, n->kind());
-  ASSERT_EQ(1, n->location().startLine);
-  ASSERT_EQ(1, n->location().startCol);
-  ASSERT_EQ(1, n->location().endLine);
-  ASSERT_EQ(5, n->location().endCol);
+  ASSERT_EQ(1, decode(n->location()).startLine);
+  ASSERT_EQ(1, decode(n->location()).startCol);
+  ASSERT_EQ(1, decode(n->location()).endLine);
+  ASSERT_EQ(5, decode(n->location()).endCol);
 
   // true
   n = parseExpression("null");
   ASSERT_EQ(ast::Kind::NULL_LITERAL, n->kind());
-  ASSERT_EQ(1, n->location().startLine);
-  ASSERT_EQ(1, n->location().startCol);
-  ASSERT_EQ(1, n->location().endLine);
-  ASSERT_EQ(5, n->location().endCol);
+  ASSERT_EQ(1, decode(n->location()).startLine);
+  ASSERT_EQ(1, decode(n->location()).startCol);
+  ASSERT_EQ(1, decode(n->location()).endLine);
+  ASSERT_EQ(5, decode(n->location()).endCol);
 
   // id
   n = parseExpression("X");
   ASSERT_EQ(ast::Kind::IDENT, n->kind());
   ast::Ident* id = static_cast<ast::Ident*>(n);
   ASSERT_EQ("X", id->name());
-  ASSERT_EQ(1, id->location().startLine);
-  ASSERT_EQ(1, id->location().startCol);
-  ASSERT_EQ(1, id->location().endLine);
-  ASSERT_EQ(2, id->location().endCol);
+  ASSERT_EQ(1, decode(id->location()).startLine);
+  ASSERT_EQ(1, decode(id->location()).startCol);
+  ASSERT_EQ(1, decode(id->location()).endLine);
+  ASSERT_EQ(2, decode(id->location()).endCol);
 
   // integer
   n = parseExpression("23");
   ASSERT_EQ(ast::Kind::INTEGER_LITERAL, n->kind());
   ast::IntegerLiteral* il = static_cast<ast::IntegerLiteral*>(n);
   ASSERT_EQ(23, il->value());
-  ASSERT_EQ(1, n->location().startLine);
-  ASSERT_EQ(1, n->location().startCol);
-  ASSERT_EQ(1, n->location().endLine);
-  ASSERT_EQ(3, n->location().endCol);
+  ASSERT_EQ(1, decode(n->location()).startLine);
+  ASSERT_EQ(1, decode(n->location()).startCol);
+  ASSERT_EQ(1, decode(n->location()).endLine);
+  ASSERT_EQ(3, decode(n->location()).endCol);
 
   n = parseExpression("0x10");
   ASSERT_EQ(ast::Kind::INTEGER_LITERAL, n->kind());
@@ -169,4 +183,165 @@ TEST_F(ParserTest, Terminals) {
 //   EXPECT_EQ(3u, ast->location().end);
 }
 
+TEST_F(ParserTest, BinaryOperators) {
+  // Operators of equal precedence group to the left.
+  auto n = static_cast<const ast::Oper*>(parseExpression("a - b - c"));
+  ASSERT_EQ(ast::Kind::SUB, n->kind());
+  EXPECT_EQ(ast::Kind::SUB, n->operands()[0]->kind());
+  EXPECT_EQ(ast::Kind::IDENT, n->operands()[1]->kind());
+
+  // Tighter operators group first, on either side.
+  n = static_cast<const ast::Oper*>(parseExpression("a * b + c << d & e"));
+  ASSERT_EQ(ast::Kind::BIT_AND, n->kind());
+  auto shift = static_cast<const ast::Oper*>(n->operands()[0]);
+  ASSERT_EQ(ast::Kind::LSHIFT, shift->kind());
+  auto add = static_cast<const ast::Oper*>(shift->operands()[0]);
+  ASSERT_EQ(ast::Kind::ADD, add->kind());
+  EXPECT_EQ(ast::Kind::MUL, add->operands()[0]->kind());
+  n = static_cast<const ast::Oper*>(parseExpression("a == b + c * d"));
+  ASSERT_EQ(ast::Kind::EQUAL, n->kind());
+  add = static_cast<const ast::Oper*>(n->operands()[1]);
+  ASSERT_EQ(ast::Kind::ADD, add->kind());
+  EXPECT_EQ(ast::Kind::MUL, add->operands()[1]->kind());
+  source::DecodedLocation dloc = decode(n->location());
+  EXPECT_EQ(1u, dloc.startCol);
+  EXPECT_EQ(15u, dloc.endCol);
+
+  // Operators with a type on the right, and two-token operators.
+  n = static_cast<const ast::Oper*>(parseExpression("x is not i32 and y not in z"));
+  ASSERT_EQ(ast::Kind::LOGICAL_AND, n->kind());
+  EXPECT_EQ(ast::Kind::IS_NOT, n->operands()[0]->kind());
+  EXPECT_EQ(ast::Kind::BUILTIN_TYPE,
+      static_cast<const ast::Oper*>(n->operands()[0])->operands()[1]->kind());
+  EXPECT_EQ(ast::Kind::NOT_IN, n->operands()[1]->kind());
+  n = static_cast<const ast::Oper*>(parseExpression("y or x as i32"));
+  ASSERT_EQ(ast::Kind::LOGICAL_OR, n->kind());
+  EXPECT_EQ(ast::Kind::AS_TYPE, n->operands()[1]->kind());
+
+  // A single operand is returned as it is.
+  EXPECT_EQ(ast::Kind::IDENT, parseExpression("a")->kind());
+}
+
+TEST_F(ParserTest, DeferredBodies) {
+  _sources.emplace_back(new source::StringSource("test.txt",
+      "def f(x: i32) -> i32 {\n  if x > 0 { return 1; }\n  return 2;\n}\n"
+      "def g() -> i32 => 3;\n"));
+  source::StringSource* src = _sources.back().get();
+  Parser parser(_reporter, src, _arena);
+  parser.setDeferBodies(true);
+  ast::Module* mod = parser.module();
+  ASSERT_TRUE(mod != nullptr);
+  ASSERT_EQ(2u, mod->members().size());
+
+  // Block bodies are skipped, and their extent recorded.
+  auto f = static_cast<const ast::Function*>(mod->members()[0]);
+  ASSERT_EQ(ast::Kind::FUNCTION, f->kind());
+  ASSERT_EQ(ast::Kind::DEFERRED_BODY, f->body()->kind());
+  auto deferred = static_cast<const ast::DeferredBody*>(f->body());
+  EXPECT_FALSE(deferred->isParsed());
+  source::DecodedLocation dloc = decode(deferred->location());
+  EXPECT_EQ(1u, dloc.startLine);
+  EXPECT_EQ(22u, dloc.startCol);
+  EXPECT_EQ(4u, dloc.endLine);
+  EXPECT_EQ(2u, dloc.endCol);
+
+  // Expression bodies are always parsed.
+  auto g = static_cast<const ast::Function*>(mod->members()[1]);
+  EXPECT_EQ(ast::Kind::INTEGER_LITERAL, g->body()->kind());
+
+  // The body is parsed when first asked for, with the same locations as a full parse.
+  const Node* body = Parser::parseDeferredBody(_reporter, deferred);
+  ASSERT_TRUE(body != nullptr);
+  ASSERT_EQ(ast::Kind::BLOCK, body->kind());
+  EXPECT_TRUE(deferred->isParsed());
+  EXPECT_EQ(2u, static_cast<const ast::Oper*>(body)->operands().size());
+  dloc = decode(body->location());
+  EXPECT_EQ(1u, dloc.startLine);
+  EXPECT_EQ(22u, dloc.startCol);
+  EXPECT_EQ(body, Parser::parseDeferredBody(_reporter, deferred));
+}
+
+TEST_F(ParserTest, CompactNodes) {
+  // Node headers are 8 bytes; operator operands are stored inline after the node.
+  EXPECT_EQ(8u, sizeof(Node));
+  _sources.emplace_back(new source::StringSource("test.txt", "def f() => a + b * c;\n"));
+  Parser parser(_reporter, _sources.back().get(), _arena);
+  ast::Module* mod = parser.module();
+  ASSERT_TRUE(mod != nullptr);
+  auto f = static_cast<const ast::Function*>(mod->members()[0]);
+  ASSERT_EQ(ast::Kind::ADD, f->body()->kind());
+  auto add = static_cast<const ast::Oper*>(f->body());
+  ASSERT_EQ(2u, add->operands().size());
+  EXPECT_EQ(reinterpret_cast<const Node* const*>(add + 1), add->operands().begin());
+  EXPECT_EQ(ast::Kind::IDENT, add->operands()[0]->kind());
+  EXPECT_EQ(ast::Kind::MUL, add->operands()[1]->kind());
+  source::DecodedLocation dloc = decode(add->location());
+  EXPECT_EQ(12u, dloc.startCol);
+  EXPECT_EQ(21u, dloc.endCol);
+}
+
+TEST_F(ParserTest, Reparse) {
+  std::string text = "import a.b;\n\ndef f() => 1;\n\ndef g() => 2;\n\ndef h() => 3;\n";
+  _sources.emplace_back(new source::StringSource("test.txt", text));
+  Parser parser(_reporter, _sources.back().get(), _arena);
+  const ast::Module* mod = parser.module();
+  ASSERT_TRUE(mod != nullptr);
+  ASSERT_EQ(3u, mod->members().size());
+  ASSERT_EQ(3u, mod->spans().size());
+  EXPECT_EQ(text.find("def g"), mod->spans()[1].begin);
+  EXPECT_EQ(text.find("2;") + 2, mod->spans()[1].end);
+
+  // Only the edited definition is parsed again.
+  TextEdit edit = { uint32_t(text.find("2;")), 1, 2 };
+  text.replace(edit.offset, edit.length, "20");
+  _sources.emplace_back(new source::StringSource("test.txt", text));
+  ModuleChanges changes;
+  const ast::Module* mod2 = Parser::reparse(
+      _reporter, _sources.back().get(), _arena, mod, edit, changes);
+  ASSERT_TRUE(mod2 != nullptr);
+  EXPECT_FALSE(changes.full);
+  ASSERT_EQ(3u, mod2->members().size());
+  EXPECT_EQ(mod->members()[0], mod2->members()[0]);
+  EXPECT_EQ(mod->members()[2], mod2->members()[2]);
+  EXPECT_EQ(mod->imports().begin(), mod2->imports().begin());
+  ASSERT_EQ(1u, changes.removed.size());
+  EXPECT_EQ(mod->members()[1], changes.removed[0]);
+  ASSERT_EQ(1u, changes.added.size());
+  EXPECT_EQ(mod2->members()[1], changes.added[0]);
+  auto g = static_cast<const ast::Function*>(mod2->members()[1]);
+  EXPECT_EQ(ast::Kind::INTEGER_LITERAL, g->body()->kind());
+  EXPECT_EQ(text.find("def h"), mod2->spans()[2].begin);
+
+  // A definition inserted between two others is added, and nothing is removed.
+  edit.offset = uint32_t(text.find("\ndef h"));
+  edit.length = 0;
+  edit.newLength = 14;
+  text.insert(edit.offset, "def k() => 4;\n");
+  _sources.emplace_back(new source::StringSource("test.txt", text));
+  const ast::Module* mod3 = Parser::reparse(
+      _reporter, _sources.back().get(), _arena, mod2, edit, changes);
+  ASSERT_TRUE(mod3 != nullptr);
+  EXPECT_FALSE(changes.full);
+  ASSERT_EQ(4u, mod3->members().size());
+  EXPECT_EQ(mod2->members()[1], mod3->members()[1]);
+  EXPECT_EQ(mod2->members()[2], mod3->members()[3]);
+  EXPECT_TRUE(changes.removed.empty());
+  ASSERT_EQ(1u, changes.added.size());
+  EXPECT_TRUE(static_cast<const ast::Defn*>(changes.added[0])->name() == "k");
+
+  // Editing the imports parses the whole file.
+  edit.offset = uint32_t(text.find("a.b") + 2);
+  edit.length = 1;
+  edit.newLength = 1;
+  text[edit.offset] = 'c';
+  _sources.emplace_back(new source::StringSource("test.txt", text));
+  const ast::Module* mod4 = Parser::reparse(
+      _reporter, _sources.back().get(), _arena, mod3, edit, changes);
+  ASSERT_TRUE(mod4 != nullptr);
+  EXPECT_TRUE(changes.full);
+  EXPECT_EQ(4u, changes.removed.size());
+  EXPECT_EQ(4u, changes.added.size());
+  EXPECT_NE(mod3->members()[0], mod4->members()[0]);
+}
+
 }}
@@ -0,0 +1,87 @@
+/* ================================================================== *
+ * Unit test for spark::error::BufferedReporter
+ * ================================================================== */
+
+#include "gtest/gtest.h"
+#include "spark/error/reporter.h"
+#include <string>
+#include <vector>
+
+namespace spark {
+namespace error {
+
+namespace {
+  /** Reporter that keeps a description of each message it is given. */
+  class RecordingReporter : public IndentingReporter {
+  public:
+    RecordingReporter() : _errorCount(0) {}
+
+    void report(Severity sev, Location loc, StringRef msg) {
+      if (sev == ERROR || sev == FATAL) {
+        _errorCount += 1;
+      }
+      messages.push_back(std::to_string(int(sev)) + " " + std::to_string(loc.begin) + " " +
+          std::to_string(_indentLevel) + " " + std::string(msg.begin(), msg.end()));
+    }
+
+    int errorCount() const { return _errorCount; }
+
+    std::vector<std::string> messages;
+
+  private:
+    int _errorCount;
+  };
+}
+
+TEST(BufferedReporterTest, ReplayInOrder) {
+  BufferedReporter buffer;
+  buffer.warn(Location(5, 6)) << "first";
+  buffer.error(Location(1, 2)) << "second";
+  buffer.indent();
+  buffer.info() << "third";
+  buffer.unindent();
+  buffer.fatal(Location(3, 4)) << "fourth";
+  EXPECT_EQ(2, buffer.errorCount());
+
+  // Nothing reaches the target until the buffer is replayed.
+  RecordingReporter target;
+  target.error() << "before";
+  target.indent();
+  EXPECT_EQ(1u, target.messages.size());
+
+  buffer.replay(target);
+  std::vector<std::string> expected = {
+    "4 0 0 before",
+    "3 5 1 first",
+    "4 1 1 second",
+    "2 0 2 third",
+    "5 3 1 fourth",
+  };
+  EXPECT_EQ(expected, target.messages);
+  EXPECT_EQ(3, target.errorCount());
+  EXPECT_EQ(1, target.indentLevel());
+
+  // Replaying empties the buffer.
+  EXPECT_EQ(0, buffer.errorCount());
+  buffer.replay(target);
+  EXPECT_EQ(5u, target.messages.size());
+}
+
+TEST(BufferedReporterTest, Counts) {
+  // The error count of a buffer, and of the reporter it is replayed into, match what the
+  // reporter would have counted directly.
+  RecordingReporter direct;
+  RecordingReporter target;
+  BufferedReporter buffer;
+  for (int i = 0; i < 20; ++i) {
+    Severity sev = Severity(i % OFF);
+    direct.report(sev, Location(), "message");
+    buffer.report(sev, Location(), "message");
+  }
+  EXPECT_EQ(direct.errorCount(), buffer.errorCount());
+  buffer.replay(target);
+  EXPECT_EQ(direct.errorCount(), target.errorCount());
+  EXPECT_EQ(direct.messages, target.messages);
+}
+
+}}
@@ -0,0 +1,92 @@
+/* ================================================================== *
+ * Unit test for spark::parse::ScanKernels
+ * ================================================================== */
+
+#include "gtest/gtest.h"
+#include "spark/parse/scan.h"
+#include <random>
+#include <string>
+#include <vector>
+
+namespace spark {
+namespace parse {
+
+class ScanTest : public testing::Test {
+protected:
+  std::vector<const ScanKernels*> kernels;
+
+  virtual void SetUp() {
+    kernels.push_back(&ScanKernels::scalar());
+    if (ScanKernels::sse2()) {
+      kernels.push_back(ScanKernels::sse2());
+    }
+    if (ScanKernels::avx2()) {
+      kernels.push_back(ScanKernels::avx2());
+    }
+  }
+
+  /** Random text drawn mostly from the characters the kernels look for. */
+  std::string randomText(std::mt19937& rng, size_t length) {
+    static const char alphabet[] = "   \t\t\b**//\r\n\n\nab";
+    std::uniform_int_distribution<size_t> pick(0, sizeof(alphabet) - 2);
+    std::string result;
+    for (size_t i = 0; i < length; ++i) {
+      result.push_back(alphabet[pick(rng)]);
+    }
+    return result;
+  }
+};
+
+TEST_F(ScanTest, SkipSpace) {
+  std::string text = std::string(40, ' ') + "\t\b x";
+  for (const ScanKernels* k : kernels) {
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    EXPECT_EQ(end - 1, k->skipSpace(begin, end)) << k->name;
+    EXPECT_EQ(end - 5, k->skipSpace(begin, end - 5)) << k->name;
+    EXPECT_EQ(end - 1, k->skipSpace(end - 1, end)) << k->name;
+  }
+}
+
+TEST_F(ScanTest, FindLineEnd) {
+  std::string text = std::string(50, 'a') + "\r\n" + std::string(20, 'b');
+  for (const ScanKernels* k : kernels) {
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    EXPECT_EQ(begin + 50, k->findLineEnd(begin, end)) << k->name;
+    EXPECT_EQ(begin + 51, k->findLineEnd(begin + 51, end)) << k->name;
+    EXPECT_EQ(end, k->findLineEnd(begin + 52, end)) << k->name;
+  }
+}
+
+TEST_F(ScanTest, FindCommentEnd) {
+  // A '*' at the end of one 16- and 32-byte block, and a '/' at the start of the next.
+  std::string text = std::string(31, 'a') + "*/" + std::string(20, '*') + "\r\n*/";
+  for (const ScanKernels* k : kernels) {
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    EXPECT_EQ(begin + 31, k->findCommentEnd(begin, end)) << k->name;
+    EXPECT_EQ(end - 2, k->findCommentEnd(begin + 32, end)) << k->name;
+    EXPECT_EQ(end - 1, k->findCommentEnd(begin + 32, end - 1)) << k->name;
+  }
+}
+
+TEST_F(ScanTest, MatchesScalar) {
+  std::mt19937 rng(12345);
+  const ScanKernels& ref = ScanKernels::scalar();
+  for (int trial = 0; trial < 2000; ++trial) {
+    std::string text = randomText(rng, trial % 150);
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    for (const ScanKernels* k : kernels) {
+      for (size_t offset = 0; offset < text.size(); offset += 7) {
+        const char* pos = begin + offset;
+        EXPECT_EQ(ref.skipSpace(pos, end), k->skipSpace(pos, end)) << k->name;
+        EXPECT_EQ(ref.findLineEnd(pos, end), k->findLineEnd(pos, end)) << k->name;
+        EXPECT_EQ(ref.findCommentEnd(pos, end), k->findCommentEnd(pos, end)) << k->name;
+      }
+    }
+  }
+}
+
+}}
@@ -0,0 +1,83 @@
+/* ================================================================== *
+ * Unit test for spark::support::ScratchStack
+ * ================================================================== */
+
+#include "gtest/gtest.h"
+#include "spark/support/arraybuilder.h"
+#include "spark/support/scratchstack.h"
+
+namespace spark {
+namespace support {
+
+TEST(ScratchStackTest, Nested) {
+  Arena arena;
+  ScratchStack& stack = ScratchStack::current();
+  size_t base = stack.used();
+  {
+    ArrayBuilder<int> outer(arena);
+    outer.append(1).append(2);
+    {
+      ArrayBuilder<int> inner(arena, { 10, 11, 12 });
+      EXPECT_EQ(3u, inner.size());
+      EXPECT_EQ(11, inner[1]);
+      collections::ArrayRef<int> result = inner.build();
+      ASSERT_EQ(3u, result.size());
+      EXPECT_EQ(12, result[2]);
+    }
+    outer.append(3);
+    collections::ArrayRef<int> result = outer.build();
+    ASSERT_EQ(3u, result.size());
+    EXPECT_EQ(1, result[0]);
+    EXPECT_EQ(3, result[2]);
+  }
+  EXPECT_EQ(base, stack.used());
+}
+
+TEST(ScratchStackTest, Interleaved) {
+  // Appending to a builder that isn't the newest moves it to the top of the stack; the
+  // newer builder must not release that space when it goes away.
+  Arena arena;
+  ScratchStack& stack = ScratchStack::current();
+  size_t base = stack.used();
+  {
+    ArrayBuilder<int> first(arena);
+    first.append(0);
+    {
+      ArrayBuilder<int> second(arena);
+      for (int i = 0; i < 1000; ++i) {
+        first.append(i + 1);
+        second.append(-i);
+      }
+      EXPECT_EQ(1001u, first.size());
+      EXPECT_EQ(1000u, second.size());
+      EXPECT_EQ(-999, second[999]);
+    }
+    {
+      ArrayBuilder<int> third(arena, { 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7 });
+      EXPECT_EQ(17u, third.size());
+    }
+    for (int i = 0; i < 1001; ++i) {
+      ASSERT_EQ(i, first[i]);
+    }
+  }
+  EXPECT_EQ(base, stack.used());
+}
+
+TEST(ScratchStackTest, SteadyState) {
+  // Once the stack has grown to the size needed, building more lists doesn't allocate.
+  Arena arena;
+  ScratchStack& stack = ScratchStack::current();
+  for (int pass = 0; pass < 3; ++pass) {
+    size_t capacity = stack.capacity();
+    ArrayBuilder<long> big(arena);
+    for (int i = 0; i < 100000; ++i) {
+      big.append(i);
+    }
+    EXPECT_EQ(99999, big.build()[99999]);
+    if (pass > 0) {
+      EXPECT_EQ(capacity, stack.capacity());
+    }
+  }
+}
+
+}}
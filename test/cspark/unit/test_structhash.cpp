@@ -0,0 +1,81 @@
+/* ================================================================== *
+ * Unit test for spark::ast::structuralHash and structurallyEqual
+ * ================================================================== */
+
+#include "gtest/gtest.h"
+#include "spark/ast/node.h"
+#include "spark/ast/structhash.h"
+#include "spark/parse/parser.h"
+#include "mocks.h"
+#include <memory>
+#include <vector>
+
+namespace spark {
+namespace ast {
+using spark::error::MockReporter;
+
+class StructHashTest : public testing::Test {
+protected:
+  support::Arena    _arena;
+  MockReporter      _reporter;
+  std::vector<std::unique_ptr<source::StringSource>> _sources;
+
+  Node* parse(Node* (parse::Parser::*parseFunc)(), const char* srctext) {
+    // The AST may refer to the source text, so keep the source alive as long as the arena.
+    _sources.emplace_back(new source::StringSource("test.txt", srctext));
+    parse::Parser parser(_reporter, _sources.back().get(), _arena);
+    return (parser.*parseFunc)();
+  }
+
+  Node* parseExpression(const char* srctext) {
+    return parse(&parse::Parser::expression, srctext);
+  }
+
+  Node* parseType(const char* srctext) {
+    return parse(&parse::Parser::typeExpression, srctext);
+  }
+};
+
+TEST_F(StructHashTest, SpellingsAlike) {
+  // Spellings of the same type expression hash and compare alike, wherever they appear.
+  const char* const alike[][2] = {
+    { "Array[String]", "Array[ String ]" },
+    { "HashMap[Key, Value]", "HashMap[Key,Value]" },
+    { "fn (i32) -> bool", "fn(i32)->bool" },
+    { "const spark.core.Object", "const  spark.core.Object" },
+    { "i32 | String?", "i32|String?" },
+  };
+  for (auto& pair : alike) {
+    Node* a = parseType(pair[0]);
+    Node* b = parseType(pair[1]);
+    ASSERT_TRUE(a != nullptr && b != nullptr);
+    std::size_t ha = 0;
+    std::size_t hb = 0;
+    EXPECT_TRUE(structuralHash(a, ha)) << pair[0];
+    EXPECT_TRUE(structuralHash(b, hb)) << pair[1];
+    EXPECT_EQ(ha, hb) << pair[0];
+    EXPECT_TRUE(structurallyEqual(a, b)) << pair[0];
+  }
+}
+
+TEST_F(StructHashTest, Distinct) {
+  // Type expressions that differ in any part compare unequal.
+  const char* const distinct[] = {
+    "Array[String]", "Array[Array[String]]", "HashMap[String, Key]", "HashMap[Key, String]",
+    "fn (i32) -> bool", "fn (i32)", "fn (i32, i32) -> bool", "core.Object", "Object",
+    "i32", "u32", "String?",
+  };
+  for (const char* a : distinct) {
+    for (const char* b : distinct) {
+      EXPECT_EQ(a == b, structurallyEqual(parseType(a), parseType(b))) << a << " " << b;
+    }
+  }
+}
+
+TEST_F(StructHashTest, NotTypeExpressions) {
+  // Expressions that aren't type expressions can't be hashed.
+  std::size_t h = 0;
+  EXPECT_FALSE(structuralHash(parseExpression("a + 1"), h));
+}
+
+}}